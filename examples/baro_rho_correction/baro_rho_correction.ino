@@ -211,10 +211,13 @@ Variable *calcWaterPress = new Variable(calculateWaterPressure, waterPressureVar
 // Create the function to calculate the "raw" water depth
 // For this, we're using the conversion between mbar and mm pure water at 4°C
 // This calculation gives a final result in mm of water
+// NOTE:  This uses the value of the calculated water pressure variable so the
+// pressure is only calculated once per update
 float calculateWaterDepthRaw(void)
 {
-    float waterDepth = calculateWaterPressure()*10.1972;
-    if (calculateWaterPressure() == -9999) waterDepth = -9999;
+    float waterPressure = calcWaterPress->getValue();
+    float waterDepth = waterPressure*10.1972;
+    if (waterPressure == -9999) waterDepth = -9999;
     // Serial.print(F("'Raw' water depth is "));  // for debugging
     // Serial.println(waterDepth);  // for debugging
     return waterDepth;
@@ -232,6 +235,8 @@ Variable *calcRawDepth = new Variable(calculateWaterDepthRaw,
                                       waterDepthVarUnit,
                                       waterDepthVarCode,
                                       waterDepthUUID);
+// The raw water depth is calculated from the water pressure
+Variable *waterDepthDependencies[] = {calcWaterPress};
 
 // Create the function to calculate the water depth after correcting water density for temperature
 // This calculation gives a final result in mm of water
@@ -239,7 +244,8 @@ float calculateWaterDepthTempCorrected(void)
 {
     const float gravitationalConstant = 9.80665;  // m/s2, meters per second squared
     // First get water pressure in Pa for the calculation: 1 mbar = 100 Pa
-    float waterPressurePa = 100 * calculateWaterPressure();
+    float waterPressure = calcWaterPress->getValue();
+    float waterPressurePa = 100 * waterPressure;
     float waterTempertureC = ms5803Temp->getValue();
     // Converting water depth for the changes of pressure with depth
     // Water density (kg/m3) from equation 6 from JonesHarris1992-NIST-DensityWater.pdf
@@ -252,7 +258,7 @@ float calculateWaterDepthTempCorrected(void)
     // This calculation gives a final result in mm of water
     // from P = rho * g * h
     float rhoDepth = 1000 * waterPressurePa/(waterDensity * gravitationalConstant);
-    if (calculateWaterPressure() == -9999 || waterTempertureC == -9999)
+    if (waterPressure == -9999 || waterTempertureC == -9999)
     {
         rhoDepth = -9999;
     }
@@ -273,6 +279,8 @@ Variable *calcCorrDepth = new Variable(calculateWaterDepthTempCorrected,
                                        rhoDepthVarUnit,
                                        rhoDepthVarCode,
                                        rhoDepthUUID);
+// The temperature corrected depth is calculated from the water pressure and temperature
+Variable *rhoDepthDependencies[] = {calcWaterPress, ms5803Temp};
 
 
 // ==========================================================================
@@ -400,6 +408,11 @@ void setup()
     modem.setModemLED(modemLEDPin);
     dataLogger.setLoggerPins(wakePin, sdCardSSPin, sdCardPwrPin, buttonPin, greenLED);
 
+    // Tell the calculated variables which others they depend on, so each is
+    // calculated once per update, in the right order
+    calcRawDepth->setDependencies(waterDepthDependencies, 1);
+    calcCorrDepth->setDependencies(rhoDepthDependencies, 2);
+
     // Begin the logger
     dataLogger.begin();
 
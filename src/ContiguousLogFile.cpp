@@ -0,0 +1,289 @@
+/*
+ *ContiguousLogFile.cpp
+ *This file is part of the EnviroDIY modular sensors library for Arduino
+ *
+ *Initial library developement done by Sara Damiano (sdamiano@stroudcenter.org).
+ *
+ *This file is for appending to a log file that has been preallocated as one
+ *contiguous block of the SD card.  Because the position of every byte of the
+ *file on the card is known in advance, each append is written straight to
+ *the card's sectors without searching the directory or walking the FAT.
+*/
+
+#include "ContiguousLogFile.h"
+
+
+ContiguousLogFile::ContiguousLogFile()
+{
+    _sd = NULL;
+    _cache = NULL;
+    _dirIndex = 0;
+    _firstBlock = 0;
+    _size = 0;
+    _dataLength = 0;
+    _appendStart = 0;
+    _ready = false;
+    _appending = false;
+    _writeError = false;
+    _blankByte = 0;
+}
+
+
+// This creates a new file of the given size in one contiguous extent
+bool ContiguousLogFile::create(SdFat &sd, File &file, const char *fileName, uint32_t size)
+{
+    _ready = false;
+    _sd = &sd;
+
+    uint32_t endBlock;
+    if (!file.createContiguous(sd.vwd(), fileName, size))
+    {
+        MS_DBG(F("Unable to allocate"), size, F("contiguous bytes for"), fileName);
+        return false;
+    }
+    if (!file.contiguousRange(&_firstBlock, &endBlock))
+    {
+        file.close();
+        return false;
+    }
+    _dirIndex = file.dirIndex();
+    _size = size;
+    _dataLength = 0;
+
+    // Blank the whole file, so the end of the data can be found after a reset.
+    // Erasing takes the card a moment no matter how big the file is, but the
+    // card decides whether erased bytes read back as zeros or ones.  If the
+    // card can't erase the extent (ie, it isn't aligned to the card's erase
+    // blocks), each sector is written over with zeros instead; for a big file
+    // that is a lot of writes, but it's only done once per file.
+    _blankByte = 0;
+    _cache = (uint8_t *)_sd->vol()->cacheClear();
+    if (_cache != NULL && _sd->card()->erase(_firstBlock, endBlock) &&
+        _sd->card()->readBlock(_firstBlock, _cache) &&
+        (_cache[0] == 0x00 || _cache[0] == 0xFF))
+    {
+        _blankByte = _cache[0];
+        MS_DBG(F("Erased"), fileName, F("to"), _blankByte);
+    }
+    else if (!blankFill(0, size))
+    {
+        file.close();
+        return false;
+    }
+
+    MS_DBG(F("Allocated"), size, F("bytes for"), fileName, F("starting at block"),
+           _firstBlock);
+    _ready = true;
+    return true;
+}
+
+
+// This picks up an existing contiguous file after its position was lost
+bool ContiguousLogFile::resume(SdFat &sd, File &file, const char *fileName,
+                               uint32_t headerSize, uint16_t recordSize)
+{
+    _ready = false;
+    _sd = &sd;
+
+    uint32_t endBlock;
+    if (!file.open(sd.vwd(), fileName, O_RDWR)) return false;
+    if (!file.contiguousRange(&_firstBlock, &endBlock) || file.fileSize() == 0)
+    {
+        file.close();
+        return false;
+    }
+    _dirIndex = file.dirIndex();
+    _size = file.fileSize();
+
+    // Search backwards from the end of the file for the last byte of data
+    _cache = (uint8_t *)_sd->vol()->cacheClear();
+    if (_cache == NULL)
+    {
+        file.close();
+        return false;
+    }
+    // The last byte of a file with room left is always blank, so it tells
+    // whether the card erased to zeros or ones.  Anything else means the file
+    // was already cut down to its data (or was never preallocated), so it
+    // has to be appended to the normal way.
+    uint32_t lastBlock = (_size - 1)/SD_BLOCK_SIZE;
+    if (!_sd->card()->readBlock(_firstBlock + lastBlock, _cache))
+    {
+        file.close();
+        return false;
+    }
+    _blankByte = _cache[(_size - 1) % SD_BLOCK_SIZE];
+    if (_blankByte != 0x00 && _blankByte != 0xFF)
+    {
+        MS_DBG(fileName, F("has already been cut down to its data"));
+        file.close();
+        return false;
+    }
+    uint32_t dataEnd = 0;
+    for (uint32_t block = (_size - 1)/SD_BLOCK_SIZE + 1; block > 0 && dataEnd == 0; block--)
+    {
+        if (!_sd->card()->readBlock(_firstBlock + block - 1, _cache))
+        {
+            file.close();
+            return false;
+        }
+        for (uint16_t i = SD_BLOCK_SIZE; i > 0; i--)
+        {
+            if (_cache[i - 1] != _blankByte)
+            {
+                dataEnd = (block - 1)*SD_BLOCK_SIZE + i;
+                break;
+            }
+        }
+    }
+    // The header can end in a zero (ie, the binary header ends with the
+    // terminator of the last string), so never start writing inside it
+    if (dataEnd < headerSize) dataEnd = headerSize;
+    // Make sure a record that happened to end in zeros is kept whole
+    if (recordSize > 1 && dataEnd > headerSize)
+    {
+        uint32_t nRecords = (dataEnd - headerSize + recordSize - 1)/recordSize;
+        dataEnd = headerSize + nRecords*recordSize;
+    }
+    if (dataEnd >= _size)
+    {
+        MS_DBG(fileName, F("has no room left"));
+        file.close();
+        return false;
+    }
+
+    MS_DBG(F("Resuming"), fileName, F("after"), dataEnd, F("bytes"));
+    _dataLength = dataEnd;
+    _ready = true;
+    return true;
+}
+
+
+// This cuts the file down to the data written to it and forgets it
+bool ContiguousLogFile::finish(File &file)
+{
+    if (!_ready) return false;
+    _ready = false;
+    // The directory entry is found by its index, so there's no search
+    if (!file.open(_sd->vwd(), _dirIndex, O_RDWR)) return false;
+    if (!file.truncate(_dataLength))
+    {
+        file.close();
+        return false;
+    }
+    MS_DBG(F("Cut preallocated file down to"), _dataLength, F("bytes"));
+    return true;
+}
+
+
+// This marks the beginning of an append
+bool ContiguousLogFile::beginAppend(void)
+{
+    _appending = false;
+    if (!_ready) return false;
+
+    _cache = (uint8_t *)_sd->vol()->cacheClear();
+    if (_cache == NULL) return false;
+    // Start from what's already in a partly filled sector
+    if (_dataLength % SD_BLOCK_SIZE != 0)
+    {
+        if (!_sd->card()->readBlock(_firstBlock + _dataLength/SD_BLOCK_SIZE, _cache))
+        {
+            return false;
+        }
+    }
+    else memset(_cache, _blankByte, SD_BLOCK_SIZE);
+
+    _appendStart = _dataLength;
+    _appending = true;
+    _writeError = false;
+    return true;
+}
+
+
+// This marks the end of an append, undoing it if anything went wrong
+bool ContiguousLogFile::endAppend(void)
+{
+    if (!_appending) return false;
+    _appending = false;
+
+    // Write out the last, partly filled, sector
+    if (!_writeError && _dataLength % SD_BLOCK_SIZE != 0)
+    {
+        _writeError = !writeCachedBlock(_dataLength/SD_BLOCK_SIZE);
+    }
+    if (_writeError)
+    {
+        MS_DBG(F("Unable to append to preallocated file, undoing"),
+               _dataLength - _appendStart, F("bytes"));
+        blankFill(_appendStart, _dataLength);
+        _dataLength = _appendStart;
+        return false;
+    }
+    return true;
+}
+
+
+// This adds a character to the file
+size_t ContiguousLogFile::write(uint8_t c)
+{
+    if (!_appending || _writeError) return 0;
+    if (_dataLength >= _size)
+    {
+        _writeError = true;
+        return 0;
+    }
+    _cache[_dataLength % SD_BLOCK_SIZE] = c;
+    _dataLength++;
+    // Write out each sector as soon as it's full
+    if (_dataLength % SD_BLOCK_SIZE == 0)
+    {
+        if (!writeCachedBlock(_dataLength/SD_BLOCK_SIZE - 1))
+        {
+            _writeError = true;
+            return 0;
+        }
+        memset(_cache, _blankByte, SD_BLOCK_SIZE);
+    }
+    return 1;
+}
+size_t ContiguousLogFile::write(const uint8_t *buffer, size_t size)
+{
+    size_t n = 0;
+    while (n < size && write(buffer[n]) == 1) n++;
+    return n;
+}
+
+
+// This writes the cached sector to the given sector of the file
+bool ContiguousLogFile::writeCachedBlock(uint32_t fileBlock)
+{
+    return _sd->card()->writeBlock(_firstBlock + fileBlock, _cache);
+}
+
+
+// This blanks part of the file
+bool ContiguousLogFile::blankFill(uint32_t fromByte, uint32_t toByte)
+{
+    if (toByte <= fromByte) return true;
+    _cache = (uint8_t *)_sd->vol()->cacheClear();
+    if (_cache == NULL) return false;
+
+    uint32_t block = fromByte/SD_BLOCK_SIZE;
+    uint32_t lastBlock = (toByte - 1)/SD_BLOCK_SIZE;
+    // Keep the start of a partly blanked first sector
+    if (fromByte % SD_BLOCK_SIZE != 0)
+    {
+        if (!_sd->card()->readBlock(_firstBlock + block, _cache)) return false;
+        memset(&_cache[fromByte % SD_BLOCK_SIZE], _blankByte,
+               SD_BLOCK_SIZE - fromByte % SD_BLOCK_SIZE);
+        if (!writeCachedBlock(block)) return false;
+        block++;
+    }
+    memset(_cache, _blankByte, SD_BLOCK_SIZE);
+    for (; block <= lastBlock; block++)
+    {
+        if (!writeCachedBlock(block)) return false;
+    }
+    return true;
+}
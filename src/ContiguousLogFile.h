@@ -0,0 +1,105 @@
+/*
+ *ContiguousLogFile.h
+ *This file is part of the EnviroDIY modular sensors library for Arduino
+ *
+ *Initial library developement done by Sara Damiano (sdamiano@stroudcenter.org).
+ *
+ *This file is for appending to a log file that has been preallocated as one
+ *contiguous block of the SD card.  Because the position of every byte of the
+ *file on the card is known in advance, each append is written straight to
+ *the card's sectors without searching the directory or walking the FAT.
+*/
+
+// Header Guards
+#ifndef ContiguousLogFile_h
+#define ContiguousLogFile_h
+
+// Debugging Statement
+// #define MS_CONTIGUOUSLOGFILE_DEBUG
+
+#ifdef MS_CONTIGUOUSLOGFILE_DEBUG
+#define MS_DEBUGGING_STD "ContiguousLogFile"
+#endif
+
+// Included Dependencies
+#include "ModSensorDebugger.h"
+#undef MS_DEBUGGING_STD
+#include <SdFat.h>
+
+// The size of a sector ("block") on the SD card
+#define SD_BLOCK_SIZE 512
+
+
+// This is a stream that appends everything printed to it to a preallocated
+// file, between beginAppend() and endAppend().  The unused end of the file is
+// erased (or, if the card can't, zero-filled) when it's created and the file
+// is cut down to the data written into it by finish(), so until then the file
+// ends with a run of blank bytes (all 0x00 or all 0xFF, depending on what the
+// card erases to).
+// The position is kept in RAM, so it is remembered through sleep.  After a
+// reset, resume() finds the end of the data again by looking for the blank
+// bytes.
+class ContiguousLogFile : public Stream
+{
+public:
+    ContiguousLogFile();
+
+    // This creates a new file of the given size in one contiguous extent
+    bool create(SdFat &sd, File &file, const char *fileName, uint32_t size);
+    // This picks up an existing contiguous file after its position was lost
+    // If the data can only end on certain boundaries (ie, binary records
+    // after a header), give the size of the header and of each record so a
+    // record ending in zeros isn't cut short.
+    // Returns false if the file isn't contiguous, has no room left, or has
+    // already been cut down to its data by finish().
+    bool resume(SdFat &sd, File &file, const char *fileName,
+                uint32_t headerSize = 0, uint16_t recordSize = 1);
+    // This cuts the file down to the data written to it and forgets it
+    // All of these leave the file open on success, ie, to set timestamps.
+    bool finish(File &file);
+
+    // This checks if there is a file with a known position to append to
+    bool isReady(void){return _ready;}
+    // These get how much of the file has been used and how much is left
+    uint32_t getDataLength(void){return _dataLength;}
+    uint32_t getFree(void){return _ready ? _size - _dataLength : 0;}
+
+    // These mark the beginning and the end of an append
+    // endAppend() returns false if anything couldn't be written, in which case
+    // the whole append is undone.
+    // NOTE:  The card's shared sector cache is used as a buffer, so nothing
+    // else may be done with the SD card between them.
+    bool beginAppend(void);
+    bool endAppend(void);
+
+    // These are the required functions of a stream
+    // Nothing can be read back out as a stream.
+    virtual size_t write(uint8_t c);
+    virtual size_t write(const uint8_t *buffer, size_t size);
+    using Print::write;
+    virtual int available(void){return 0;}
+    virtual int read(void){return -1;}
+    virtual int peek(void){return -1;}
+    virtual void flush(void){}
+
+protected:
+    // This writes the cached sector to the given sector of the file
+    bool writeCachedBlock(uint32_t fileBlock);
+    // This blanks part of the file
+    bool blankFill(uint32_t fromByte, uint32_t toByte);
+
+    SdFat *_sd;
+    uint8_t *_cache;
+    uint16_t _dirIndex;
+    uint32_t _firstBlock;
+    uint32_t _size;
+    uint32_t _dataLength;
+    uint32_t _appendStart;
+    bool _ready;
+    bool _appending;
+    bool _writeError;
+    // What the card's blank bytes read as, either 0x00 or 0xFF
+    uint8_t _blankByte;
+};
+
+#endif  // Header Guard
@@ -0,0 +1,88 @@
+/*
+ *LogBuffer.cpp
+ *This file is part of the EnviroDIY modular sensors library for Arduino
+ *
+ *Initial library developement done by Sara Damiano (sdamiano@stroudcenter.org).
+ *
+ *This file is for a buffer in RAM holding records to be written to the SD
+ *card together, so that the card only has to be powered and the file opened
+ *once for several records.
+*/
+
+#include "LogBuffer.h"
+
+
+LogBuffer::LogBuffer()
+{
+    _buffer = NULL;
+    _bufferSize = 0;
+    clear();
+}
+
+
+// This sets the array the records are kept in and empties it
+void LogBuffer::begin(uint8_t buffer[], uint16_t bufferSize)
+{
+    _buffer = buffer;
+    _bufferSize = bufferSize;
+    clear();
+}
+
+
+// This empties the buffer
+void LogBuffer::clear(void)
+{
+    _length = 0;
+    _recordStart = 0;
+    _recordCount = 0;
+    _overflowed = false;
+}
+
+
+// This marks the beginning of a record
+void LogBuffer::startRecord(void)
+{
+    _recordStart = _length;
+    _overflowed = false;
+}
+
+
+// This marks the end of a record, removing it if it didn't fit
+bool LogBuffer::endRecord(void)
+{
+    if (_overflowed)
+    {
+        MS_DBG(F("Record did not fit in the log buffer;"), _length - _recordStart,
+               F("of"), _bufferSize, F("bytes were used"));
+        _length = _recordStart;
+        _overflowed = false;
+        return false;
+    }
+    _recordCount++;
+    return true;
+}
+
+
+// This adds a character to the buffer, if there's room for it
+size_t LogBuffer::write(uint8_t c)
+{
+    if (_length >= _bufferSize)
+    {
+        _overflowed = true;
+        return 0;
+    }
+    _buffer[_length++] = c;
+    return 1;
+}
+size_t LogBuffer::write(const uint8_t *buffer, size_t size)
+{
+    size_t room = _bufferSize - _length;
+    if (size > room)
+    {
+        _overflowed = true;
+        size = room;
+    }
+    memcpy(&_buffer[_length], buffer, size);
+    _length += size;
+    return size;
+}
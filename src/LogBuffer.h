@@ -0,0 +1,75 @@
+/*
+ *LogBuffer.h
+ *This file is part of the EnviroDIY modular sensors library for Arduino
+ *
+ *Initial library developement done by Sara Damiano (sdamiano@stroudcenter.org).
+ *
+ *This file is for a buffer in RAM holding records to be written to the SD
+ *card together, so that the card only has to be powered and the file opened
+ *once for several records.
+*/
+
+// Header Guards
+#ifndef LogBuffer_h
+#define LogBuffer_h
+
+// Debugging Statement
+// #define MS_LOGBUFFER_DEBUG
+
+#ifdef MS_LOGBUFFER_DEBUG
+#define MS_DEBUGGING_STD "LogBuffer"
+#endif
+
+// Included Dependencies
+#include "ModSensorDebugger.h"
+#undef MS_DEBUGGING_STD
+
+
+// This is a stream that saves everything printed to it into a user-supplied
+// byte array.  Records are printed into it with the same functions used to
+// print them to a file, between startRecord() and endRecord().  A record that
+// doesn't fit is removed again, so the buffer only ever holds whole records.
+class LogBuffer : public Stream
+{
+public:
+    LogBuffer();
+
+    // This sets the array the records are kept in and empties it
+    void begin(uint8_t buffer[], uint16_t bufferSize);
+    // This checks if there is an array to keep records in
+    bool isEnabled(void){return _buffer != NULL && _bufferSize > 0;}
+
+    // These mark the beginning and the end of a record
+    // endRecord() returns false if the record didn't fit, in which case it
+    // has been removed from the buffer.
+    void startRecord(void);
+    bool endRecord(void);
+
+    // This empties the buffer
+    void clear(void);
+
+    // These get the buffer contents and how many records are in it
+    const uint8_t *getData(void){return _buffer;}
+    uint16_t getLength(void){return _length;}
+    uint8_t getRecordCount(void){return _recordCount;}
+
+    // These are the required functions of a stream
+    // Nothing can be read back out as a stream.
+    virtual size_t write(uint8_t c);
+    virtual size_t write(const uint8_t *buffer, size_t size);
+    using Print::write;
+    virtual int available(void){return 0;}
+    virtual int read(void){return -1;}
+    virtual int peek(void){return -1;}
+    virtual void flush(void){}
+
+private:
+    uint8_t *_buffer;
+    uint16_t _bufferSize;
+    uint16_t _length;
+    uint16_t _recordStart;
+    uint8_t _recordCount;
+    bool _overflowed;
+};
+
+#endif  // Header Guard
@@ -0,0 +1,230 @@
+/*
+ *LogJournal.cpp
+ *This file is part of the EnviroDIY modular sensors library for Arduino
+ *
+ *Initial library developement done by Sara Damiano (sdamiano@stroudcenter.org).
+ *
+ *This file is for a journal on the SD card that lets a record that was only
+ *partly appended to a log file (ie, because the power failed) be repaired.
+*/
+
+#include "LogJournal.h"
+
+// The size of the fixed fields at the start of the journal
+#define JOURNAL_HEADER_SIZE 18
+// The number of bytes copied at a time
+#define JOURNAL_COPY_CHUNK 32
+
+
+LogJournal::LogJournal()
+{
+    _sequenceNumber = 0;
+    _logFileSize = 0;
+    _dataLength = 0;
+    _crc = 0xFFFF;
+    _nameLength = 0;
+    _writeError = false;
+}
+
+
+// This is a CRC-16-CCITT, calculated bit by bit to keep it small
+uint16_t LogJournal::crc16Update(uint16_t crc, uint8_t data)
+{
+    crc ^= (uint16_t)data << 8;
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        if (crc & 0x8000) crc = (crc << 1) ^ 0x1021;
+        else crc <<= 1;
+    }
+    return crc;
+}
+
+
+// This writes the fixed fields at the start of the journal
+bool LogJournal::writeHeader(uint8_t state)
+{
+    uint8_t header[JOURNAL_HEADER_SIZE] = {'M', 'S', 'J', '1'};
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        header[4 + i] = (uint8_t)(_sequenceNumber >> (8*i));
+        header[8 + i] = (uint8_t)(_logFileSize >> (8*i));
+    }
+    header[12] = (uint8_t)(_dataLength & 0xFF);
+    header[13] = (uint8_t)(_dataLength >> 8);
+    header[14] = (uint8_t)(_crc & 0xFF);
+    header[15] = (uint8_t)(_crc >> 8);
+    header[16] = state;
+    header[17] = _nameLength;
+    if (!_file.seekSet(0)) return false;
+    return _file.write(header, JOURNAL_HEADER_SIZE) == JOURNAL_HEADER_SIZE;
+}
+
+
+// This reads the fixed fields at the start of the journal
+bool LogJournal::readHeader(uint8_t *state)
+{
+    uint8_t header[JOURNAL_HEADER_SIZE];
+    if (!_file.seekSet(0)) return false;
+    if (_file.read(header, JOURNAL_HEADER_SIZE) != JOURNAL_HEADER_SIZE) return false;
+    if (memcmp(header, "MSJ1", 4) != 0) return false;
+    _sequenceNumber = 0;
+    _logFileSize = 0;
+    for (uint8_t i = 4; i > 0; i--)
+    {
+        _sequenceNumber = (_sequenceNumber << 8) | header[3 + i];
+        _logFileSize = (_logFileSize << 8) | header[7 + i];
+    }
+    _dataLength = header[12] | ((uint16_t)header[13] << 8);
+    _crc = header[14] | ((uint16_t)header[15] << 8);
+    *state = header[16];
+    _nameLength = header[17];
+    return true;
+}
+
+
+// This starts a new entry for data to be appended to the given log file
+bool LogJournal::beginEntry(SdFat &sd, const char *logFileName, uint32_t logFileSize)
+{
+    _writeError = true;
+    size_t nameLength = strlen(logFileName);
+    if (nameLength > MS_JOURNAL_MAX_NAME_LENGTH)
+    {
+        MS_DBG(F("Log file name is too long for the journal:"), logFileName);
+        return false;
+    }
+    if (!_file.open(sd.vwd(), MS_JOURNAL_FILE_NAME, O_RDWR | O_CREAT))
+    {
+        MS_DBG(F("Unable to open the journal"));
+        return false;
+    }
+
+    _sequenceNumber++;
+    _logFileSize = logFileSize;
+    _dataLength = 0;
+    _crc = 0xFFFF;
+    _nameLength = nameLength;
+    if (!writeHeader(JOURNAL_ENTRY_WRITING) ||
+        _file.write((const uint8_t *)logFileName, _nameLength) != _nameLength)
+    {
+        _file.close();
+        return false;
+    }
+    _writeError = false;
+    return true;
+}
+
+
+// This adds data to the entry
+size_t LogJournal::write(uint8_t c)
+{
+    if (_writeError) return 0;
+    if (_dataLength == 0xFFFF || _file.write(c) != 1)
+    {
+        _writeError = true;
+        return 0;
+    }
+    _crc = crc16Update(_crc, c);
+    _dataLength++;
+    return 1;
+}
+size_t LogJournal::write(const uint8_t *buffer, size_t size)
+{
+    size_t n = 0;
+    while (n < size && write(buffer[n]) == 1) n++;
+    return n;
+}
+
+
+// This finishes writing the data into the entry and marks it pending
+bool LogJournal::commitEntry(void)
+{
+    if (_writeError || !writeHeader(JOURNAL_ENTRY_PENDING) || !_file.sync())
+    {
+        MS_DBG(F("Unable to write entry"), _sequenceNumber, F("to the journal"));
+        _file.close();
+        return false;
+    }
+    MS_DBG(F("Journal entry"), _sequenceNumber, F("has"), _dataLength,
+           F("bytes for a file of"), _logFileSize, F("bytes"));
+    return true;
+}
+
+
+// This copies the data of the pending entry onto the end of an open file
+bool LogJournal::copyEntryTo(File &file)
+{
+    uint8_t chunk[JOURNAL_COPY_CHUNK];
+    if (!_file.seekSet(JOURNAL_HEADER_SIZE + _nameLength)) return false;
+    uint16_t remaining = _dataLength;
+    while (remaining > 0)
+    {
+        uint16_t n = remaining < JOURNAL_COPY_CHUNK ? remaining : JOURNAL_COPY_CHUNK;
+        if (_file.read(chunk, n) != n) return false;
+        if (file.write(chunk, n) != n) return false;
+        remaining -= n;
+    }
+    return file.sync();
+}
+
+
+// This marks the pending entry as applied and closes the journal
+bool LogJournal::markApplied(void)
+{
+    bool success = writeHeader(JOURNAL_ENTRY_APPLIED) && _file.sync();
+    _file.close();
+    return success;
+}
+
+
+// This checks the journal for an entry that may not have been applied
+bool LogJournal::findPendingEntry(SdFat &sd, char *logFileName,
+                                  uint8_t nameBufferSize, uint32_t *logFileSize)
+{
+    if (!sd.exists(MS_JOURNAL_FILE_NAME)) return false;
+    if (!_file.open(sd.vwd(), MS_JOURNAL_FILE_NAME, O_RDWR)) return false;
+
+    uint8_t state;
+    if (!readHeader(&state))
+    {
+        MS_DBG(F("Journal is unreadable"));
+        _file.close();
+        return false;
+    }
+    // If the entry never made it to pending, the log file wasn't touched
+    if (state != JOURNAL_ENTRY_PENDING || _nameLength >= nameBufferSize)
+    {
+        MS_DBG(F("Last journal entry"), _sequenceNumber, F("is complete"));
+        _file.close();
+        return false;
+    }
+    if (_file.read(logFileName, _nameLength) != _nameLength)
+    {
+        _file.close();
+        return false;
+    }
+    logFileName[_nameLength] = '\0';
+
+    // Check the data, in case the pending mark was saved but not all of the
+    // data was.  The log file wasn't touched until it all was.
+    uint8_t chunk[JOURNAL_COPY_CHUNK];
+    uint16_t crc = 0xFFFF;
+    uint16_t remaining = _dataLength;
+    while (remaining > 0)
+    {
+        uint16_t n = remaining < JOURNAL_COPY_CHUNK ? remaining : JOURNAL_COPY_CHUNK;
+        if (_file.read(chunk, n) != n) break;
+        for (uint16_t i = 0; i < n; i++) crc = crc16Update(crc, chunk[i]);
+        remaining -= n;
+    }
+    if (remaining > 0 || crc != _crc)
+    {
+        MS_DBG(F("Journal entry"), _sequenceNumber, F("is torn; ignoring it"));
+        _file.close();
+        return false;
+    }
+
+    *logFileSize = _logFileSize;
+    MS_DBG(F("Journal entry"), _sequenceNumber, F("for"), logFileName,
+           F("may not have been applied"));
+    return true;
+}
@@ -0,0 +1,111 @@
+/*
+ *LogJournal.h
+ *This file is part of the EnviroDIY modular sensors library for Arduino
+ *
+ *Initial library developement done by Sara Damiano (sdamiano@stroudcenter.org).
+ *
+ *This file is for a journal on the SD card that lets a record that was only
+ *partly appended to a log file (ie, because the power failed) be repaired.
+*/
+
+// Header Guards
+#ifndef LogJournal_h
+#define LogJournal_h
+
+// Debugging Statement
+// #define MS_LOGJOURNAL_DEBUG
+
+#ifdef MS_LOGJOURNAL_DEBUG
+#define MS_DEBUGGING_STD "LogJournal"
+#endif
+
+// Included Dependencies
+#include "ModSensorDebugger.h"
+#undef MS_DEBUGGING_STD
+#include <SdFat.h>
+
+// The name of the journal file on the SD card
+#ifndef MS_JOURNAL_FILE_NAME
+#define MS_JOURNAL_FILE_NAME "JOURNAL.MSJ"
+#endif
+
+// The longest log file name the journal can hold
+#define MS_JOURNAL_MAX_NAME_LENGTH 64
+
+// The states of the entry in the journal
+#define JOURNAL_ENTRY_WRITING 'W'  // The entry is incomplete; the log file is untouched
+#define JOURNAL_ENTRY_PENDING 'P'  // The entry is complete; it may be partly in the log file
+#define JOURNAL_ENTRY_APPLIED 'C'  // The entry is completely in the log file
+
+
+// This is a write-ahead journal holding a single entry:  the data about to be
+// appended to a log file, along with the name and size of the log file before
+// the append, a sequence number, and a CRC.  Each append is:
+//   1. Write the data into the journal, then mark the entry pending and sync
+//   2. Copy the data from the journal onto the end of the log file and sync
+//   3. Mark the entry applied and sync
+// If the power fails during step 2, the entry is still pending at the next
+// start up; the log file is cut back to its earlier size and the data is
+// copied in again.  If the power fails during step 1, the log file has not
+// been touched.  Because the journal only ever holds the last append, checking
+// it takes the same short time no matter how big the log files are.
+// The journal is written through the stream functions between beginEntry()
+// and commitEntry().
+//
+// The journal is laid out as (little-endian):
+//   "MSJ1", sequence number (4 bytes), log file size before the append (4),
+//   data length (2), CRC-16 of the data (2), state (1), name length (1),
+//   the log file name, and then the data.
+class LogJournal : public Stream
+{
+public:
+    LogJournal();
+
+    // This starts a new entry for data to be appended to the given log file
+    bool beginEntry(SdFat &sd, const char *logFileName, uint32_t logFileSize);
+    // This finishes writing the data into the entry and marks it pending
+    bool commitEntry(void);
+    // This copies the data of the pending entry onto the end of an open file
+    bool copyEntryTo(File &file);
+    // This marks the pending entry as applied and closes the journal
+    bool markApplied(void);
+    // This closes the journal, leaving the entry as it is
+    void close(void){_file.close();}
+
+    // This checks the journal for an entry that may not have been applied,
+    // getting the name and size of its log file if there is one.  The
+    // journal is left open to copy the entry.
+    bool findPendingEntry(SdFat &sd, char *logFileName, uint8_t nameBufferSize,
+                          uint32_t *logFileSize);
+
+    // This returns the sequence number of the last entry
+    uint32_t getSequenceNumber(void){return _sequenceNumber;}
+
+    // This is a CRC-16-CCITT (polynomial 0x1021, starting from 0xFFFF)
+    static uint16_t crc16Update(uint16_t crc, uint8_t data);
+
+    // These are the required functions of a stream
+    // Nothing can be read back out as a stream.
+    virtual size_t write(uint8_t c);
+    virtual size_t write(const uint8_t *buffer, size_t size);
+    using Print::write;
+    virtual int available(void){return 0;}
+    virtual int read(void){return -1;}
+    virtual int peek(void){return -1;}
+    virtual void flush(void){}
+
+protected:
+    // These write and read the fixed fields at the start of the journal
+    bool writeHeader(uint8_t state);
+    bool readHeader(uint8_t *state);
+
+    File _file;
+    uint32_t _sequenceNumber;
+    uint32_t _logFileSize;
+    uint16_t _dataLength;
+    uint16_t _crc;
+    uint8_t _nameLength;
+    bool _writeError;
+};
+
+#endif  // Header Guard
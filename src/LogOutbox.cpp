@@ -0,0 +1,214 @@
+/*
+ *LogOutbox.cpp
+ *This file is part of the EnviroDIY modular sensors library for Arduino
+ *
+ *Initial library developement done by Sara Damiano (sdamiano@stroudcenter.org).
+ *
+ *This file is for an outbox on the SD card holding records that have not yet
+ *been sent by every data publisher.
+*/
+
+#include "LogOutbox.h"
+#include "LogJournal.h"  // For the CRC
+
+// The size of the cursor file:  the end, the cursors, and the CRC
+#define OUTBOX_CURSOR_FILE_SIZE (4 + 4*MS_OUTBOX_NUM_CURSORS + 2)
+// The size of the fixed fields at the start of each record
+#define OUTBOX_RECORD_HEADER_SIZE 7
+
+
+LogOutbox::LogOutbox()
+{
+    _loaded = false;
+    _end = 0;
+    for (uint8_t i = 0; i < MS_OUTBOX_NUM_CURSORS; i++) _cursors[i] = 0;
+}
+
+
+// This reads the saved cursors, if they haven't been read yet
+bool LogOutbox::begin(SdFat &sd)
+{
+    if (_loaded) return true;
+
+    uint8_t saved[OUTBOX_CURSOR_FILE_SIZE];
+    if (sd.exists(MS_OUTBOX_CURSOR_FILE_NAME))
+    {
+        if (!_file.open(sd.vwd(), MS_OUTBOX_CURSOR_FILE_NAME, O_READ)) return false;
+        int nRead = _file.read(saved, OUTBOX_CURSOR_FILE_SIZE);
+        _file.close();
+
+        uint16_t crc = 0xFFFF;
+        for (uint8_t i = 0; i < OUTBOX_CURSOR_FILE_SIZE - 2; i++)
+        {
+            crc = LogJournal::crc16Update(crc, saved[i]);
+        }
+        if (nRead == OUTBOX_CURSOR_FILE_SIZE &&
+            crc == (saved[OUTBOX_CURSOR_FILE_SIZE - 2] |
+                    ((uint16_t)saved[OUTBOX_CURSOR_FILE_SIZE - 1] << 8)))
+        {
+            for (uint8_t c = 0; c <= MS_OUTBOX_NUM_CURSORS; c++)
+            {
+                uint32_t value = 0;
+                for (uint8_t i = 4; i > 0; i--) value = (value << 8) | saved[4*c + i - 1];
+                if (c == 0) _end = value;
+                else _cursors[c - 1] = value;
+            }
+            MS_DBG(F("Outbox has"), _end, F("bytes of records"));
+            _loaded = true;
+            return true;
+        }
+        // If the cursors are damaged, it's better to send records again
+        // than to never send them
+        PRINTOUT(F("Outbox cursors are damaged; all records in it will be sent again"));
+    }
+
+    // Without saved cursors, everything in the outbox is unsent
+    _end = 0;
+    if (sd.exists(MS_OUTBOX_FILE_NAME) && _file.open(sd.vwd(), MS_OUTBOX_FILE_NAME, O_READ))
+    {
+        _end = _file.fileSize();
+        _file.close();
+    }
+    for (uint8_t i = 0; i < MS_OUTBOX_NUM_CURSORS; i++) _cursors[i] = 0;
+    _loaded = true;
+    return true;
+}
+
+
+// This adds a record to the end of the outbox
+bool LogOutbox::addRecord(SdFat &sd, uint32_t epochTime, const char *values,
+                          uint16_t valuesLength, uint8_t valueCount)
+{
+    if (!begin(sd)) return false;
+    if (!_file.open(sd.vwd(), MS_OUTBOX_FILE_NAME, O_RDWR | O_CREAT)) return false;
+
+    // Drop anything after the saved end, ie, a record that was cut off
+    if (_file.fileSize() > _end) _file.truncate(_end);
+    // If the file is somehow shorter, the cursors past its end are wrong
+    if (_file.fileSize() < _end)
+    {
+        _end = _file.fileSize();
+        for (uint8_t i = 0; i < MS_OUTBOX_NUM_CURSORS; i++)
+        {
+            if (_cursors[i] > _end) _cursors[i] = _end;
+        }
+    }
+    _file.seekSet(_end);
+
+    uint16_t recordLength = OUTBOX_RECORD_HEADER_SIZE - 2 + valuesLength;
+    uint8_t header[OUTBOX_RECORD_HEADER_SIZE];
+    header[0] = (uint8_t)(recordLength & 0xFF);
+    header[1] = (uint8_t)(recordLength >> 8);
+    for (uint8_t i = 0; i < 4; i++) header[2 + i] = (uint8_t)(epochTime >> (8*i));
+    header[6] = valueCount;
+    bool success = _file.write(header, OUTBOX_RECORD_HEADER_SIZE) == OUTBOX_RECORD_HEADER_SIZE &&
+                   _file.write((const uint8_t *)values, valuesLength) == valuesLength &&
+                   _file.sync();
+    _file.close();
+    if (!success)
+    {
+        MS_DBG(F("Unable to add record to the outbox"));
+        return false;
+    }
+
+    _end += OUTBOX_RECORD_HEADER_SIZE + valuesLength;
+    // The record only counts once the new end is saved
+    return saveCursors(sd, 0);
+}
+
+
+// This opens the outbox for reading records out of it
+bool LogOutbox::openForReading(SdFat &sd)
+{
+    return _file.open(sd.vwd(), MS_OUTBOX_FILE_NAME, O_READ);
+}
+
+
+// This reads the record at a position in the outbox
+uint32_t LogOutbox::readRecord(uint32_t position, uint32_t *epochTime, char *values,
+                               uint16_t valuesBufferSize, uint16_t *valuesLength,
+                               uint8_t *valueCount, bool *isValid)
+{
+    uint8_t header[OUTBOX_RECORD_HEADER_SIZE];
+    *isValid = false;
+    // Nothing past the saved end is part of the outbox
+    if (position + OUTBOX_RECORD_HEADER_SIZE > _end) return _end;
+    if (!_file.seekSet(position)) return 0;
+    if (_file.read(header, OUTBOX_RECORD_HEADER_SIZE) != OUTBOX_RECORD_HEADER_SIZE) return 0;
+
+    // A damaged length can't be used to find the next record, so everything
+    // after it is skipped
+    uint16_t recordLength = header[0] | ((uint16_t)header[1] << 8);
+    uint32_t next = position + 2 + recordLength;
+    if (next > _end) return _end;
+    if (recordLength < OUTBOX_RECORD_HEADER_SIZE - 2) return next;
+    *valuesLength = recordLength - (OUTBOX_RECORD_HEADER_SIZE - 2);
+    if (*valuesLength > valuesBufferSize) return next;
+
+    *epochTime = 0;
+    for (uint8_t i = 4; i > 0; i--) *epochTime = (*epochTime << 8) | header[1 + i];
+    *valueCount = header[6];
+    if (_file.read(values, *valuesLength) != *valuesLength) return 0;
+    *isValid = true;
+    return next;
+}
+
+
+// These get and set the read cursors
+uint32_t LogOutbox::getCursor(uint8_t cursorNum)
+{
+    if (cursorNum >= MS_OUTBOX_NUM_CURSORS) return _end;
+    return _cursors[cursorNum];
+}
+void LogOutbox::setCursor(uint8_t cursorNum, uint32_t position)
+{
+    if (cursorNum < MS_OUTBOX_NUM_CURSORS) _cursors[cursorNum] = position;
+}
+
+
+// This saves the cursors, emptying the outbox once everything has been sent
+bool LogOutbox::saveCursors(SdFat &sd, uint8_t nCursors)
+{
+    bool allSent = nCursors > 0 && _end > 0;
+    for (uint8_t i = 0; i < nCursors && i < MS_OUTBOX_NUM_CURSORS; i++)
+    {
+        if (_cursors[i] < _end) allSent = false;
+    }
+    if (allSent)
+    {
+        MS_DBG(F("Everything in the outbox has been sent; emptying it"));
+        _end = 0;
+        for (uint8_t i = 0; i < MS_OUTBOX_NUM_CURSORS; i++) _cursors[i] = 0;
+    }
+
+    uint8_t saved[OUTBOX_CURSOR_FILE_SIZE];
+    for (uint8_t c = 0; c <= MS_OUTBOX_NUM_CURSORS; c++)
+    {
+        uint32_t value = (c == 0) ? _end : _cursors[c - 1];
+        for (uint8_t i = 0; i < 4; i++) saved[4*c + i] = (uint8_t)(value >> (8*i));
+    }
+    uint16_t crc = 0xFFFF;
+    for (uint8_t i = 0; i < OUTBOX_CURSOR_FILE_SIZE - 2; i++)
+    {
+        crc = LogJournal::crc16Update(crc, saved[i]);
+    }
+    saved[OUTBOX_CURSOR_FILE_SIZE - 2] = (uint8_t)(crc & 0xFF);
+    saved[OUTBOX_CURSOR_FILE_SIZE - 1] = (uint8_t)(crc >> 8);
+
+    // The file never changes size, so this only rewrites its one sector
+    if (!_file.open(sd.vwd(), MS_OUTBOX_CURSOR_FILE_NAME, O_RDWR | O_CREAT)) return false;
+    _file.seekSet(0);
+    bool success = _file.write(saved, OUTBOX_CURSOR_FILE_SIZE) == OUTBOX_CURSOR_FILE_SIZE &&
+                   _file.sync();
+    _file.close();
+
+    // Only empty the outbox once the new end is saved.  If the power fails
+    // before it's emptied, the old records are past the saved end, so they
+    // are dropped when the next record is added anyway.
+    if (allSent && success && _file.open(sd.vwd(), MS_OUTBOX_FILE_NAME, O_RDWR))
+    {
+        _file.truncate(0);
+        _file.close();
+    }
+    return success;
+}
@@ -0,0 +1,92 @@
+/*
+ *LogOutbox.h
+ *This file is part of the EnviroDIY modular sensors library for Arduino
+ *
+ *Initial library developement done by Sara Damiano (sdamiano@stroudcenter.org).
+ *
+ *This file is for an outbox on the SD card holding records that have not yet
+ *been sent by every data publisher.
+*/
+
+// Header Guards
+#ifndef LogOutbox_h
+#define LogOutbox_h
+
+// Debugging Statement
+// #define MS_LOGOUTBOX_DEBUG
+
+#ifdef MS_LOGOUTBOX_DEBUG
+#define MS_DEBUGGING_STD "LogOutbox"
+#endif
+
+// Included Dependencies
+#include "ModSensorDebugger.h"
+#undef MS_DEBUGGING_STD
+#include <SdFat.h>
+
+// The names of the outbox files on the SD card
+#ifndef MS_OUTBOX_FILE_NAME
+#define MS_OUTBOX_FILE_NAME "OUTBOX.MSO"
+#endif
+#ifndef MS_OUTBOX_CURSOR_FILE_NAME
+#define MS_OUTBOX_CURSOR_FILE_NAME "OUTBOX.MSC"
+#endif
+
+// The number of read cursors, one for each data publisher
+// This must be at least MAX_NUMBER_SENDERS.
+#define MS_OUTBOX_NUM_CURSORS 4
+
+
+// This is a queue of records kept on the SD card.  Each record is added to
+// the end of the outbox file once, and each publisher has its own read cursor
+// (the position in the file of the first record it hasn't sent yet).  The
+// cursors and the end of the data are saved in a second small file, with a
+// CRC, every time they change, so they survive resets.  Anything past the
+// saved end (ie, a record cut off by a power failure) is dropped before the
+// next record is added.  Once every cursor has reached the end, both files
+// are emptied so the outbox doesn't keep growing.
+//
+// Each record in the outbox is (little-endian):
+//   the length of the rest of the record (2 bytes), the marked time (4), the
+//   number of values (1), and the formatted values, each null terminated.
+class LogOutbox
+{
+public:
+    LogOutbox();
+
+    // This reads the saved cursors, if they haven't been read yet
+    bool begin(SdFat &sd);
+
+    // This adds a record to the end of the outbox
+    bool addRecord(SdFat &sd, uint32_t epochTime, const char *values,
+                   uint16_t valuesLength, uint8_t valueCount);
+
+    // These open and close the outbox for reading records out of it
+    bool openForReading(SdFat &sd);
+    void close(void){_file.close();}
+    // This reads the record at a position in the outbox, returning the
+    // position of the next record, or 0 if the card couldn't be read.
+    // If the record itself can't be used (ie, it's too long for the values
+    // buffer), isValid is set false and the position after it is returned,
+    // so it can be skipped.
+    uint32_t readRecord(uint32_t position, uint32_t *epochTime, char *values,
+                        uint16_t valuesBufferSize, uint16_t *valuesLength,
+                        uint8_t *valueCount, bool *isValid);
+
+    // These get and set the read cursors
+    // Changed cursors must be saved with saveCursors()
+    uint32_t getCursor(uint8_t cursorNum);
+    void setCursor(uint8_t cursorNum, uint32_t position);
+    uint32_t getEnd(void){return _end;}
+    // This saves the cursors, first emptying the outbox if every one of
+    // the first nCursors cursors is at the end
+    bool saveCursors(SdFat &sd, uint8_t nCursors);
+
+protected:
+    File _file;
+    bool _loaded;
+    uint32_t _end;
+    uint32_t _cursors[MS_OUTBOX_NUM_CURSORS];
+};
+
+#endif  // Header Guard
@@ -60,6 +60,23 @@ Logger::Logger(const char *loggerID, uint16_t loggingIntervalMinutes,
 
     // Initialize with no file name
     _fileName = "";
+    _autoFileName = false;
+    _logFileFormat = LOG_FORMAT_CSV;
+
+    // Records are written to the SD card immediately unless a buffer is set
+    _recordsPerWrite = 1;
+    _maxBufferAgeSeconds = 0;
+    _firstBufferedEpoch = 0;
+    _lowBatteryVar = NULL;
+    _lowBatteryVoltage = 0;
+
+    // Files are not preallocated unless a size is given
+    _preallocatedFileSize = 0;
+    _contiguousFileName = "";
+
+    // Appends are not journaled unless asked for
+    _journaling = false;
+    _journalNeedsRecovery = false;
 
     // Start with no feature UUID
     _samplingFeatureUUID = NULL;
@@ -70,6 +87,20 @@ Logger::Logger(const char *loggerID, uint16_t loggingIntervalMinutes,
         dataPublishers[i] = NULL;
     }
 
+    // There is no record yet
+    _recordValid = false;
+    _recordEpochTime = 0;
+    _recordValues = NULL;
+    _recordBufferSize = 0;
+    _recordVarCount = 0;
+    _recordValuesLength = 0;
+    _recordIsReplay = false;
+
+    // Records aren't kept in an outbox unless asked for
+    _outboxEnabled = false;
+    _outboxMaxRecords = MS_OUTBOX_MAX_RECORDS;
+    _outboxMaxMillis = MS_OUTBOX_MAX_MILLIS;
+
     // MS_DBG(F("Logger object created"));
 }
 Logger::Logger(const char *loggerID, uint16_t loggingIntervalMinutes,
@@ -94,6 +125,23 @@ Logger::Logger(const char *loggerID, uint16_t loggingIntervalMinutes,
 
     // Initialize with no file name
     _fileName = "";
+    _autoFileName = false;
+    _logFileFormat = LOG_FORMAT_CSV;
+
+    // Records are written to the SD card immediately unless a buffer is set
+    _recordsPerWrite = 1;
+    _maxBufferAgeSeconds = 0;
+    _firstBufferedEpoch = 0;
+    _lowBatteryVar = NULL;
+    _lowBatteryVoltage = 0;
+
+    // Files are not preallocated unless a size is given
+    _preallocatedFileSize = 0;
+    _contiguousFileName = "";
+
+    // Appends are not journaled unless asked for
+    _journaling = false;
+    _journalNeedsRecovery = false;
 
     // Start with no feature UUID
     _samplingFeatureUUID = NULL;
@@ -104,6 +152,20 @@ Logger::Logger(const char *loggerID, uint16_t loggingIntervalMinutes,
         dataPublishers[i] = NULL;
     }
 
+    // There is no record yet
+    _recordValid = false;
+    _recordEpochTime = 0;
+    _recordValues = NULL;
+    _recordBufferSize = 0;
+    _recordVarCount = 0;
+    _recordValuesLength = 0;
+    _recordIsReplay = false;
+
+    // Records aren't kept in an outbox unless asked for
+    _outboxEnabled = false;
+    _outboxMaxRecords = MS_OUTBOX_MAX_RECORDS;
+    _outboxMaxMillis = MS_OUTBOX_MAX_MILLIS;
+
     // MS_DBG(F("Logger object created"));
 }
 Logger::Logger()
@@ -122,6 +184,23 @@ Logger::Logger()
 
     // Initialize with no file name
     _fileName = "";
+    _autoFileName = false;
+    _logFileFormat = LOG_FORMAT_CSV;
+
+    // Records are written to the SD card immediately unless a buffer is set
+    _recordsPerWrite = 1;
+    _maxBufferAgeSeconds = 0;
+    _firstBufferedEpoch = 0;
+    _lowBatteryVar = NULL;
+    _lowBatteryVoltage = 0;
+
+    // Files are not preallocated unless a size is given
+    _preallocatedFileSize = 0;
+    _contiguousFileName = "";
+
+    // Appends are not journaled unless asked for
+    _journaling = false;
+    _journalNeedsRecovery = false;
 
     // Start with no feature UUID
     _samplingFeatureUUID = NULL;
@@ -132,6 +211,20 @@ Logger::Logger()
         dataPublishers[i] = NULL;
     }
 
+    // There is no record yet
+    _recordValid = false;
+    _recordEpochTime = 0;
+    _recordValues = NULL;
+    _recordBufferSize = 0;
+    _recordVarCount = 0;
+    _recordValuesLength = 0;
+    _recordIsReplay = false;
+
+    // Records aren't kept in an outbox unless asked for
+    _outboxEnabled = false;
+    _outboxMaxRecords = MS_OUTBOX_MAX_RECORDS;
+    _outboxMaxMillis = MS_OUTBOX_MAX_MILLIS;
+
     // MS_DBG(F("Logger object created"));
 }
 // Destructor
@@ -343,6 +436,93 @@ String Logger::getValueStringAtI(uint8_t position_i)
 {
     return _internalArray->arrayOfVars[position_i]->getValueString();
 }
+// This writes the current value of the variable into a character buffer
+// If the value is in the snapshot for the marked time, it's copied from there.
+uint8_t Logger::formatValueAtI(uint8_t position_i, char *buffer, uint8_t bufferSize)
+{
+    if (_recordValid && _recordEpochTime == Logger::markedEpochTime &&
+        position_i < _recordVarCount && bufferSize > 0)
+    {
+        const char *value = getRecordValue(position_i);
+        uint8_t len = strlen(value);
+        if (len > bufferSize - 1) len = bufferSize - 1;
+        memcpy(buffer, value, len);
+        buffer[len] = '\0';
+        return len;
+    }
+    // An old record from the outbox can't be filled in from the variables
+    if (_recordIsReplay && _recordEpochTime == Logger::markedEpochTime)
+    {
+        return Variable::formatFloat(-9999, 0, buffer, bufferSize);
+    }
+    return _internalArray->arrayOfVars[position_i]->formatValue(buffer, bufferSize);
+}
+
+
+// This sets the buffer for the snapshot of the formatted values
+void Logger::setRecordBuffer(char buffer[], uint16_t bufferSize)
+{
+    _recordValues = buffer;
+    _recordBufferSize = buffer != NULL ? bufferSize : 0;
+    _recordValid = false;
+}
+
+
+// This takes a snapshot of the marked time and all of the formatted values
+void Logger::buildRecord(void)
+{
+    _recordIsReplay = false;
+    _recordEpochTime = Logger::markedEpochTime;
+    _recordValid = false;
+    if (_recordBufferSize == 0) return;
+
+    // Add each value to the buffer until it's full
+    uint16_t position = 0;
+    _recordVarCount = 0;
+    _recordValuesLength = 0;
+    for (uint8_t i = 0; i < getArrayVarCount(); i++)
+    {
+        uint16_t room = _recordBufferSize - position;
+        if (room > VALUE_STRING_BUFFER_SIZE) room = VALUE_STRING_BUFFER_SIZE;
+        if (room == 0) break;
+        uint8_t len = _internalArray->arrayOfVars[i]->formatValue(
+            &_recordValues[position], room);
+        // If the value filled up the space it had, it may have been cut off
+        // and the rest of the values will have to be formatted as needed
+        if (len + 1 >= room && room < VALUE_STRING_BUFFER_SIZE) break;
+        position += len + 1;
+        _recordValuesLength += len;
+        _recordVarCount++;
+    }
+    _recordValid = true;
+    MS_DBG(F("Record built with"), _recordVarCount, F("of"), getArrayVarCount(),
+           F("values using"), position, F("bytes"));
+}
+
+
+// Protected helper function - This finds a value in the snapshot by stepping
+// over the ones before it
+const char *Logger::getRecordValue(uint8_t position_i)
+{
+    const char *value = _recordValues;
+    for (uint8_t i = 0; i < position_i; i++) value += strlen(value) + 1;
+    return value;
+}
+
+
+// This checks if the snapshot is for the marked time and has every value
+bool Logger::isRecordCurrent(void)
+{
+    return _recordValid && _recordEpochTime == Logger::markedEpochTime &&
+           _recordVarCount == getArrayVarCount();
+}
+
+
+// This writes the marked time as an ISO8601 time stamp into a buffer
+uint8_t Logger::formatMarkedTime_ISO8601(char *buffer, uint8_t bufferSize)
+{
+    return formatDateTime_ISO8601(Logger::markedEpochTime, buffer, bufferSize);
+}
 
 
 
@@ -407,10 +587,18 @@ void Logger::publishDataToRemotes(void)
 {
     MS_DBG(F("Sending out remote data."));
 
+    uint32_t intervalNumber = getIntervalNumber();
     for (uint8_t i = 0; i < MAX_NUMBER_SENDERS; i++)
     {
         if (dataPublishers[i] != NULL)
         {
+            // Publishers that aren't due only hold on to the record
+            if (!dataPublishers[i]->isSendDue(intervalNumber))
+            {
+                MS_DBG(F("Not time to send data to ["), i, F("]"));
+                dataPublishers[i]->holdRecord();
+                continue;
+            }
             PRINTOUT(F("\nSending data to ["),i,F("]"), dataPublishers[i]->getEndpoint());
             // dataPublishers[i]->publishData(_logModem->getClient());
             dataPublishers[i]->publishData();
@@ -421,6 +609,41 @@ void Logger::publishDataToRemotes(void)
 void Logger::sendDataToRemotes(void) { publishDataToRemotes(); }
 
 
+// This has every publisher hold on to the current record to send later
+void Logger::holdDataForRemotes(void)
+{
+    for (uint8_t i = 0; i < MAX_NUMBER_SENDERS; i++)
+    {
+        if (dataPublishers[i] != NULL) dataPublishers[i]->holdRecord();
+    }
+}
+
+
+// This checks if any publisher is due to send data on this logging interval
+bool Logger::isAnyPublisherDue(void)
+{
+    uint32_t intervalNumber = getIntervalNumber();
+    for (uint8_t i = 0; i < MAX_NUMBER_SENDERS; i++)
+    {
+        if (dataPublishers[i] != NULL &&
+            dataPublishers[i]->isSendDue(intervalNumber))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+// Protected helper function - This numbers the logging intervals from the
+// start of the epoch, using the marked time
+uint32_t Logger::getIntervalNumber(void)
+{
+    if (_loggingIntervalMinutes == 0) return Logger::markedEpochTime/60;
+    return Logger::markedEpochTime/(60UL*_loggingIntervalMinutes);
+}
+
+
 
 // ===================================================================== //
 // Public functions to access the clock in proper format and time zone
@@ -592,6 +815,73 @@ String Logger::formatDateTime_ISO8601(uint32_t epochTime)
 }
 
 
+// This writes a number with leading zeros to the given width, returning a
+// pointer to the character after it
+static char* writePaddedNumber(char *pos, uint16_t value, uint8_t width)
+{
+    for (int8_t i = width - 1; i >= 0; i--)
+    {
+        pos[i] = '0' + (value % 10);
+        value /= 10;
+    }
+    return pos + width;
+}
+
+
+// This writes an epoch time into a buffer as a date and time for a CSV, ie,
+// 2019-01-01 12:00:00, matching DateTime::addToString()
+uint8_t Logger::formatDateTime_CSV(uint32_t epochTime, char *buffer, uint8_t bufferSize)
+{
+    if (bufferSize == 0) return 0;
+    DateTime dt = dtFromEpoch(epochTime);
+    char timeStr[CSV_TIME_LENGTH + 1];
+    char *pos = timeStr;
+    pos = writePaddedNumber(pos, dt.year(), 4);
+    *pos++ = '-';
+    pos = writePaddedNumber(pos, dt.month(), 2);
+    *pos++ = '-';
+    pos = writePaddedNumber(pos, dt.date(), 2);
+    *pos++ = ' ';
+    pos = writePaddedNumber(pos, dt.hour(), 2);
+    *pos++ = ':';
+    pos = writePaddedNumber(pos, dt.minute(), 2);
+    *pos++ = ':';
+    pos = writePaddedNumber(pos, dt.second(), 2);
+    *pos = '\0';
+    uint8_t len = strlen(timeStr);
+    if (len > bufferSize - 1) len = bufferSize - 1;
+    memcpy(buffer, timeStr, len);
+    buffer[len] = '\0';
+    return len;
+}
+
+
+// This writes an epoch time into a buffer as an ISO8601 time stamp
+uint8_t Logger::formatDateTime_ISO8601(uint32_t epochTime, char *buffer, uint8_t bufferSize)
+{
+    if (bufferSize == 0) return 0;
+    char timeStr[ISO8601_TIME_LENGTH + 1];
+    formatDateTime_CSV(epochTime, timeStr, sizeof(timeStr));
+    timeStr[10] = 'T';
+    if (_loggerTimeZone == 0)
+    {
+        strcat(timeStr, "Z");
+    }
+    else
+    {
+        char *pos = &timeStr[CSV_TIME_LENGTH];
+        *pos++ = _loggerTimeZone < 0 ? '-' : '+';
+        pos = writePaddedNumber(pos, _loggerTimeZone < 0 ? -_loggerTimeZone : _loggerTimeZone, 2);
+        strcpy(pos, ":00");
+    }
+    uint8_t len = strlen(timeStr);
+    if (len > bufferSize - 1) len = bufferSize - 1;
+    memcpy(buffer, timeStr, len);
+    buffer[len] = '\0';
+    return len;
+}
+
+
 // This sets the real time clock to the given time
 bool Logger::setRTClock(uint32_t UTCEpochSeconds)
 {
@@ -1016,6 +1306,7 @@ void Logger::systemSleep(void)
 void Logger::setFileName(String& fileName)
 {
     _fileName = fileName;
+    _autoFileName = false;
 }
 // Same as above, with a character array (overload function)
 void Logger::setFileName(const char *fileName)
@@ -1034,9 +1325,11 @@ void Logger::generateAutoFileName(void)
     String fileName =  String(_loggerID);
     fileName +=  "_";
     fileName +=  formatDateTime_ISO8601(getNowEpoch()).substring(0, 10);
-    fileName +=  ".csv";
+    if (_logFileFormat == LOG_FORMAT_BINARY) fileName +=  ".dat";
+    else fileName +=  ".csv";
     setFileName(fileName);
     _fileName = fileName;
+    _autoFileName = true;
 }
 
 
@@ -1109,13 +1402,15 @@ void Logger::printFileHeader(Stream *stream)
 // time -  out over an Arduino stream
 void Logger::printSensorDataCSV(Stream *stream)
 {
-    String csvString = "";
-    dtFromEpoch(Logger::markedEpochTime).addToString(csvString);
-    csvString += ',';
-    stream->print(csvString);
+    char timeBuffer[CSV_TIME_LENGTH + 1];
+    formatDateTime_CSV(Logger::markedEpochTime, timeBuffer, sizeof(timeBuffer));
+    stream->print(timeBuffer);
+    stream->print(',');
+    char valueBuffer[VALUE_STRING_BUFFER_SIZE];
     for (uint8_t i = 0; i < getArrayVarCount(); i++)
     {
-        stream->print(getValueStringAtI(i));
+        formatValueAtI(i, valueBuffer);
+        stream->print(valueBuffer);
         if (i + 1 != getArrayVarCount())
         {
             stream->print(',');
@@ -1124,6 +1419,122 @@ void Logger::printSensorDataCSV(Stream *stream)
     stream->println();
 }
 
+
+// These write numbers and strings for the binary format, least significant
+// byte first
+static void writeBinaryU16(Stream *stream, uint16_t value)
+{
+    stream->write((uint8_t)(value & 0xFF));
+    stream->write((uint8_t)(value >> 8));
+}
+static void writeBinaryU32(Stream *stream, uint32_t value)
+{
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        stream->write((uint8_t)(value & 0xFF));
+        value >>= 8;
+    }
+}
+static void writeBinaryString(Stream *stream, const char *text)
+{
+    if (text != NULL) stream->print(text);
+    stream->write((uint8_t)0);
+}
+static void writeBinaryString(Stream *stream, String text)
+{
+    stream->print(text);
+    stream->write((uint8_t)0);
+}
+
+
+// This writes the binary schema block onto a stream
+// The block is:
+//    the magic "MSLB", the version, the logger time zone, and the number of
+//    variables (1 byte each, after the magic), the size of each record (2
+//    bytes), then the logger ID, file name, and sampling feature UUID as null
+//    terminated strings, then for each variable its resolution (1 byte)
+//    and its sensor name, variable name, unit, UUID, and code as null
+//    terminated strings.
+void Logger::printBinaryFileHeader(Stream *stream)
+{
+    stream->print(F(MS_BINARY_LOG_MAGIC));
+    stream->write((uint8_t)MS_BINARY_LOG_VERSION);
+    stream->write((uint8_t)_loggerTimeZone);
+    stream->write(getArrayVarCount());
+    writeBinaryU16(stream, getBinaryRecordSize());
+
+    writeBinaryString(stream, _loggerID);
+    writeBinaryString(stream, _fileName);
+    writeBinaryString(stream, _samplingFeatureUUID);
+
+    for (uint8_t i = 0; i < getArrayVarCount(); i++)
+    {
+        stream->write(_internalArray->arrayOfVars[i]->getResolution());
+        writeBinaryString(stream, getParentSensorNameAtI(i));
+        writeBinaryString(stream, getVarNameAtI(i));
+        writeBinaryString(stream, getVarUnitAtI(i));
+        writeBinaryString(stream, getVarUUIDAtI(i));
+        writeBinaryString(stream, getVarCodeAtI(i));
+    }
+}
+
+
+// This returns the number of bytes in each binary record:  the marked time,
+// the status bits, and the values
+uint16_t Logger::getBinaryRecordSize(void)
+{
+    uint8_t nVars = getArrayVarCount();
+    return 4 + (nVars + 7)/8 + 4*nVars;
+}
+
+
+// This scales a value by its resolution for the binary format, rounding away
+// from zero the same way the value is rounded when it's printed.
+// Returns false if the value is bad or too large to fit.
+static bool scaleBinaryValue(Variable *var, int32_t *scaled)
+{
+    float value = var->getValue();
+    *scaled = 0;
+    if (value == -9999 || isnan(value)) return false;
+    for (uint8_t r = 0; r < var->getResolution(); r++) value *= 10;
+    value += (value < 0) ? -0.5 : 0.5;
+    if (value >= 2147483647.0 || value <= -2147483647.0) return false;
+    *scaled = (int32_t)value;
+    return true;
+}
+
+
+// This writes a binary record of the current sensor data onto a stream
+void Logger::printSensorDataBinary(Stream *stream)
+{
+    uint8_t nVars = getArrayVarCount();
+    int32_t scaled;
+
+    writeBinaryU32(stream, Logger::markedEpochTime);
+
+    // The status bits come first, with a bit set for each bad value
+    uint8_t statusByte = 0;
+    for (uint8_t i = 0; i < nVars; i++)
+    {
+        if (!scaleBinaryValue(_internalArray->arrayOfVars[i], &scaled))
+        {
+            statusByte |= (1 << (i % 8));
+        }
+        if (i % 8 == 7 || i + 1 == nVars)
+        {
+            stream->write(statusByte);
+            statusByte = 0;
+        }
+    }
+
+    for (uint8_t i = 0; i < nVars; i++)
+    {
+        scaleBinaryValue(_internalArray->arrayOfVars[i], &scaled);
+        writeBinaryU32(stream, (uint32_t)scaled);
+    }
+}
+
+
 // Protected helper function - This checks if the SD card is available and ready
 bool Logger::initializeSDCard(void)
 {
@@ -1195,7 +1606,14 @@ bool Logger::openFile(String& filename, bool createFile, bool writeDefaultHeader
             // Set creation date time
             setFileTimestamp(logFile, T_CREATE);
             // Write out a header, if requested
-            if (writeDefaultHeader)
+            if (writeDefaultHeader && _logFileFormat == LOG_FORMAT_BINARY)
+            {
+                // Add the schema block
+                printBinaryFileHeader(&logFile);
+                // Set write/modification date time
+                setFileTimestamp(logFile, T_WRITE);
+            }
+            else if (writeDefaultHeader)
             {
                 // Add header information
                 printFileHeader(&logFile);
@@ -1267,6 +1685,12 @@ bool Logger::createLogFile(bool writeDefaultHeader)
 // This can be used to force a logger to write to a file with a secondary file name.
 bool Logger::logToSD(String& filename, String& rec)
 {
+    // Keep the records in order
+    if (_logBuffer.getRecordCount() > 0 && filename == _fileName)
+    {
+        flushSDWriteBuffer();
+    }
+
     // First attempt to open the file without creating a new one
     if (!openFile(filename, false, false))
     {
@@ -1307,6 +1731,81 @@ bool Logger::logToSD(void)
     // Get a new file name if the name is blank
     if (_fileName == "") generateAutoFileName();
 
+    // If records are being buffered, add this one to the buffer and only
+    // write to the card if it's time to
+    if (isBufferingSDWrites())
+    {
+        bool buffered = bufferRecord();
+        if (!buffered)
+        {
+            // Make room by writing out what's already in the buffer.  If that
+            // fails, this record is dropped rather than written to the card
+            // ahead of the older records still waiting in the buffer.
+            if (!flushSDWriteBuffer())
+            {
+                PRINTOUT(F("SD write buffer is full and could not be written"),
+                         F("out!  This record was not saved."));
+                return false;
+            }
+            buffered = bufferRecord();
+        }
+        if (buffered)
+        {
+            // Echo the line to the serial port
+            #if defined(STANDARD_SERIAL_OUTPUT)
+                PRINTOUT(F("\n \\/---- Line Buffered for SD Card ----\\/"));
+                printSensorDataCSV(&STANDARD_SERIAL_OUTPUT);
+                PRINTOUT('\n');
+            #endif
+            if (isSDWriteDue()) return flushSDWriteBuffer();
+            return true;
+        }
+        // The buffer is empty now, so the record is too big for it; write it
+        // on its own
+        MS_DBG(F("Record is too large for the SD write buffer!"));
+        turnOnSDcard(true);
+        bool success = writeRecordToSD();
+        turnOffSDcard(true);
+        return success;
+    }
+
+    return writeRecordToSD();
+}
+
+
+// Protected helper function - This writes the current record straight to
+// the log file, creating it with a header if needed
+bool Logger::writeRecordToSD(void)
+{
+    // Append straight to a preallocated file, if there is one
+    if (_preallocatedFileSize > 0 && appendToContiguousFile(NULL, 0))
+    {
+        // Echo the line to the serial port
+        #if defined(STANDARD_SERIAL_OUTPUT)
+            PRINTOUT(F("\n \\/---- Line Saved to SD Card ----\\/"));
+            printSensorDataCSV(&STANDARD_SERIAL_OUTPUT);
+            PRINTOUT('\n');
+        #endif
+        return true;
+    }
+
+    // Append through the journal, if journaling
+    if (_journaling)
+    {
+        if (!journaledAppend(NULL, 0))
+        {
+            PRINTOUT(F("Unable to write to SD card!"));
+            return false;
+        }
+        // Echo the line to the serial port
+        #if defined(STANDARD_SERIAL_OUTPUT)
+            PRINTOUT(F("\n \\/---- Line Saved to SD Card ----\\/"));
+            printSensorDataCSV(&STANDARD_SERIAL_OUTPUT);
+            PRINTOUT('\n');
+        #endif
+        return true;
+    }
+
     // First attempt to open the file without creating a new one
     if (!openFile(_fileName, false, false))
     {
@@ -1323,7 +1822,8 @@ bool Logger::logToSD(void)
     }
 
     // Write the data
-    printSensorDataCSV(&logFile);
+    if (_logFileFormat == LOG_FORMAT_BINARY) printSensorDataBinary(&logFile);
+    else printSensorDataCSV(&logFile);
     // Echo the line to the serial port
     #if defined(STANDARD_SERIAL_OUTPUT)
         PRINTOUT(F("\n \\/---- Line Saved to SD Card ----\\/"));
@@ -1342,6 +1842,364 @@ bool Logger::logToSD(void)
 }
 
 
+// This sets up the log file to be preallocated in one contiguous extent
+void Logger::setPreallocatedFileSize(uint32_t fileSize)
+{
+    _preallocatedFileSize = fileSize;
+}
+
+
+// This cuts a preallocated file down to the data written to it
+bool Logger::finishPreallocatedFile(void)
+{
+    if (!_contiguousFile.isReady()) return true;
+    turnOnSDcard(true);
+    bool success = initializeSDCard() && finishContiguousFile();
+    turnOffSDcard(true);
+    return success;
+}
+
+
+// Protected helper function - This returns the size of the binary schema
+// block, without writing it anywhere
+uint32_t Logger::getBinaryFileHeaderSize(void)
+{
+    // The magic, version, time zone, variable count, and record size
+    uint32_t headerSize = 9;
+    if (_loggerID != NULL) headerSize += strlen(_loggerID);
+    headerSize += 1 + _fileName.length() + 1;
+    if (_samplingFeatureUUID != NULL) headerSize += strlen(_samplingFeatureUUID);
+    headerSize++;
+    for (uint8_t i = 0; i < getArrayVarCount(); i++)
+    {
+        // The resolution and five null terminated strings
+        headerSize += 6;
+        headerSize += getParentSensorNameAtI(i).length();
+        headerSize += getVarNameAtI(i).length();
+        headerSize += getVarUnitAtI(i).length();
+        headerSize += getVarUUIDAtI(i).length();
+        headerSize += getVarCodeAtI(i).length();
+    }
+    return headerSize;
+}
+
+
+// Protected helper function - This gets the preallocated file ready to append
+// to, creating it or finding where its data ends if needed.
+// Returns false if the file should be written to the usual way instead.
+bool Logger::prepareContiguousFile(void)
+{
+    // An automatic file name is for the day, so when the date changes the
+    // day's file is finished and the next day's is started
+    if (_autoFileName) generateAutoFileName();
+    if (_contiguousFileName == _fileName)
+    {
+        // This is either the file we've been appending to or one that has
+        // already been found not to work
+        return _contiguousFile.isReady();
+    }
+    // Finish the last file before starting on another
+    if (_contiguousFile.isReady()) finishContiguousFile();
+    _contiguousFileName = _fileName;
+
+    // Convert the string filename to a character file name for SdFat
+    uint8_t fileNameLength = _fileName.length() + 1;
+    char charFileName[fileNameLength];
+    _fileName.toCharArray(charFileName, fileNameLength);
+
+    // Pick up where we left off in an existing file
+    if (sd.exists(charFileName))
+    {
+        bool resumed;
+        if (_logFileFormat == LOG_FORMAT_BINARY)
+        {
+            resumed = _contiguousFile.resume(sd, logFile, charFileName,
+                                             getBinaryFileHeaderSize(),
+                                             getBinaryRecordSize());
+        }
+        else resumed = _contiguousFile.resume(sd, logFile, charFileName);
+        if (resumed) logFile.close();
+        return resumed;
+    }
+
+    // Create the file and write its header
+    if (!_contiguousFile.create(sd, logFile, charFileName, _preallocatedFileSize))
+    {
+        return false;
+    }
+    MS_DBG(F("Created preallocated file:"), _fileName);
+    setFileTimestamp(logFile, T_CREATE);
+    logFile.close();
+    _contiguousFile.beginAppend();
+    if (_logFileFormat == LOG_FORMAT_BINARY) printBinaryFileHeader(&_contiguousFile);
+    else printFileHeader(&_contiguousFile);
+    if (!_contiguousFile.endAppend())
+    {
+        // If even the header won't fit, don't bother with preallocation
+        finishContiguousFile();
+        sd.remove(charFileName);
+        return false;
+    }
+    return true;
+}
+
+
+// Protected helper function - This appends either the given bytes or, if
+// there are none, the current record to the preallocated file
+bool Logger::appendToContiguousFile(const uint8_t *data, uint16_t length)
+{
+    if (!initializeSDCard() || !prepareContiguousFile()) return false;
+
+    _contiguousFile.beginAppend();
+    if (data != NULL) _contiguousFile.write(data, length);
+    else if (_logFileFormat == LOG_FORMAT_BINARY) printSensorDataBinary(&_contiguousFile);
+    else printSensorDataCSV(&_contiguousFile);
+    if (_contiguousFile.endAppend()) return true;
+
+    // If the data didn't fit, cut the file down to what's in it so the rest
+    // can be added to the end the usual way
+    finishContiguousFile();
+    return false;
+}
+
+
+// Protected helper function - This cuts the preallocated file down to the
+// data in it and sets its timestamps
+bool Logger::finishContiguousFile(void)
+{
+    if (!_contiguousFile.finish(logFile))
+    {
+        PRINTOUT(F("Unable to finish preallocated file"), _contiguousFileName);
+        return false;
+    }
+    // Set write/modification date time
+    setFileTimestamp(logFile, T_WRITE);
+    // Set access date time
+    setFileTimestamp(logFile, T_ACCESS);
+    logFile.close();
+    return true;
+}
+
+
+// Protected helper function - This appends either the given bytes or, if
+// there are none, the current record to the log file through the journal
+bool Logger::journaledAppend(const uint8_t *data, uint16_t length)
+{
+    // Finish an earlier append that failed part way through first
+    if (_journalNeedsRecovery)
+    {
+        if (!recoverJournal()) return false;
+    }
+
+    // Open the file, creating it with a header if it doesn't exist yet
+    if (!openFile(_fileName, true, true)) return false;
+
+    // Convert the string filename to a character file name for SdFat
+    uint8_t fileNameLength = _fileName.length() + 1;
+    char charFileName[fileNameLength];
+    _fileName.toCharArray(charFileName, fileNameLength);
+
+    // Write the data into the journal
+    if (!_journal.beginEntry(sd, charFileName, logFile.fileSize()))
+    {
+        logFile.close();
+        return false;
+    }
+    if (data != NULL) _journal.write(data, length);
+    else if (_logFileFormat == LOG_FORMAT_BINARY) printSensorDataBinary(&_journal);
+    else printSensorDataCSV(&_journal);
+    if (!_journal.commitEntry())
+    {
+        logFile.close();
+        return false;
+    }
+
+    // Copy it from the journal to the log file
+    bool success = _journal.copyEntryTo(logFile);
+    // Set write/modification date time
+    setFileTimestamp(logFile, T_WRITE);
+    // Set access date time
+    setFileTimestamp(logFile, T_ACCESS);
+    logFile.close();
+
+    // Only mark the entry as applied once it's all safely in the log file
+    if (success) success = _journal.markApplied();
+    else _journal.close();
+    _journalNeedsRecovery = !success;
+    return success;
+}
+
+
+// This repairs the last append to the log file, if it didn't finish
+bool Logger::recoverJournal(void)
+{
+    if (!initializeSDCard()) return false;
+
+    char logFileName[MS_JOURNAL_MAX_NAME_LENGTH + 1];
+    uint32_t logFileSize;
+    if (!_journal.findPendingEntry(sd, logFileName, sizeof(logFileName), &logFileSize))
+    {
+        // There's nothing to repair
+        _journalNeedsRecovery = false;
+        return true;
+    }
+
+    PRINTOUT(F("Repairing the last record saved to"), logFileName);
+    if (!logFile.open(logFileName, O_RDWR | O_CREAT))
+    {
+        _journal.close();
+        PRINTOUT(F("Unable to open"), logFileName, F("to repair it!"));
+        return false;
+    }
+    // Cut off whatever part of the data made it into the file and add it all
+    if (logFile.fileSize() > logFileSize) logFile.truncate(logFileSize);
+    logFile.seekEnd();
+    bool success = _journal.copyEntryTo(logFile);
+    // Set write/modification date time
+    setFileTimestamp(logFile, T_WRITE);
+    // Set access date time
+    setFileTimestamp(logFile, T_ACCESS);
+    logFile.close();
+
+    if (success) success = _journal.markApplied();
+    else _journal.close();
+    _journalNeedsRecovery = !success;
+    return success;
+}
+
+
+// This sets up a buffer to keep records in RAM and write them together
+void Logger::setSDWriteBuffer(uint8_t buffer[], uint16_t bufferSize,
+                              uint8_t recordsPerWrite, uint32_t maxAgeSeconds)
+{
+    _logBuffer.begin(buffer, bufferSize);
+    _recordsPerWrite = recordsPerWrite > 0 ? recordsPerWrite : 1;
+    _maxBufferAgeSeconds = maxAgeSeconds;
+}
+
+
+// This sets a variable to check for a low battery before buffering records
+void Logger::setLowBatteryFlush(Variable *batteryVoltage, float minVoltage)
+{
+    _lowBatteryVar = batteryVoltage;
+    _lowBatteryVoltage = minVoltage;
+}
+
+
+// Protected helper function - This adds the current record to the buffer
+bool Logger::bufferRecord(void)
+{
+    _logBuffer.startRecord();
+    if (_logFileFormat == LOG_FORMAT_BINARY) printSensorDataBinary(&_logBuffer);
+    else printSensorDataCSV(&_logBuffer);
+    if (!_logBuffer.endRecord()) return false;
+
+    if (_logBuffer.getRecordCount() == 1) _firstBufferedEpoch = Logger::markedEpochTime;
+    MS_DBG(_logBuffer.getRecordCount(), F("records and"), _logBuffer.getLength(),
+           F("bytes are waiting to be written to the SD card"));
+    return true;
+}
+
+
+// Protected helper function - This checks if the buffered records should be
+// written out now
+bool Logger::isSDWriteDue(void)
+{
+    if (_logBuffer.getRecordCount() >= _recordsPerWrite)
+    {
+        MS_DBG(F("SD write buffer has"), _logBuffer.getRecordCount(), F("records"));
+        return true;
+    }
+    if (_maxBufferAgeSeconds > 0 &&
+        Logger::markedEpochTime - _firstBufferedEpoch >= _maxBufferAgeSeconds)
+    {
+        MS_DBG(F("Oldest record in the SD write buffer is from"), _firstBufferedEpoch);
+        return true;
+    }
+    if (_lowBatteryVar != NULL)
+    {
+        float voltage = _lowBatteryVar->getValue();
+        if (voltage != -9999 && voltage < _lowBatteryVoltage)
+        {
+            MS_DBG(F("Battery is low, writing buffered records to the SD card"));
+            return true;
+        }
+    }
+    return false;
+}
+
+
+// This writes out any buffered records in one session with the SD card
+bool Logger::flushSDWriteBuffer(void)
+{
+    if (_logBuffer.getLength() == 0) return true;
+
+    // Get a new file name if the name is blank
+    if (_fileName == "") generateAutoFileName();
+
+    turnOnSDcard(true);
+    // Append straight to a preallocated file, if there is one
+    if (_preallocatedFileSize > 0 &&
+        appendToContiguousFile(_logBuffer.getData(), _logBuffer.getLength()))
+    {
+        PRINTOUT(F("Saved"), _logBuffer.getRecordCount(), F("buffered records to the SD card"));
+        _logBuffer.clear();
+        turnOffSDcard(true);
+        return true;
+    }
+
+    // Append through the journal, if journaling
+    if (_journaling)
+    {
+        bool success = journaledAppend(_logBuffer.getData(), _logBuffer.getLength());
+        if (success)
+        {
+            PRINTOUT(F("Saved"), _logBuffer.getRecordCount(), F("buffered records to the SD card"));
+            _logBuffer.clear();
+        }
+        // Otherwise leave the records in the buffer to try again next time
+        else PRINTOUT(F("Unable to write to SD card!"));
+        turnOffSDcard(true);
+        return success;
+    }
+
+    // Open the file, creating it with a header if it doesn't exist yet
+    if (!openFile(_fileName, true, true))
+    {
+        // Leave the records in the buffer to try again next time
+        PRINTOUT(F("Unable to write to SD card!"));
+        turnOffSDcard(true);
+        return false;
+    }
+
+    uint32_t sizeBefore = logFile.fileSize();
+    bool success = (logFile.write(_logBuffer.getData(), _logBuffer.getLength()) ==
+                    _logBuffer.getLength());
+    if (success)
+    {
+        PRINTOUT(F("Saved"), _logBuffer.getRecordCount(), F("buffered records to the SD card"));
+        _logBuffer.clear();
+    }
+    else
+    {
+        // Take off anything that was written, so the records aren't doubled
+        // when they're tried again next time
+        PRINTOUT(F("Unable to write to SD card!"));
+        logFile.truncate(sizeBefore);
+    }
+
+    // Set write/modification date time
+    setFileTimestamp(logFile, T_WRITE);
+    // Set access date time
+    setFileTimestamp(logFile, T_ACCESS);
+    // Close the file to save it
+    logFile.close();
+    // Cut power from the SD card, waiting for housekeeping
+    turnOffSDcard(true);
+    return success;
+}
+
+
 // ===================================================================== //
 // Public functions for a "sensor testing" mode
 // ===================================================================== //
@@ -1569,10 +2427,231 @@ void Logger::begin()
         PRINTOUT(F("Sampling feature UUID is:"), _samplingFeatureUUID);
     }
 
+    // Repair the last record saved to the SD card, if it was cut off
+    if (_journaling)
+    {
+        turnOnSDcard(true);
+        recoverJournal();
+        turnOffSDcard(true);
+        watchDogTimer.resetWatchDog();
+    }
+
     PRINTOUT(F("Logger portion of setup finished.\n"));
 }
 
 
+// This turns on the outbox
+void Logger::enableOutbox(uint8_t maxRecordsPerCycle, uint32_t maxMillisPerCycle)
+{
+    _outboxEnabled = true;
+    _outboxMaxRecords = maxRecordsPerCycle > 0 ? maxRecordsPerCycle : 1;
+    _outboxMaxMillis = maxMillisPerCycle;
+}
+
+
+// This adds the current record to the outbox
+bool Logger::addRecordToOutbox(void)
+{
+    if (_recordBufferSize == 0)
+    {
+        PRINTOUT(F("The outbox needs a record buffer!  See setRecordBuffer()."));
+        return false;
+    }
+    if (!_recordValid || _recordEpochTime != Logger::markedEpochTime) buildRecord();
+    if (!initializeSDCard()) return false;
+
+    // The values are saved just as they are in the snapshot
+    uint16_t valuesLength = 0;
+    if (_recordVarCount > 0)
+    {
+        const char *last = getRecordValue(_recordVarCount - 1);
+        valuesLength = (last - _recordValues) + strlen(last) + 1;
+    }
+    if (!_outbox.addRecord(sd, _recordEpochTime, _recordValues, valuesLength,
+                           _recordVarCount))
+    {
+        PRINTOUT(F("Unable to add the record to the outbox!"));
+        return false;
+    }
+    return true;
+}
+
+
+// Protected helper function - This replaces the record snapshot with a record
+// from the outbox
+uint32_t Logger::loadOutboxRecord(uint32_t position)
+{
+    uint32_t epochTime;
+    uint16_t valuesLength;
+    uint8_t valueCount;
+    bool isValid;
+    uint32_t next = _outbox.readRecord(position, &epochTime, _recordValues,
+                                       _recordBufferSize, &valuesLength,
+                                       &valueCount, &isValid);
+    _recordValid = false;
+    if (next == 0 || !isValid) return next;
+
+    // Count the values that are whole
+    uint16_t pos = 0;
+    _recordVarCount = 0;
+    _recordValuesLength = 0;
+    while (_recordVarCount < valueCount && _recordVarCount < getArrayVarCount() &&
+           pos < valuesLength)
+    {
+        uint8_t len = strnlen(&_recordValues[pos], valuesLength - pos);
+        if (pos + len >= valuesLength) break;  // not null terminated
+        _recordVarCount++;
+        _recordValuesLength += len;
+        pos += len + 1;
+    }
+
+    Logger::markedEpochTime = epochTime;
+    _recordEpochTime = epochTime;
+    _recordValid = true;
+    _recordIsReplay = true;
+    return next;
+}
+
+
+// Protected helper function - This sends records from the outbox to a
+// publisher in batches, returning the position of the first unsent record
+uint32_t Logger::publishOutboxBatches(dataPublisher *publisher, uint32_t cursor,
+                                      uint32_t startMillis, uint8_t *nSent)
+{
+    while (cursor < _outbox.getEnd() && *nSent < _outboxMaxRecords &&
+           millis() - startMillis < _outboxMaxMillis)
+    {
+        // Fill the batch with as many records as fit, within the limit
+        publisher->clearBatch();
+        uint32_t batchEnd = cursor;
+        uint8_t nInBatch = 0;
+        while (batchEnd < _outbox.getEnd() && *nSent + nInBatch < _outboxMaxRecords)
+        {
+            uint32_t next = loadOutboxRecord(batchEnd);
+            // If the card can't be read, send what's already in the batch
+            // and leave the rest for next time
+            if (next == 0)
+            {
+                if (nInBatch == 0)
+                {
+                    PRINTOUT(F("Unable to read the outbox!"));
+                    return cursor;
+                }
+                break;
+            }
+            // A damaged record is skipped, but only that one
+            if (!_recordValid)
+            {
+                PRINTOUT(F("Skipping a damaged record in the outbox!"));
+                batchEnd = next;
+                continue;
+            }
+            if (!publisher->addRecordToBatch()) break;
+            batchEnd = next;
+            nInBatch++;
+        }
+        // Nothing but damaged records, so there's nothing to send for them
+        if (nInBatch == 0 && batchEnd > cursor)
+        {
+            cursor = batchEnd;
+            continue;
+        }
+        if (nInBatch == 0)
+        {
+            PRINTOUT(F("The batch buffer is too small for a single record!"));
+            break;
+        }
+
+        int16_t result = publisher->publishBatch();
+        watchDogTimer.resetWatchDog();
+        // Stop at the first failure, so the records stay in order
+        if (!publisher->wasPublishSuccessful(result)) break;
+        cursor = batchEnd;
+        *nSent += nInBatch;
+    }
+    // Nothing is left waiting in the publisher; it's all still in the outbox
+    publisher->clearBatch();
+    return cursor;
+}
+
+
+// This sends records from the outbox to each publisher, within the limits
+void Logger::publishOutbox(void)
+{
+    // If the outbox can't be read, at least send the current record
+    if (_recordBufferSize == 0 || !initializeSDCard() || !_outbox.begin(sd) ||
+        !_outbox.openForReading(sd))
+    {
+        PRINTOUT(F("Unable to read the outbox!"));
+        publishDataToRemotes();
+        return;
+    }
+
+    uint32_t currentMarkedTime = Logger::markedEpochTime;
+    uint32_t intervalNumber = getIntervalNumber();
+    uint32_t start = millis();
+    for (uint8_t i = 0; i < MAX_NUMBER_SENDERS; i++)
+    {
+        // Empty slots don't hold up emptying the outbox
+        if (dataPublishers[i] == NULL)
+        {
+            _outbox.setCursor(i, _outbox.getEnd());
+            continue;
+        }
+        // Publishers that aren't due leave their records waiting in the outbox
+        if (!dataPublishers[i]->isSendDue(intervalNumber))
+        {
+            MS_DBG(F("Not time to send data to ["), i, F("]"));
+            continue;
+        }
+
+        PRINTOUT(F("\nSending data to ["),i,F("]"), dataPublishers[i]->getEndpoint());
+        uint32_t cursor = _outbox.getCursor(i);
+        if (cursor > _outbox.getEnd()) cursor = _outbox.getEnd();
+        uint8_t nSent = 0;
+        // A publisher that can batch records is sent as many as fit at once
+        if (dataPublishers[i]->isBatching())
+        {
+            cursor = publishOutboxBatches(dataPublishers[i], cursor, start, &nSent);
+        }
+        while (!dataPublishers[i]->isBatching() &&
+               cursor < _outbox.getEnd() && nSent < _outboxMaxRecords &&
+               millis() - start < _outboxMaxMillis)
+        {
+            uint32_t next = loadOutboxRecord(cursor);
+            // If the card can't be read, leave the records for next time
+            if (next == 0)
+            {
+                PRINTOUT(F("Unable to read the outbox!"));
+                break;
+            }
+            // A damaged record is skipped, but only that one
+            if (!_recordValid)
+            {
+                PRINTOUT(F("Skipping a damaged record in the outbox!"));
+                cursor = next;
+                continue;
+            }
+            int16_t result = dataPublishers[i]->publishData();
+            watchDogTimer.resetWatchDog();
+            // Stop at the first failure, so the records stay in order
+            if (!dataPublishers[i]->wasPublishSuccessful(result)) break;
+            cursor = next;
+            nSent++;
+        }
+        _outbox.setCursor(i, cursor);
+        MS_DBG(nSent, F("records sent to ["), i, F("];"),
+               _outbox.getEnd() - cursor, F("bytes of records are still waiting"));
+    }
+    _outbox.close();
+    _outbox.saveCursors(sd, MAX_NUMBER_SENDERS);
+
+    // Put back the current record
+    Logger::markedEpochTime = currentMarkedTime;
+    buildRecord();
+}
+
+
 // This is a one-and-done to log data
 void Logger::logData(void)
 {
@@ -1592,10 +2671,11 @@ void Logger::logData(void)
         PRINTOUT(F("------------------------------------------"));
         // Turn on the LED to show we're taking a reading
         alertOn();
-        // Power up the SD Card
+        // Power up the SD Card, unless records are being buffered, in which
+        // case it's only powered up when the buffer is written out
         // TODO:  Decide how much delay is needed between turning on the card
         // and writing to it.  Could we turn it on just before writing?
-        turnOnSDcard(false);
+        if (!isBufferingSDWrites()) turnOnSDcard(false);
 
         // Do a complete sensor update
         MS_DBG(F("    Running a complete sensor update..."));
@@ -1603,10 +2683,13 @@ void Logger::logData(void)
         _internalArray->completeUpdate();
         watchDogTimer.resetWatchDog();
 
+        // Format the values once for the SD card and all of the publishers
+        buildRecord();
+
         // Create a csv data record and save it to the log file
         logToSD();
         // Cut power from the SD card, waiting for housekeeping
-        turnOffSDcard(true);
+        if (!isBufferingSDWrites()) turnOffSDcard(true);
 
         // Turn off the LED
         alertOff();
@@ -1642,36 +2725,62 @@ void Logger::logDataAndPublish(void)
         PRINTOUT(F("------------------------------------------"));
         // Turn on the LED to show we're taking a reading
         alertOn();
-        // Power up the SD Card
+        // Power up the SD Card, unless records are being buffered, in which
+        // case it's only powered up when the buffer is written out
         // TODO:  Decide how much delay is needed between turning on the card
         // and writing to it.  Could we turn it on just before writing?
-        turnOnSDcard(false);
-
-        // Turn on the modem to let it start searching for the network
-        if (_logModem != NULL) _logModem->modemPowerUp();
+        if (!isBufferingSDWrites()) turnOnSDcard(false);
+
+        // Only use the modem if a publisher is due to send data or the clock
+        // needs to be synced
+        bool modemNeeded = isAnyPublisherDue() ||
+                           (Logger::markedEpochTime != 0 &&
+                            Logger::markedEpochTime % 86400 == 43200) ||
+                           !isRTCSane(Logger::markedEpochTime);
+
+        // Turn on the modem and start connecting to the internet
+        loggerModem *connectingModem = NULL;
+        if (_logModem != NULL && modemNeeded)
+        {
+            _logModem->startConnectInternet();
+            connectingModem = _logModem;
+        }
 
         // Do a complete update on the variable array.
         // This this includes powering all of the sensors, getting updated
         // values, and turing them back off.
+        // The modem's connection to the internet is moved along whenever the
+        // sensors are waiting.
         // NOTE:  The wake function for each sensor should force sensor setup
         // to run if the sensor was not previously set up.
         MS_DBG(F("Running a complete sensor update..."));
         watchDogTimer.resetWatchDog();
-        _internalArray->completeUpdate();
+        _internalArray->completeUpdate(connectingModem);
         watchDogTimer.resetWatchDog();
 
+        // Format the values once for the SD card and all of the publishers
+        buildRecord();
+
         // Create a csv data record and save it to the log file
         logToSD();
 
-        if (_logModem != NULL)
+        // Keep the record in the outbox until every publisher has sent it
+        if (_outboxEnabled)
+        {
+            if (isBufferingSDWrites()) turnOnSDcard(true);
+            addRecordToOutbox();
+        }
+
+        if (_logModem != NULL && modemNeeded)
         {
-            // Connect to the network
+            // Finish connecting to the network
             MS_DBG(F("Connecting to the Internet..."));
-            if (_logModem->connectInternet())
+            if (_logModem->finishConnectInternet())
             {
                 // Publish data to remotes
                 watchDogTimer.resetWatchDog();
-                publishDataToRemotes();
+                if (_outboxEnabled) publishOutbox();
+                else publishDataToRemotes();
                 watchDogTimer.resetWatchDog();
 
                 if ((Logger::markedEpochTime != 0 &&
@@ -1692,10 +2801,17 @@ void Logger::logDataAndPublish(void)
             {
                 MS_DBG(F("Could not connect to the internet!"));
                 watchDogTimer.resetWatchDog();
+                // Keep the record to send on the next try
+                if (!_outboxEnabled) holdDataForRemotes();
             }
             // Turn the modem off
             _logModem->modemSleepPowerDown();
         }
+        else if (_logModem != NULL && !_outboxEnabled)
+        {
+            // With no publisher due, they only hold on to the record
+            holdDataForRemotes();
+        }
 
 
         // TODO:  Do some sort of verification that minimum 1 sec has passed
@@ -1703,7 +2819,7 @@ void Logger::logDataAndPublish(void)
         // It seems very unlikely based on my testing that less than one second
         // would be taken up in publishing data to remotes
         // Cut power from the SD card - without additional housekeeping wait
-        turnOffSDcard(false);
+        if (!isBufferingSDWrites() || _outboxEnabled) turnOffSDcard(false);
 
         // Turn off the LED
         alertOff();
@@ -24,6 +24,10 @@
 #undef MS_DEBUGGING_STD
 #include "VariableArray.h"
 #include "LoggerModem.h"
+#include "LogBuffer.h"
+#include "ContiguousLogFile.h"
+#include "LogJournal.h"
+#include "LogOutbox.h"
 
 // Bring in the libraries to handle the processor sleep/standby modes
 // The SAMD library can also the built-in clock on those modules
@@ -50,6 +54,36 @@
 // The largest number of variables from a single sensor
 #define MAX_NUMBER_SENDERS 4
 
+// Each publisher needs its own read cursor in the outbox
+#if MS_OUTBOX_NUM_CURSORS < MAX_NUMBER_SENDERS
+#error MS_OUTBOX_NUM_CURSORS must be at least MAX_NUMBER_SENDERS
+#endif
+
+// The length of an ISO8601 time stamp with a time zone offset, ie,
+// 2019-01-01T12:00:00-05:00, and of a date and time, ie, 2019-01-01 12:00:00
+#define ISO8601_TIME_LENGTH 25
+#define CSV_TIME_LENGTH 19
+
+// The default limits on how many records from the outbox each publisher sends
+// in a logging cycle, and on how long all of them together spend sending them
+#ifndef MS_OUTBOX_MAX_RECORDS
+#define MS_OUTBOX_MAX_RECORDS 12
+#endif
+#ifndef MS_OUTBOX_MAX_MILLIS
+#define MS_OUTBOX_MAX_MILLIS 120000L
+#endif
+
+// These identify a binary log file and the version of its layout
+#define MS_BINARY_LOG_MAGIC "MSLB"
+#define MS_BINARY_LOG_VERSION 1
+
+// These are the formats data can be saved to the SD card in
+typedef enum logFileFormat
+{
+    LOG_FORMAT_CSV = 0,  // Human-readable comma separated values
+    LOG_FORMAT_BINARY    // A schema block followed by fixed-width records
+} logFileFormat;
+
 
 class dataPublisher;  // Forward declaration
 
@@ -154,11 +188,56 @@ public:
     // This returns the current value of the variable as a string with the
     // correct number of significant figures
     String getValueStringAtI(uint8_t position_i);
+    // This writes the current value of the variable into a character buffer
+    // and returns the number of characters written.  This does not allocate
+    // any memory and should be used instead of getValueStringAtI() for output.
+    uint8_t formatValueAtI(uint8_t position_i, char *buffer,
+                           uint8_t bufferSize = VALUE_STRING_BUFFER_SIZE);
+
+    // This sets the buffer for a snapshot of the formatted values of every
+    // variable, for the SD card and all of the publishers to share.  The
+    // buffer is supplied by the user and should have room for all of the
+    // values, each with a terminating null, ie:
+    //     char recordBuffer[240];
+    //     dataLogger.setRecordBuffer(recordBuffer, sizeof(recordBuffer));
+    // Any values that don't fit are formatted again each time they're
+    // needed.  The outbox keeps records in the same form, so it can't be used
+    // without this buffer.
+    void setRecordBuffer(char buffer[], uint16_t bufferSize);
+    // This takes the snapshot for the marked time.
+    // This is called by logData() and logDataAndPublish() right after the
+    // sensors are updated; a custom loop should call it after
+    // completeUpdate().  Until the time is marked again, formatValueAtI() and
+    // the CSV printer copy from the snapshot instead of formatting anything
+    // again.  Without a record buffer, this does nothing.
+    void buildRecord(void);
+    // This checks if there is a snapshot for the marked time with the
+    // values of all of the variables in it
+    bool isRecordCurrent(void);
+    // This returns the total length of all of the formatted values in the
+    // snapshot, ie, for calculating the length of a message
+    uint16_t getRecordValuesLength(void){return _recordValuesLength;}
+    // This writes the marked time as an ISO8601 time stamp into a buffer
+    uint8_t formatMarkedTime_ISO8601(char *buffer, uint8_t bufferSize);
 
 protected:
     // A pointer to the internal variable array instance
     VariableArray *_internalArray;
 
+    // The snapshot of the last record
+    // The formatted values are stored back to back, each null terminated, in
+    // the user-supplied buffer.
+    bool _recordValid;
+    uint32_t _recordEpochTime;
+    char *_recordValues;
+    uint16_t _recordBufferSize;
+    uint8_t _recordVarCount;
+    uint16_t _recordValuesLength;
+    // This is set while the snapshot holds an old record from the outbox
+    bool _recordIsReplay;
+    // This finds a value in the snapshot
+    const char *getRecordValue(uint8_t position_i);
+
     // ===================================================================== //
     // Public functions for internet and dataPublishers
     // ===================================================================== //
@@ -177,6 +256,26 @@ public:
     void publishDataToRemotes(void);
     // These are duplicates of the above functions for backwards compatibility
     void sendDataToRemotes(void);
+    // This checks if any publisher is due to send data on this logging
+    // interval (see dataPublisher::setSendFrequency())
+    bool isAnyPublisherDue(void);
+
+    // This turns on the outbox:  every record is kept in an outbox on the SD
+    // card until each publisher has sent it, so nothing is lost when the
+    // internet connection fails.  Whenever there is a connection, each
+    // publisher sends the oldest records it hasn't sent yet, up to the given
+    // number of records per publisher and the given time for all of them
+    // together; the rest are left for the next logging cycle.
+    // logDataAndPublish() uses the outbox once it's turned on.
+    // NOTE:  Each publisher's place in the outbox is kept by the order it was
+    // registered with the logger, so keep that order the same.
+    void enableOutbox(uint8_t maxRecordsPerCycle = MS_OUTBOX_MAX_RECORDS,
+                      uint32_t maxMillisPerCycle = MS_OUTBOX_MAX_MILLIS);
+    bool isOutboxEnabled(void){return _outboxEnabled;}
+    // This adds the current record to the outbox
+    bool addRecordToOutbox(void);
+    // This sends records from the outbox to each publisher, within the limits
+    void publishOutbox(void);
 
 protected:
     // The internal modem instance
@@ -187,6 +286,26 @@ protected:
 
     // An array of all of the attached data publishers
     dataPublisher *dataPublishers[MAX_NUMBER_SENDERS];
+    // This has every publisher hold on to the current record to send later,
+    // ie, when none is due or the internet connection failed
+    void holdDataForRemotes(void);
+    // This numbers the logging intervals from the start of the epoch, using
+    // the marked time, for deciding which publishers are due
+    uint32_t getIntervalNumber(void);
+
+    // The outbox of records not yet sent by every publisher
+    LogOutbox _outbox;
+    bool _outboxEnabled;
+    uint8_t _outboxMaxRecords;
+    uint32_t _outboxMaxMillis;
+    // This replaces the record snapshot with a record from the outbox,
+    // returning the position of the next record in the outbox or 0 if the
+    // card couldn't be read.  The snapshot is only valid if the record was.
+    uint32_t loadOutboxRecord(uint32_t position);
+    // This sends records from the outbox to a publisher that can batch them,
+    // several in each request, returning the position of the first unsent one
+    uint32_t publishOutboxBatches(dataPublisher *publisher, uint32_t cursor,
+                                  uint32_t startMillis, uint8_t *nSent);
 
     // ===================================================================== //
     // Public functions to access the clock in proper format and time zone
@@ -233,6 +352,15 @@ public:
     // the LOGGER's offset as the time zone offset in the string.
     static String formatDateTime_ISO8601(uint32_t epochTime);
 
+    // These write an epoch time into a character buffer, either as an
+    // ISO8601 time stamp with the LOGGER's time zone offset, or as a date
+    // and time for a CSV, and return the number of characters written.
+    // They do not allocate any memory.
+    static uint8_t formatDateTime_ISO8601(uint32_t epochTime, char *buffer,
+                                          uint8_t bufferSize);
+    static uint8_t formatDateTime_CSV(uint32_t epochTime, char *buffer,
+                                      uint8_t bufferSize);
+
     // This sets the real time clock to the given time
     bool setRTClock(uint32_t UTCEpochSeconds);
 
@@ -294,6 +422,26 @@ public:
     // This returns the current filename.  Must be run after setFileName.
     String getFileName(void){return _fileName;}
 
+    // This sets the format of the data saved to the SD card.  The default is
+    // a CSV.  The binary format is much smaller:  a schema block describing
+    // the variables is written once when the file is created and each record
+    // after it is the marked time, one status bit per variable, and each
+    // value as a 32-bit integer scaled by the variable's resolution.  Values
+    // of -9999 or too large to be scaled have their status bit set.
+    // All numbers are little-endian.  Use the decoder in
+    // tools/binary_log_decoder to convert a binary file back to a CSV.
+    // NOTE:  This must be called before the file is created.  If the file
+    // name is generated automatically, binary files end in ".dat".
+    void setLogFileFormat(logFileFormat format){_logFileFormat = format;}
+    logFileFormat getLogFileFormat(void){return _logFileFormat;}
+
+    // This writes the binary schema block onto a stream
+    virtual void printBinaryFileHeader(Stream *stream);
+    // This writes a binary record of the current sensor data onto a stream
+    void printSensorDataBinary(Stream *stream);
+    // This returns the number of bytes in each binary record
+    uint16_t getBinaryRecordSize(void);
+
     // This prints a header onto a stream - this removes need to pass around
     // very long string objects which can crash the logger
     virtual void printFileHeader(Stream *stream);
@@ -326,12 +474,106 @@ public:
     bool logToSD(String& rec);
     bool logToSD(void);
 
+    // These keep records in RAM and write them to the SD card together, so
+    // the card is only powered up and the file only opened once for several
+    // records.  The buffer is supplied by the user and should have room for
+    // at least the number of records to write together, ie:
+    //     uint8_t sdBuffer[6*80];
+    //     dataLogger.setSDWriteBuffer(sdBuffer, sizeof(sdBuffer), 6, 3600);
+    // The records are written when that many have been buffered, when the
+    // oldest buffered record is at least the maximum age (in seconds; 0 for
+    // no limit) old, when the next record doesn't fit, or when the battery is
+    // low.  Records still in the buffer are lost if the logger resets!
+    void setSDWriteBuffer(uint8_t buffer[], uint16_t bufferSize,
+                          uint8_t recordsPerWrite, uint32_t maxAgeSeconds = 0);
+    // This writes every record out immediately while the given variable
+    // (ie, a battery voltage) is below the minimum.
+    void setLowBatteryFlush(Variable *batteryVoltage, float minVoltage);
+    bool isBufferingSDWrites(void){return _logBuffer.isEnabled();}
+    // This writes out any buffered records, powering the SD card to do it.
+    // Call this before anything that could reset the logger.
+    bool flushSDWriteBuffer(void);
+
+    // This sets the log file to be created as one contiguous extent of the
+    // given size (in bytes) on the SD card, ie, enough for a day of records.
+    // Records are then written straight to the card's sectors at a position
+    // remembered in RAM, without searching for the file or setting its
+    // timestamps each time.  The unused end of the file is blank until
+    // the file is finished - when the file name changes, when the extent is
+    // full, or when finishPreallocatedFile() is called - and the file is cut
+    // down to its data.  With an automatic file name (generateAutoFileName()),
+    // the name follows the date, so each day's file is finished at the first
+    // record of the next day.  Records that don't fit are added the usual way.
+    // After a reset, the end of the data is found again from the blank space.
+    // NOTE:  A file that isn't finished (ie, the card was taken out without
+    // calling finishPreallocatedFile()) ends in a run of blank bytes, all
+    // 0x00 or all 0xFF depending on the card.  Anything reading a CSV file
+    // should stop at the first of them; the binary log decoder does.
+    // Give a size of 0 to turn this off.
+    void setPreallocatedFileSize(uint32_t fileSize);
+    // This cuts a preallocated file down to its data, powering the SD card
+    // to do it.  Call this before taking out the card.
+    bool finishPreallocatedFile(void);
+
+    // This turns on journaling of the data appended to the log file, so that
+    // a record cut off part way through by a power failure is repaired the
+    // next time the logger starts.  Each append is first written, with a
+    // sequence number and a CRC, into a small journal file on the card (see
+    // LogJournal.h) and only then copied onto the end of the log file.  When
+    // journaling is on, begin() checks the journal and, if the last append
+    // didn't finish, cuts the log file back to where it was and appends the
+    // data again.  The check only reads the journal, so it's quick no matter
+    // how big the log files get.
+    // NOTE:  This must be called before begin().  It does not apply to
+    // preallocated files, which find the end of their data on their own.
+    void setJournaling(bool enable){_journaling = enable;}
+    // This repairs the last append to the log file, if it didn't finish
+    bool recoverJournal(void);
+
 protected:
 
     // The SD card and file
     SdFat sd;
     File logFile;
     String _fileName;
+    // Whether the file name was made by generateAutoFileName()
+    bool _autoFileName;
+    logFileFormat _logFileFormat;
+
+    // The records waiting to be written to the SD card
+    LogBuffer _logBuffer;
+    uint8_t _recordsPerWrite;
+    uint32_t _maxBufferAgeSeconds;
+    uint32_t _firstBufferedEpoch;
+    Variable *_lowBatteryVar;
+    float _lowBatteryVoltage;
+    // This adds the current record to the RAM buffer, returning false if it
+    // doesn't fit
+    bool bufferRecord(void);
+    // This checks if the buffered records should be written out now
+    bool isSDWriteDue(void);
+
+    // The preallocated log file
+    ContiguousLogFile _contiguousFile;
+    uint32_t _preallocatedFileSize;
+    String _contiguousFileName;
+    // This gets the preallocated file ready to append to
+    bool prepareContiguousFile(void);
+    // This appends either the given bytes or, if there are none, the current
+    // record to the preallocated file
+    bool appendToContiguousFile(const uint8_t *data, uint16_t length);
+    // This cuts the preallocated file down to its data
+    bool finishContiguousFile(void);
+    // This returns the size of the binary schema block
+    uint32_t getBinaryFileHeaderSize(void);
+
+    // The journal of appends to the log file
+    LogJournal _journal;
+    bool _journaling;
+    bool _journalNeedsRecovery;
+    // This appends either the given bytes or, if there are none, the current
+    // record to the log file through the journal
+    bool journaledAppend(const uint8_t *data, uint16_t length);
 
     // This checks if the SD card is available and ready
     // We run this check before every communication with the SD card to prevent
@@ -349,6 +591,9 @@ protected:
     // character file name
     bool openFile(String& filename, bool createFile, bool writeDefaultHeader);
 
+    // This writes the current record straight to the log file
+    bool writeRecordToSD(void);
+
 
     // ===================================================================== //
     // Public functions for a "sensor testing" mode
@@ -40,6 +40,13 @@ loggerModem::loggerModem(int8_t powerPin, int8_t statusPin, bool statusLevel,
     _priorActivationDuration = 0;
     _priorPoweredDuration = 0;
 
+    _connectState = CONNECT_IDLE;
+    _connectStartTime = 0;
+    _maxConnectionTime = 0;
+    _connectTimerStarted = false;
+    _connectTimerStart = 0;
+    _nextConnectStepTime = 0;
+
     previousCommunicationFailed = false;
 }
 
@@ -409,6 +416,19 @@ bool loggerModem::isMeasurementComplete(bool debug)
 }
 
 
+// The modem's warm-up is timed, but stability and measurement completion
+// depend on the modem's responses.  Those are only checked every 250ms, so
+// the next step is due at the next check.
+uint32_t loggerModem::getNextStepTime(void)
+{
+    if (bitRead(_sensorStatus, 4) && !bitRead(_sensorStatus, 5))
+        return _lastATCheck + 250;
+    if (bitRead(_sensorStatus, 5)) return _lastConnectionCheck + 250;
+    if (bitRead(_sensorStatus, 3)) return millis();
+    return Sensor::getNextStepTime();
+}
+
+
 bool loggerModem::addSingleMeasurementResult(void)
 {
     bool success = true;
@@ -513,6 +533,155 @@ void loggerModem::modemPowerUp(void)
     _sensorStatus |= 0b00000110;
 }
 
+// This begins connecting to the internet in steps
+void loggerModem::startConnectInternet(uint32_t maxConnectionTime)
+{
+    MS_DBG(F("Starting to connect"), getSensorName(), F("to the internet..."));
+    // NOT yet powered
+    if (bitRead(_sensorStatus, 1) == 0 || bitRead(_sensorStatus, 2) == 0)
+    {
+        modemPowerUp();
+    }
+    _connectState = CONNECT_WARMING_UP;
+    _connectStartTime = millis();
+    _maxConnectionTime = maxConnectionTime;
+    _nextConnectStepTime = _connectStartTime;
+    _connectTimerStarted = false;
+}
+
+
+// This moves a stepped connection to the internet along
+sensorStepState loggerModem::connectInternetStep(void)
+{
+    if (_connectState == CONNECT_DONE) return STEP_DONE;
+    // Once registered, the data connection waits for finishConnectInternet()
+    if (_connectState == CONNECT_REGISTERED && !_connectTimerStarted)
+        return STEP_DONE;
+    if (_connectState == CONNECT_FAILED || _connectState == CONNECT_IDLE)
+        return STEP_FAILED;
+
+    uint32_t now = millis();
+    uint32_t elapsed = now - _connectStartTime;
+    // The time allowed for the connection only counts down once
+    // finishConnectInternet() is waiting on it, so a long sensor update
+    // doesn't use it up
+    uint32_t remaining = _maxConnectionTime;
+    if (_connectTimerStarted)
+    {
+        uint32_t waited = now - _connectTimerStart;
+        if (waited > _maxConnectionTime)
+        {
+            MS_DBG(F("Timed out connecting"), getSensorName(), F("to the internet!"));
+            _connectState = CONNECT_FAILED;
+            return STEP_FAILED;
+        }
+        remaining = _maxConnectionTime - waited;
+    }
+    _nextConnectStepTime = now + MS_MODEM_CONNECT_CHECK_MS;
+
+    switch (_connectState)
+    {
+        case CONNECT_WARMING_UP:
+        {
+            // The modem might already have been woken with the other sensors
+            if (bitRead(_sensorStatus, 3) == 1 && bitRead(_sensorStatus, 4) == 0)
+            {
+                MS_DBG(F("Modem did't wake up! Cannot connect to the internet!"));
+                _connectState = CONNECT_FAILED;
+                return STEP_FAILED;
+            }
+            if (bitRead(_sensorStatus, 3) == 0)
+            {
+                if (!isWarmedUp()) return STEP_PENDING;
+                if (!wake())
+                {
+                    MS_DBG(F("Modem did't wake up! Cannot connect to the internet!"));
+                    _connectState = CONNECT_FAILED;
+                    return STEP_FAILED;
+                }
+            }
+            _connectState = CONNECT_WAKING;
+            return STEP_PENDING;
+        }
+        case CONNECT_WAKING:
+        {
+            if (!didATRespond()) return STEP_PENDING;
+            MS_DBG(F("... AT OK after"), elapsed, F("milliseconds!"));
+            // Not yet setup
+            if (bitRead(_sensorStatus, 0) == 0 && !setup())
+            {
+                MS_DBG(F("Modem setup failed! Cannot connect to the internet!"));
+                _connectState = CONNECT_FAILED;
+                return STEP_FAILED;
+            }
+            _connectState = CONNECT_REGISTERING;
+            return STEP_PENDING;
+        }
+        case CONNECT_REGISTERING:
+        {
+            if (!isNetworkRegistered()) return STEP_PENDING;
+            MS_DBG(F("... Registered on the network after"), elapsed,
+                   F("milliseconds."));
+            _connectState = CONNECT_REGISTERED;
+            // The data connection blocks, so it isn't made while the sensors
+            // are being updated
+            if (!_connectTimerStarted) return STEP_DONE;
+            _nextConnectStepTime = now;
+            return STEP_PENDING;
+        }
+        case CONNECT_REGISTERED:
+        {
+            // Now that the modem is registered, this only needs to make the
+            // data connection
+            if (connectInternet(remaining))
+            {
+                _connectState = CONNECT_DONE;
+                return STEP_DONE;
+            }
+            _connectState = CONNECT_FAILED;
+            return STEP_FAILED;
+        }
+        default:
+        {
+            _connectState = CONNECT_FAILED;
+            return STEP_FAILED;
+        }
+    }
+}
+
+
+// This checks if a stepped connection to the internet is still in progress
+bool loggerModem::isConnectingInternet(void)
+{
+    return _connectState != CONNECT_IDLE && _connectState != CONNECT_DONE &&
+           _connectState != CONNECT_REGISTERED &&
+           _connectState != CONNECT_FAILED;
+}
+
+
+// This runs the rest of a stepped connection to the internet
+bool loggerModem::finishConnectInternet(void)
+{
+    // If nothing was started, connect the old way
+    if (_connectState == CONNECT_IDLE) return connectInternet();
+
+    // Start the clock on the time allowed for the connection
+    _connectTimerStarted = true;
+    _connectTimerStart = millis();
+
+    sensorStepState state = STEP_PENDING;
+    while (state == STEP_PENDING)
+    {
+        while ((int32_t)(millis() - _nextConnectStepTime) < 0) {}
+        state = connectInternetStep();
+    }
+    MS_DBG(getSensorName(), F("connection finished after"),
+           millis() - _connectStartTime, F("milliseconds."));
+    _connectState = CONNECT_IDLE;
+    return state == STEP_DONE;
+}
+
+
 void loggerModem::modemPowerDown(void)
 {
     if (_powerPin >= 0)
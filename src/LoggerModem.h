@@ -54,6 +54,24 @@
 #define MODEM_POWERED_VAR_NUM 7
 #define MODEM_POWERED_RESOLUTION 3
 
+// How often to check on the modem while connecting in steps, so it isn't
+// overwhelmed with AT commands
+#ifndef MS_MODEM_CONNECT_CHECK_MS
+#define MS_MODEM_CONNECT_CHECK_MS 250
+#endif
+
+// The stages of connecting to the internet in steps
+typedef enum modemConnectState
+{
+    CONNECT_IDLE = 0,     // No stepped connection has been started
+    CONNECT_WARMING_UP,   // Waiting for the modem to warm up so it can be woken
+    CONNECT_WAKING,       // Waiting for the modem to respond to AT commands
+    CONNECT_REGISTERING,  // Waiting for the modem to register on the network
+    CONNECT_REGISTERED,   // Registered, waiting to open the data connection
+    CONNECT_DONE,         // Connected to the internet
+    CONNECT_FAILED        // The connection failed or timed out
+} modemConnectState;
+
 /* ===========================================================================
 * Functions for the modem class
 * This is basically a wrapper for TinyGsm
@@ -108,6 +126,10 @@ protected:
     // push data.
     virtual bool isMeasurementComplete(bool debug = false) override;
 
+    // Because the modem's stability and measurement completion are based on
+    // its responses rather than on fixed times, those steps are polled.
+    virtual uint32_t getNextStepTime(void) override;
+
 
 // ==========================================================================//
 // These are the unique functions for the modem as an internet connected device
@@ -121,6 +143,25 @@ public:
     virtual bool connectInternet(uint32_t maxConnectionTime = 50000L) = 0;
     virtual void disconnectInternet(void) = 0;
 
+    // These connect to the internet a little at a time, so the connection can
+    // be made while something else (ie, the sensor updates) is going on.
+    // startConnectInternet() begins the connection and connectInternetStep()
+    // moves it along, returning STEP_PENDING until the modem is registered on
+    // the network (STEP_DONE) or the connection has failed.  The next step
+    // shouldn't be run before getNextConnectStepTime().  The data connection
+    // itself (the GPRS attach or WiFi join) can't be made a little at a time,
+    // so it is left for finishConnectInternet().
+    // finishConnectInternet() runs any steps that are left, waiting as
+    // needed, then calls connectInternet(), which by then only has to open
+    // the data connection, and returns whether the connection was made.  The
+    // maximum connection time is counted from the call to
+    // finishConnectInternet(), as it would be for connectInternet().
+    void startConnectInternet(uint32_t maxConnectionTime = 50000L);
+    sensorStepState connectInternetStep(void);
+    uint32_t getNextConnectStepTime(void){return _nextConnectStepTime;}
+    bool isConnectingInternet(void);
+    bool finishConnectInternet(void);
+
     // Get values by other names
     virtual bool getModemSignalQuality(int16_t &rssi, int16_t &percent) = 0;
     virtual bool getModemBatteryStats(uint8_t &chargeState, int8_t &percent, uint16_t &milliVolts) = 0;
@@ -161,6 +202,7 @@ protected:
     virtual void modemHardReset(void);
     virtual bool didATRespond(void) = 0;
     virtual bool isInternetAvailable(void) = 0;
+    virtual bool isNetworkRegistered(void) = 0;
     virtual bool verifyMeasurementComplete(bool debug = false) = 0;
     virtual bool modemSleepFxn(void) = 0;
     virtual bool modemWakeFxn(void) = 0;
@@ -195,6 +237,14 @@ protected:
     float _priorActivationDuration;
     float _priorPoweredDuration;
 
+    // The state of a stepped connection to the internet
+    modemConnectState _connectState;
+    uint32_t _connectStartTime;
+    uint32_t _maxConnectionTime;
+    bool _connectTimerStarted;
+    uint32_t _connectTimerStart;
+    uint32_t _nextConnectStepTime;
+
     String _modemName;
 
 };
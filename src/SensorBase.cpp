@@ -54,10 +54,33 @@ Sensor::Sensor(const char *sensorName, const uint8_t numReturnedVars,
         sensorValues[i] = -9999;
         numberGoodMeasurementsMade[i] = 0;
     }
+    _firstStatistics = NULL;
+
+    // Use the plain mean unless told otherwise
+    _averagingMode = AVERAGE_MEAN;
+    _sampleBuffer = NULL;
+    _samplesPerResult = 0;
+    _averagingParameter = 0;
+
+    // Adaptive averaging is off by default
+    _adaptiveTarget = 0;
+    _adaptiveMin = measurementsToAverage;
+    _fixedMeasurementsToAverage = measurementsToAverage;
+    _adaptiveResult = 0;
+    _recentVariance = -1;
+    _cycleCount = 0;
+    _cycleMean = 0;
+    _cycleM2 = 0;
 
     // Reset the sensor status
     _sensorStatus = 0;
 
+    // Make sure no step is marked as pending
+    _stepPending = false;
+    _millisStepRetry = 0;
+    _stepAttempts = 0;
+    _stepPhase = 0;
+
     // MS_DBG(F("Sensor object created"));
 }
 // Destructor
@@ -93,10 +116,112 @@ int8_t Sensor::getPowerPin(void){return _powerPin;}
 void Sensor::setNumberMeasurementsToAverage(int nReadings)
 {
     _measurementsToAverage = nReadings;
+    // Keep it for when adaptive averaging is turned off again
+    if (_adaptiveTarget != 0) _fixedMeasurementsToAverage = nReadings;
 }
 uint8_t Sensor::getNumberMeasurementsToAverage(void){return _measurementsToAverage;}
 
 
+// This sets how the readings are combined, and where they are kept
+bool Sensor::setAveragingMode(averagingMode mode, float sampleBuffer[],
+                              uint16_t bufferSize, float parameter)
+{
+    if (mode != AVERAGE_MEAN && (sampleBuffer == NULL || bufferSize < _numReturnedVars))
+    {
+        MS_DBG(F("A sample buffer is needed for any averaging but the mean!"));
+        _averagingMode = AVERAGE_MEAN;
+        _sampleBuffer = NULL;
+        _samplesPerResult = 0;
+        return false;
+    }
+
+    _averagingMode = mode;
+    _averagingParameter = parameter;
+    if (mode == AVERAGE_MEAN)
+    {
+        _sampleBuffer = NULL;
+        _samplesPerResult = 0;
+    }
+    else
+    {
+        _sampleBuffer = sampleBuffer;
+        uint16_t perResult = bufferSize / _numReturnedVars;
+        _samplesPerResult = perResult > 255 ? 255 : perResult;
+        if (_samplesPerResult < _measurementsToAverage)
+        {
+            MS_DBG(F("The sample buffer only has room for"), _samplesPerResult,
+                   F("of"), _measurementsToAverage, F("readings!"));
+        }
+    }
+    return true;
+}
+
+
+
+// This turns on (or off) adaptive averaging
+void Sensor::setAdaptiveAveraging(float targetStdError, uint8_t minReadings,
+                                  uint8_t maxReadings, uint8_t resultNumber)
+{
+    bool wasAdaptive = _adaptiveTarget > 0;
+    _adaptiveTarget = targetStdError > 0 ? targetStdError : 0;
+    if (_adaptiveTarget == 0)
+    {
+        // Go back to the number of readings set before adaptive averaging
+        if (wasAdaptive) _measurementsToAverage = _fixedMeasurementsToAverage;
+        return;
+    }
+    if (!wasAdaptive) _fixedMeasurementsToAverage = _measurementsToAverage;
+
+    if (minReadings < 1) minReadings = 1;
+    if (maxReadings < minReadings) maxReadings = minReadings;
+    _adaptiveMin = minReadings;
+    _measurementsToAverage = maxReadings;
+    _adaptiveResult = resultNumber < _numReturnedVars ? resultNumber : 0;
+    _recentVariance = -1;
+}
+
+
+// This checks if enough readings have been made
+bool Sensor::isAveragingComplete(uint8_t nReadingsMade)
+{
+    if (nReadingsMade >= _measurementsToAverage) return true;
+    if (_adaptiveTarget == 0 || nReadingsMade < _adaptiveMin) return false;
+    if (_cycleCount == 0) return false;
+
+    // Pool the variance of this update's readings with the running estimate
+    float varianceEstimate;
+    float cycleDoF = _cycleCount - 1;
+    if (_recentVariance < 0)
+    {
+        // With no history, we need at least two good readings to say anything
+        if (_cycleCount < 2) return false;
+        varianceEstimate = _cycleM2 / cycleDoF;
+    }
+    else
+    {
+        varianceEstimate = (_cycleM2 + MS_ADAPTIVE_HISTORY_READINGS*_recentVariance) /
+                           (cycleDoF + MS_ADAPTIVE_HISTORY_READINGS);
+    }
+
+    // The squared standard error of the mean is the variance over the count
+    bool done = varianceEstimate <= _adaptiveTarget*_adaptiveTarget*_cycleCount;
+    if (done)
+    {
+        MS_DBG(getSensorNameAndLocation(), F("reached the target standard error after"),
+               nReadingsMade, F("reading[s]"));
+    }
+    return done;
+}
+
+
+// This returns the shortest time the sensor must be powered to get all readings
+uint32_t Sensor::getMinimumPoweredTime(void)
+{
+    return _warmUpTime_ms + _stabilizationTime_ms +
+           (uint32_t)_measurementsToAverage*_measurementTime_ms;
+}
+
+
 // This returns the 8-bit code for the current status of the sensor.
 // Bit 0 - 0=Has NOT been set up, 1=Has been setup
 // Bit 1 - 0=No attempt made to power sensor, 1=Attempt made to power sensor
@@ -153,6 +278,8 @@ void Sensor::powerDown(void)
         // Unset the status bits for sensor power (bits 1 & 2),
         // activation (bits 3 & 4), and measurement request (bits 5 & 6)
         _sensorStatus &= 0b10000001;
+        // Abandon any step that was in progress
+        finishStep(false);
     }
     else
     {
@@ -276,6 +403,59 @@ bool Sensor::startSingleMeasurement(void)
 }
 
 
+// These are the default non-blocking steps.  For sensors that don't need to
+// wait in the middle of a step, they just call the regular functions.
+sensorStepState Sensor::wakeStep(void)
+{
+    return wake() ? STEP_DONE : STEP_FAILED;
+}
+sensorStepState Sensor::startMeasurementStep(void)
+{
+    return startSingleMeasurement() ? STEP_DONE : STEP_FAILED;
+}
+sensorStepState Sensor::addResultStep(void)
+{
+    return addSingleMeasurementResult() ? STEP_DONE : STEP_FAILED;
+}
+sensorStepState Sensor::sleepStep(void)
+{
+    return sleep() ? STEP_DONE : STEP_FAILED;
+}
+
+
+// This marks a step as pending until the given time
+sensorStepState Sensor::retryStepAt(uint32_t retryTime)
+{
+    _stepPending = true;
+    _millisStepRetry = retryTime;
+    return STEP_PENDING;
+}
+
+
+// This marks a step as finished and clears the step tracking
+sensorStepState Sensor::finishStep(bool success)
+{
+    _stepPending = false;
+    _millisStepRetry = 0;
+    _stepAttempts = 0;
+    _stepPhase = 0;
+    return success ? STEP_DONE : STEP_FAILED;
+}
+
+
+// This runs a step until it is finished
+bool Sensor::runStepToCompletion(sensorStepState (Sensor::*stepFxn)(void))
+{
+    sensorStepState state = (this->*stepFxn)();
+    while (state == STEP_PENDING)
+    {
+        while ((int32_t)(millis() - _millisStepRetry) < 0) {}
+        state = (this->*stepFxn)();
+    }
+    return state == STEP_DONE;
+}
+
+
 void Sensor::registerVariable(int sensorVarNum, Variable* var)
 {
     variables[sensorVarNum] = var;
@@ -320,6 +500,20 @@ void Sensor::notifyVariables(void)
                    F("!  No update sent!"));
         }
     }
+
+    // Notify any variables attached to statistics of the results
+    for (ResultStatistics *stats = _firstStatistics; stats != NULL; stats = stats->nextStatistics)
+    {
+        stats->notifyVariables();
+    }
+}
+
+
+// This adds a statistics accumulator to the list for the sensor
+void Sensor::registerStatistics(ResultStatistics *stats)
+{
+    stats->nextStatistics = _firstStatistics;
+    _firstStatistics = stats;
 }
 
 
@@ -332,12 +526,43 @@ void Sensor::clearValues(void)
         sensorValues[i] =  -9999;
         numberGoodMeasurementsMade[i] = 0;
     }
+    for (ResultStatistics *stats = _firstStatistics; stats != NULL; stats = stats->nextStatistics)
+    {
+        stats->clear();
+    }
+    _cycleCount = 0;
+    _cycleMean = 0;
+    _cycleM2 = 0;
 }
 
 
 // This verifies that a measurement is good before adding it to the values to be averaged
 void Sensor::verifyAndAddMeasurementResult(uint8_t resultNumber, float resultValue)
 {
+    // Give the result to any statistics for it, whether it's good or bad
+    for (ResultStatistics *stats = _firstStatistics; stats != NULL; stats = stats->nextStatistics)
+    {
+        if (stats->sensorVarNum == resultNumber) stats->addResult(resultValue);
+    }
+
+    // Track the variance of the result used for adaptive averaging
+    if (_adaptiveTarget > 0 && resultNumber == _adaptiveResult &&
+        resultValue != -9999 && _cycleCount < 255)
+    {
+        _cycleCount++;
+        float delta = resultValue - _cycleMean;
+        _cycleMean += delta / _cycleCount;
+        _cycleM2 += delta * (resultValue - _cycleMean);
+    }
+
+    // Keep good readings in the sample buffer, if there's room
+    if (_sampleBuffer != NULL && resultValue != -9999 &&
+        numberGoodMeasurementsMade[resultNumber] < _samplesPerResult)
+    {
+        _sampleBuffer[resultNumber*_samplesPerResult +
+                      numberGoodMeasurementsMade[resultNumber]] = resultValue;
+    }
+
     // If the new result is good and there was were only bad results, set the
     // result value as the new result and add 1 to the good result total
     if (sensorValues[resultNumber] == -9999 and resultValue != -9999)
@@ -382,15 +607,139 @@ void Sensor::averageMeasurements(void)
 {
     MS_DBG(F("Averaging results from"), getSensorNameAndLocation(),
            F("over"), _measurementsToAverage, F("reading[s]"));
+
+    // Fold the variance from this update into the running estimate for
+    // adaptive averaging
+    if (_adaptiveTarget > 0 && _cycleCount >= 2)
+    {
+        float cycleVariance = _cycleM2 / (_cycleCount - 1);
+        if (_recentVariance < 0) _recentVariance = cycleVariance;
+        else _recentVariance += MS_ADAPTIVE_VARIANCE_WEIGHT*(cycleVariance - _recentVariance);
+        MS_DBG(F("  Running variance estimate:"), _recentVariance);
+    }
     for (uint8_t i = 0; i < _numReturnedVars; i++)
     {
-        if (numberGoodMeasurementsMade[i] > 0)
-            sensorValues[i] /=  numberGoodMeasurementsMade[i];
+        uint8_t nGood = numberGoodMeasurementsMade[i];
+        if (nGood > 0 && _averagingMode != AVERAGE_MEAN && _sampleBuffer != NULL)
+        {
+            // Only the readings that fit in the buffer can be used
+            if (nGood > _samplesPerResult) nGood = _samplesPerResult;
+            float *samples = &_sampleBuffer[i*_samplesPerResult];
+            sortSamples(samples, nGood);
+            switch (_averagingMode)
+            {
+                case AVERAGE_MEDIAN:
+                    sensorValues[i] = medianOfSorted(samples, nGood);
+                    break;
+                case AVERAGE_TRIMMED_MEAN:
+                    sensorValues[i] = trimmedMeanOfSorted(samples, nGood,
+                        _averagingParameter > 0 ? _averagingParameter : MS_DEFAULT_TRIM_FRACTION);
+                    break;
+                default:
+                    sensorValues[i] = madRejectMeanOfSorted(samples, nGood,
+                        _averagingParameter > 0 ? _averagingParameter : MS_DEFAULT_MAD_THRESHOLD);
+                    break;
+            }
+        }
+        else if (nGood > 0)
+            sensorValues[i] /=  nGood;
         MS_DBG(F("    ->Result #"), i, ':', sensorValues[i]);
     }
 }
 
 
+// This sorts a small number of readings in place (insertion sort)
+void Sensor::sortSamples(float samples[], uint8_t count)
+{
+    for (uint8_t i = 1; i < count; i++)
+    {
+        float value = samples[i];
+        uint8_t j = i;
+        while (j > 0 && samples[j-1] > value)
+        {
+            samples[j] = samples[j-1];
+            j--;
+        }
+        samples[j] = value;
+    }
+}
+
+
+// This returns the median of sorted readings
+float Sensor::medianOfSorted(float samples[], uint8_t count)
+{
+    if (count == 0) return -9999;
+    if (count % 2 == 1) return samples[count/2];
+    return (samples[count/2 - 1] + samples[count/2]) / 2;
+}
+
+
+// This returns the mean of sorted readings after dropping the given fraction
+// of readings from each end.  At least one reading (or two, for an even
+// number) in the middle is always kept.
+float Sensor::trimmedMeanOfSorted(float samples[], uint8_t count, float trimFraction)
+{
+    if (count == 0) return -9999;
+    uint8_t nTrim = trimFraction * count;
+    if (2*nTrim >= count) nTrim = (count - 1)/2;
+    float sum = 0;
+    for (uint8_t i = nTrim; i < count - nTrim; i++) sum += samples[i];
+    return sum / (count - 2*nTrim);
+}
+
+
+// This returns the mean of sorted readings after rejecting any more than the
+// threshold number of scaled median absolute deviations (MAD) from the median.
+// The MAD is scaled by 1.4826 so it is comparable to a standard deviation for
+// normally distributed readings.  If over half the readings are identical the
+// MAD is zero, and only readings equal to the median are kept.
+float Sensor::madRejectMeanOfSorted(float samples[], uint8_t count, float threshold)
+{
+    if (count == 0) return -9999;
+    float median = medianOfSorted(samples, count);
+
+    // Because the readings are sorted, the deviations from the median increase
+    // moving outwards on either side of the middle.  Merging the two sides
+    // from the middle out gives the deviations in order, so the median
+    // deviation can be found without another buffer.
+    int16_t lo = (count - 1)/2;  // the next reading below the middle
+    int16_t hi = lo + 1;  // the next reading above the middle
+    float devLow = 0;  // the lower of the middle deviations (even counts)
+    float dev = 0;
+    for (uint8_t k = 0; k <= count/2; k++)
+    {
+        devLow = dev;
+        if (hi >= count || (lo >= 0 && median - samples[lo] <= samples[hi] - median))
+        {
+            dev = median - samples[lo];
+            lo--;
+        }
+        else
+        {
+            dev = samples[hi] - median;
+            hi++;
+        }
+    }
+    float mad = (count % 2 == 1) ? dev : (devLow + dev) / 2;
+    float limit = threshold * 1.4826 * mad;
+    MS_DBG(F("    Median:"), median, F("MAD:"), mad);
+
+    float sum = 0;
+    uint8_t nKept = 0;
+    for (uint8_t i = 0; i < count; i++)
+    {
+        if (fabs(samples[i] - median) <= limit)
+        {
+            sum += samples[i];
+            nKept++;
+        }
+    }
+    MS_DBG(F("    Rejected"), count - nKept, F("of"), count, F("readings"));
+    if (nKept == 0) return median;  // Only possible with a tiny threshold
+    return sum / nKept;
+}
+
+
 // This updates a sensor value by checking it's power, waking it, taking as many
 // readings as requested, then putting the sensor to sleep and powering down.
 bool Sensor::update(void)
@@ -427,6 +776,8 @@ bool Sensor::update(void)
         waitForMeasurementCompletion();
         // get the measurement result
         ret_val += addSingleMeasurementResult();
+        // stop early if there are enough readings
+        if (isAveragingComplete(j + 1)) break;
     }
 
     averageMeasurements();
@@ -571,3 +922,128 @@ bool Sensor::isMeasurementComplete(bool debug)
 // This delays until enough time has passed for the sensor to give a new value
 // NOTE:  This is "blocking" - that is, nothing else can happen during this wait.
 void Sensor::waitForMeasurementCompletion(void){ while (!isMeasurementComplete()){} }
+
+
+// This returns the time when the next timed step for the sensor should be done
+// NOTE:  The "is" functions all check for elapsed time *greater than* the
+// required time, so one extra millisecond is added to each deadline.
+uint32_t Sensor::getNextStepTime(void)
+{
+    // If a step is pending, the next step is to call it again
+    if (_stepPending) return _millisStepRetry;
+
+    // If no attempt has been made to wake the sensor, the next step is waking
+    // it, which can happen as soon as it is warmed up.  If the sensor has no
+    // power it will never warm up, so it's due now.
+    if (!bitRead(_sensorStatus, 3))
+    {
+        if (!bitRead(_sensorStatus, 2)) return millis();
+        return _millisPowerOn + _warmUpTime_ms + 1;
+    }
+
+    // If the wake failed, there's nothing to wait for
+    if (!bitRead(_sensorStatus, 4)) return millis();
+
+    // If no attempt has been made to start a measurement, we're waiting for
+    // the sensor to stabilize
+    if (!bitRead(_sensorStatus, 5))
+        return _millisSensorActivated + _stabilizationTime_ms + 1;
+
+    // If a measurement was successfully started, we're waiting for it to finish
+    if (bitRead(_sensorStatus, 6))
+        return _millisMeasurementRequested + _measurementTime_ms + 1;
+
+    // Otherwise, the measurement start failed and there's nothing to wait for
+    return millis();
+}
+
+
+// ============================================================================
+//  The class and functions for keeping statistics of a sensor result
+// ============================================================================
+
+ResultStatistics::ResultStatistics(Sensor *parentSense, uint8_t sensorVarNum)
+  : parentSensor(parentSense), sensorVarNum(sensorVarNum)
+{
+    nextStatistics = NULL;
+    for (uint8_t i = 0; i < STAT_NUM_TYPES; i++) _variables[i] = NULL;
+    clear();
+    parentSensor->registerStatistics(this);
+}
+
+
+// This clears the accumulator
+void ResultStatistics::clear(void)
+{
+    _goodCount = 0;
+    _badCount = 0;
+    _mean = 0;
+    _M2 = 0;
+    _min = 0;
+    _max = 0;
+}
+
+
+// This adds a reading, updating the mean and sum of squares with Welford's method
+void ResultStatistics::addResult(float resultValue)
+{
+    if (resultValue == -9999)
+    {
+        if (_badCount < 255) _badCount++;
+        return;
+    }
+    if (_goodCount == 255) return;
+
+    _goodCount++;
+    float delta = resultValue - _mean;
+    _mean += delta / _goodCount;
+    _M2 += delta * (resultValue - _mean);
+
+    if (_goodCount == 1 || resultValue < _min) _min = resultValue;
+    if (_goodCount == 1 || resultValue > _max) _max = resultValue;
+}
+
+
+float ResultStatistics::getMean(void)
+{
+    if (_goodCount == 0) return -9999;
+    return _mean;
+}
+
+
+// This is the sample standard deviation, so it needs at least two readings
+float ResultStatistics::getStandardDeviation(void)
+{
+    if (_goodCount < 2) return -9999;
+    return sqrt(_M2 / (_goodCount - 1));
+}
+
+
+float ResultStatistics::getStatistic(uint8_t statistic)
+{
+    switch (statistic)
+    {
+        case STAT_MEAN: return getMean();
+        case STAT_STDEV: return getStandardDeviation();
+        case STAT_MIN: return getMin();
+        case STAT_MAX: return getMax();
+        case STAT_GOOD_COUNT: return _goodCount;
+        case STAT_BAD_COUNT: return _badCount;
+        default: return -9999;
+    }
+}
+
+
+void ResultStatistics::registerVariable(uint8_t statistic, Variable* var)
+{
+    if (statistic < STAT_NUM_TYPES) _variables[statistic] = var;
+}
+
+
+void ResultStatistics::notifyVariables(void)
+{
+    for (uint8_t i = 0; i < STAT_NUM_TYPES; i++)
+    {
+        if (_variables[i] != NULL) _variables[i]->onSensorUpdate(parentSensor);
+    }
+}
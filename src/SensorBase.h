@@ -26,8 +26,50 @@
 // The largest number of variables from a single sensor
 #define MAX_NUMBER_VARS 8
 
+// The default fraction of readings dropped from *each* end for a trimmed mean
+#ifndef MS_DEFAULT_TRIM_FRACTION
+#define MS_DEFAULT_TRIM_FRACTION 0.2
+#endif
+
+// The default number of scaled median absolute deviations from the median
+// beyond which a reading is rejected as an outlier
+#ifndef MS_DEFAULT_MAD_THRESHOLD
+#define MS_DEFAULT_MAD_THRESHOLD 3.0
+#endif
+
+// For adaptive averaging, the weight (0-1) given to the variance of the
+// newest update cycle in the running estimate of a sensor's variance
+#ifndef MS_ADAPTIVE_VARIANCE_WEIGHT
+#define MS_ADAPTIVE_VARIANCE_WEIGHT 0.3
+#endif
+
+// For adaptive averaging, the number of readings the running variance
+// estimate counts as when pooled with the readings of the current cycle
+#ifndef MS_ADAPTIVE_HISTORY_READINGS
+#define MS_ADAPTIVE_HISTORY_READINGS 4
+#endif
+
 
 class Variable;  // Forward declaration
+class ResultStatistics;  // Forward declaration
+
+// These are the ways the readings of each result can be combined in
+// averageMeasurements()
+typedef enum averagingMode
+{
+    AVERAGE_MEAN = 0,       // The arithmetic mean of the good readings
+    AVERAGE_MEDIAN,         // The median of the good readings
+    AVERAGE_TRIMMED_MEAN,   // The mean after dropping the highest and lowest readings
+    AVERAGE_MAD_REJECT      // The mean after dropping readings far from the median
+} averagingMode;
+
+// These are the results of the non-blocking "step" functions
+typedef enum sensorStepState
+{
+    STEP_FAILED = 0,  // The step is finished, but it failed
+    STEP_DONE,        // The step is finished and succeeded
+    STEP_PENDING      // The step is not finished; call it again at getNextStepTime()
+} sensorStepState;
 
 // Defines the "Sensor" Class
 class Sensor
@@ -54,6 +96,42 @@ public:
     void setNumberMeasurementsToAverage(int nReadings);
     uint8_t getNumberMeasurementsToAverage(void);
 
+    // This sets how the readings for each result are combined.  Anything but
+    // the mean needs each reading to be kept, so it needs a sample buffer with
+    // room for at least the number of results times the number of
+    // measurements to average, ie:
+    //     float obs3Samples[OBS3_NUM_VARIABLES*10];
+    //     osb3.setAveragingMode(AVERAGE_MEDIAN, obs3Samples, OBS3_NUM_VARIABLES*10);
+    // If more readings are made than fit, only the first ones are used.
+    // The parameter is the fraction of readings dropped from each end for a
+    // trimmed mean, or the number of (scaled) median absolute deviations from
+    // the median to allow for outlier rejection; 0 uses the defaults.
+    // Returns false (and keeps using the mean) if the buffer is missing.
+    bool setAveragingMode(averagingMode mode, float sampleBuffer[] = NULL,
+                          uint16_t bufferSize = 0, float parameter = 0);
+    averagingMode getAveragingMode(void){return _averagingMode;}
+
+    // This sets the number of readings to average to adapt to how noisy the
+    // sensor has been.  Readings of the given result are taken until the
+    // standard error of their mean is expected to be within the target, but
+    // never fewer than the minimum or more than the maximum.  The variance is
+    // estimated from the readings so far in the update, pooled with a running
+    // estimate from earlier updates.
+    // This sets the number of measurements to average to the maximum; turn it
+    // off by giving a target of 0, which goes back to the number of
+    // measurements to average set before it was turned on.
+    void setAdaptiveAveraging(float targetStdError, uint8_t minReadings,
+                              uint8_t maxReadings, uint8_t resultNumber = 0);
+    // This checks if enough readings have been made in the current update.
+    // Without adaptive averaging this is when all of the measurements to
+    // average have been made.
+    bool isAveragingComplete(uint8_t nReadingsMade);
+
+    // This returns the shortest time (in ms) that the sensor must be powered
+    // to warm up, stabilize, and take all of the measurements to be averaged.
+    // This is used to plan when each power pin should be turned on.
+    uint32_t getMinimumPoweredTime(void);
+
     // This returns the 8-bit code for the current status of the sensor.
     // Bit 0 - 0=Has NOT been successfully set up, 1=Has been setup
     // Bit 1 - 0=No attempt made to power sensor, 1=Attempt made to power sensor
@@ -120,6 +198,21 @@ public:
     // The waits are NOT included in this function!
     virtual bool addSingleMeasurementResult(void) = 0;
 
+    // These are non-blocking versions of wake(), startSingleMeasurement(),
+    // addSingleMeasurementResult(), and sleep().  Instead of delaying, a sensor
+    // that needs to wait in the middle of a step returns STEP_PENDING and
+    // getNextStepTime() returns the time the step should be called again.
+    // While a step is pending, the status bits for that step are left
+    // unchanged - they are only set once the step is finished.  This lets the
+    // variable array work on other sensors while one is waiting.
+    // By default, these just call the blocking functions.
+    virtual sensorStepState wakeStep(void);
+    virtual sensorStepState startMeasurementStep(void);
+    virtual sensorStepState addResultStep(void);
+    virtual sensorStepState sleepStep(void);
+    // This checks if a step is currently pending
+    bool isStepPending(void){return _stepPending;}
+
     // This is the array of result values for each sensor
     float sensorValues[MAX_NUMBER_VARS];
     // This is a string with a pretty-print of the values array
@@ -135,6 +228,9 @@ public:
     void registerVariable(int sensorVarNum, Variable* var);
     // Notifies attached variables of new values
     void notifyVariables(void);
+    // This attaches a statistics accumulator to one of the sensor's results
+    // It is called by the ResultStatistics constructor.
+    void registerStatistics(ResultStatistics *stats);
 
     // The "isWarmedUp()" function checks whether or not enough time has passed
     // between the sensor receiving power and being ready to respond to logger
@@ -157,6 +253,16 @@ public:
     virtual bool isMeasurementComplete(bool debug=false);
     void waitForMeasurementCompletion(void);
 
+    // The "getNextStepTime()" function returns the millis() time stamp at
+    // which the next timed step for the sensor (warm-up, stabilization, or
+    // measurement completion) is expected to be finished, based on the current
+    // status bits.  This is used by the variable array to schedule sensors in
+    // order of their deadlines instead of constantly re-polling all of them.
+    // If the step is not timed or the sensor is in a failed state, the current
+    // time is returned.  The is___() functions still have the final word - the
+    // deadline is only the earliest time that it is worth checking them.
+    virtual uint32_t getNextStepTime(void);
+
 
 protected:
 
@@ -167,6 +273,33 @@ protected:
     uint8_t _measurementsToAverage;
     uint8_t numberGoodMeasurementsMade[MAX_NUMBER_VARS];
 
+    // These are for combining readings in some way other than the mean
+    // The sample buffer is provided by the user, with _samplesPerResult
+    // readings of the first result, then of the second, and so on.
+    averagingMode _averagingMode;
+    float *_sampleBuffer;
+    uint8_t _samplesPerResult;
+    float _averagingParameter;
+    // These reduce the readings in a slice of the sample buffer to one value
+    // NOTE:  They sort the readings in place.
+    static void sortSamples(float samples[], uint8_t count);
+    static float medianOfSorted(float samples[], uint8_t count);
+    static float trimmedMeanOfSorted(float samples[], uint8_t count, float trimFraction);
+    static float madRejectMeanOfSorted(float samples[], uint8_t count, float threshold);
+
+    // These are for adaptive averaging
+    // The variance and readings of the adaptive result in the current update
+    // are kept with Welford's method.  A running variance below 0 means no
+    // earlier update has given an estimate yet.
+    float _adaptiveTarget;
+    uint8_t _adaptiveMin;
+    uint8_t _fixedMeasurementsToAverage;  // restored when turned off
+    uint8_t _adaptiveResult;
+    float _recentVariance;
+    uint8_t _cycleCount;
+    float _cycleMean;
+    float _cycleM2;
+
     // This is the time needed from the when a sensor has power until it's ready to talk
     // The _millisPowerOn value is set in the powerUp() function.  It is
     // un-set in the powerDown() function.
@@ -190,11 +323,90 @@ protected:
     // This is an 8-bit code for the sensor status
     uint8_t _sensorStatus;
 
+    // These keep track of a non-blocking step that is not yet finished
+    // _stepAttempts and _stepPhase are for the sensor's own use in keeping
+    // track of retries and multi-part steps; they are zeroed when a step finishes.
+    bool _stepPending;
+    uint32_t _millisStepRetry;
+    uint8_t _stepAttempts;
+    uint8_t _stepPhase;
+    // This marks the current step as pending until the given time
+    sensorStepState retryStepAt(uint32_t retryTime);
+    // This marks the current step as finished
+    sensorStepState finishStep(bool success);
+    // This runs a step function over and over until it is finished, waiting
+    // as requested between calls.  This is used by the blocking functions.
+    // NOTE:  This is "blocking" - that is, nothing else can happen during this wait.
+    bool runStepToCompletion(sensorStepState (Sensor::*stepFxn)(void));
+
     // This is an array for each sensor containing the variable objects tied
     // to that sensor.  The MAX_NUMBER_VARS cannot be determined on a per-sensor
     // basis, because of the way memory is used on an Arduino.  It must be
     // defined once for the whole class.
     Variable *variables[MAX_NUMBER_VARS];
+
+    // This is the first of a list of statistics accumulators attached to the
+    // sensor's results.  There are none unless the user creates them.
+    ResultStatistics *_firstStatistics;
+};
+
+
+// These are the statistics available from a ResultStatistics accumulator
+typedef enum resultStatistic
+{
+    STAT_MEAN = 0,     // The mean of the good readings
+    STAT_STDEV,        // The sample standard deviation of the good readings
+    STAT_MIN,          // The smallest good reading
+    STAT_MAX,          // The largest good reading
+    STAT_GOOD_COUNT,   // The number of good readings
+    STAT_BAD_COUNT,    // The number of bad (-9999) readings
+    STAT_NUM_TYPES
+} resultStatistic;
+
+
+// This keeps running statistics of all of the readings of one result from a
+// sensor in an update cycle, without storing the individual readings.  The
+// mean and variance are kept using Welford's method, so they are accurate
+// even when the spread is tiny compared to the values.
+// These are opt-in:  create one for a sensor result and then create Variables
+// from it for any of the statistics to be reported.  The statistics are
+// reset by clearValues() and sent to their variables by notifyVariables(),
+// along with the sensor's other variables.
+class ResultStatistics
+{
+public:
+    ResultStatistics(Sensor *parentSense, uint8_t sensorVarNum);
+
+    // This clears the accumulator
+    void clear(void);
+    // This adds a reading to the accumulator; -9999 is counted as bad
+    void addResult(float resultValue);
+
+    // This returns one of the statistics, or -9999 if it isn't available
+    float getStatistic(uint8_t statistic);
+    float getMean(void);
+    float getStandardDeviation(void);
+    float getMin(void){return _goodCount > 0 ? _min : -9999;}
+    float getMax(void){return _goodCount > 0 ? _max : -9999;}
+    uint8_t getGoodCount(void){return _goodCount;}
+    uint8_t getBadCount(void){return _badCount;}
+
+    // These tie the statistics to their variables
+    void registerVariable(uint8_t statistic, Variable* var);
+    void notifyVariables(void);
+
+    Sensor *parentSensor;
+    const uint8_t sensorVarNum;
+    ResultStatistics *nextStatistics;
+
+private:
+    uint8_t _goodCount;
+    uint8_t _badCount;
+    float _mean;
+    float _M2;  // The sum of squares of the differences from the mean
+    float _min;
+    float _max;
+    Variable *_variables[STAT_NUM_TYPES];
 };
 
 #endif  // Header Guard
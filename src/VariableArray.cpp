@@ -8,21 +8,31 @@
 */
 
 #include "VariableArray.h"
+#include "LoggerModem.h"
 
 
 // Constructors
-VariableArray::VariableArray(){}
+VariableArray::VariableArray()
+{
+    _idleSleep = false;
+    _staggerPowerUp = false;
+    setPowerPinCurrents(NULL, NULL, 0);
+}
 VariableArray::VariableArray(uint8_t variableCount, Variable *variableList[])
   : arrayOfVars(variableList), _variableCount(variableCount)
 {
-    _maxSamplestoAverage = countMaxToAverage();
-    _sensorCount = getSensorCount();
+    _idleSleep = false;
+    _staggerPowerUp = false;
+    setPowerPinCurrents(NULL, NULL, 0);
+    buildSensorPlan();
 }
 VariableArray::VariableArray(uint8_t variableCount, Variable *variableList[], const char *uuids[])
   : arrayOfVars(variableList), _variableCount(variableCount)
 {
-    _maxSamplestoAverage = countMaxToAverage();
-    _sensorCount = getSensorCount();
+    _idleSleep = false;
+    _staggerPowerUp = false;
+    setPowerPinCurrents(NULL, NULL, 0);
+    buildSensorPlan();
     matchUUIDs(uuids);
 }
 
@@ -34,8 +44,7 @@ void VariableArray::VariableArray::begin(uint8_t variableCount, Variable *variab
     _variableCount = variableCount;
     arrayOfVars = variableList;
 
-    _maxSamplestoAverage = countMaxToAverage();
-    _sensorCount = getSensorCount();
+    buildSensorPlan();
     matchUUIDs(uuids);
     checkVariableUUIDs();
 }
@@ -44,14 +53,12 @@ void VariableArray::begin(uint8_t variableCount, Variable *variableList[])
     _variableCount = variableCount;
     arrayOfVars = variableList;
 
-    _maxSamplestoAverage = countMaxToAverage();
-    _sensorCount = getSensorCount();
+    buildSensorPlan();
     checkVariableUUIDs();
 }
 void VariableArray::begin()
 {
-    _maxSamplestoAverage = countMaxToAverage();
-    _sensorCount = getSensorCount();
+    buildSensorPlan();
     checkVariableUUIDs();
 }
 
@@ -69,17 +76,12 @@ uint8_t VariableArray::getCalculatedVariableCount(void)
 }
 
 
-// This counts and returns the number of sensors
+// This returns the number of sensors
+// The unique sensors are found once, when the sensor plan is built
 uint8_t VariableArray::getSensorCount(void)
 {
-    uint8_t numSensors = 0;
-    // Check for unique sensors
-    for (uint8_t i = 0; i < _variableCount; i++)
-    {
-        if (isLastVarFromSensor(i)) numSensors++;
-    }
-    // MS_DBG(F("There are"), numSensors, F("unique sensors in the group."));
-    return numSensors;
+    // MS_DBG(F("There are"), _sensorCount, F("unique sensors in the group."));
+    return _sensorCount;
 }
 
 // This matches UUID's from an array of pointers to the variable array
@@ -94,26 +96,14 @@ void VariableArray::matchUUIDs(const char *uuids[])
 
 // Public functions for interfacing with a list of sensors
 // This sets up all of the sensors in the list
-// NOTE:  Calculated variables will always be skipped in this process because
-// a calculated variable will never be marked as the last variable from a sensor.
+// NOTE:  Calculated variables are never in the sensor list, so they will
+// always be skipped in this process.
 bool VariableArray::setupSensors(void)
 {
     bool success = true;
 
-    // #ifdef MS_VARIABLEARRAY_DEBUG_DEEP
-    // bool deepDebugTiming = true;
-    // #else
-    // bool deepDebugTiming = false;
-    // #endif
-
     MS_DBG(F("Beginning setup for sensors and variables..."));
 
-    // First setup all of the variables
-    // This guarantees that they're registered to their parent sensor
-    // MS_DBG(F("Running variable setup functions."));
-    // for (uint8_t i = 0; i < _variableCount; i++)
-    //     arrayOfVars[i]->setup();
-
     // Power all of the sensors
     // NOTE:  Because we are running this *before* running each sensor's setup
     // function, this may actually fail to power a sensors if the pin mode for
@@ -133,51 +123,24 @@ bool VariableArray::setupSensors(void)
     // Now run all the set-up functions
     MS_DBG(F("Running sensor setup functions."));
 
-    // Check for any sensors that have been set up outside of this (ie, the modem)
-    uint8_t nSensorsSetup = 0;
-    for (uint8_t i = 0; i < _variableCount; i++)
+    for (uint8_t s = 0; s < _sensorCount; s++)
     {
-        if (isLastVarFromSensor(i)) // Skip non-unique sensors
+        // Skip any sensors that have been set up outside of this (ie, the modem)
+        if (bitRead(_sensorList[s]->getStatus(), 0) == 1)  // already set up
         {
-            if (bitRead(arrayOfVars[i]->parentSensor->getStatus(), 0) == 1)  // already set up
-            {
-                MS_DBG(F("   "), arrayOfVars[i]->getParentSensorNameAndLocation(),
-                       F("was already set up!"));
-
-                nSensorsSetup++;
-            }
+            MS_DBG(F("   "), _sensorList[s]->getSensorNameAndLocation(),
+                   F("was already set up!"));
         }
-    }
-
-    // We're going to keep looping through all of the sensors and check if each
-    // one has been on long enough to be warmed up.  Once it has, we'll set it
-    // up and increment the counter marking that's been done.
-    // We keep looping until they've all been done.
-    while (nSensorsSetup < _sensorCount)
-    {
-        for (uint8_t i = 0; i < _variableCount; i++)
+        else
         {
-            bool sensorSuccess = false;
-            if (isLastVarFromSensor(i)) // Skip non-unique sensors
-            {
-                // only set up if it has not yet been set up
-                if (bitRead(arrayOfVars[i]->parentSensor->getStatus(), 0) == 0)
-                {
-                    // and if it is already warmed up
-                    // if (arrayOfVars[i]->parentSensor->isWarmedUp(deepDebugTiming))
-                    // {
-                        MS_DBG(F("    Set up of"), arrayOfVars[i]->getParentSensorNameAndLocation(),
-                               F("..."));
-
-                        sensorSuccess = arrayOfVars[i]->parentSensor->setup();  // set it up
-                        success &= sensorSuccess;
-                        nSensorsSetup++;
-
-                        if (!sensorSuccess) {MS_DBG(F("        ... failed!"));}
-                        else {MS_DBG(F("        ... succeeded."));}
-                    // }
-                }
-            }
+            MS_DBG(F("    Set up of"), _sensorList[s]->getSensorNameAndLocation(),
+                   F("..."));
+
+            bool sensorSuccess = _sensorList[s]->setup();  // set it up
+            success &= sensorSuccess;
+
+            if (!sensorSuccess) {MS_DBG(F("        ... failed!"));}
+            else {MS_DBG(F("        ... succeeded."));}
         }
     }
 
@@ -192,27 +155,20 @@ bool VariableArray::setupSensors(void)
 
 // This powers up the sensors
 // There's no checking or waiting here, just turning on pins
-// NOTE:  Calculated variables will always be skipped in this process because
-// a calculated variable will never be marked as the last variable from a sensor.
 void VariableArray::sensorsPowerUp(void)
 {
     MS_DBG(F("Powering up sensors..."));
-    for (uint8_t i = 0; i < _variableCount; i++)
+    for (uint8_t s = 0; s < _sensorCount; s++)
     {
-        if (isLastVarFromSensor(i)) // Skip non-unique sensors
-        {
-            MS_DBG(F("    Powering up"), arrayOfVars[i]->getParentSensorNameAndLocation());
+        MS_DBG(F("    Powering up"), _sensorList[s]->getSensorNameAndLocation());
 
-            arrayOfVars[i]->parentSensor->powerUp();
-        }
+        _sensorList[s]->powerUp();
     }
 }
 
 
 // This wakes/activates the sensors
 // Before a sensor is "awoken" we have to make sure it's had time to warm up
-// NOTE:  Calculated variables will always be skipped in this process because
-// a calculated variable will never be marked as the last variable from a sensor.
 bool VariableArray::sensorsWake(void)
 {
     MS_DBG(F("Waking sensors..."));
@@ -226,16 +182,13 @@ bool VariableArray::sensorsWake(void)
     #endif
 
     // Check for any sensors that are awake outside of being sent a "wake" command
-    for (uint8_t i = 0; i < _variableCount; i++)
+    for (uint8_t s = 0; s < _sensorCount; s++)
     {
-        if (isLastVarFromSensor(i)) // Skip non-unique sensors
+        if (bitRead(_sensorList[s]->getStatus(), 3) == 1)  // already attempted to wake
         {
-            if (bitRead(arrayOfVars[i]->parentSensor->getStatus(), 3) == 1)  // already attempted to wake
-            {
-                MS_DBG(F("    Wake up of"), arrayOfVars[i]->getParentSensorNameAndLocation(),
-                       F("has already been attempted."));
-                nSensorsAwake++;
-            }
+            MS_DBG(F("    Wake up of"), _sensorList[s]->getSensorNameAndLocation(),
+                   F("has already been attempted."));
+            nSensorsAwake++;
         }
     }
 
@@ -245,29 +198,26 @@ bool VariableArray::sensorsWake(void)
     // We keep looping until they've all been done.
     while (nSensorsAwake < _sensorCount)
     {
-        for (uint8_t i = 0; i < _variableCount; i++)
+        for (uint8_t s = 0; s < _sensorCount; s++)
         {
-            if (isLastVarFromSensor(i)) // Skip non-unique sensors
+            // If no attempts yet made to wake the sensor up
+            if (bitRead(_sensorList[s]->getStatus(), 3) == 0)
             {
-                // If no attempts yet made to wake the sensor up
-                if (bitRead(arrayOfVars[i]->parentSensor->getStatus(), 3) == 0)
+                // and if it is already warmed up
+                if (_sensorList[s]->isWarmedUp(deepDebugTiming))
                 {
-                    // and if it is already warmed up
-                    if (arrayOfVars[i]->parentSensor->isWarmedUp(deepDebugTiming))
-                    {
-                        MS_DBG(F("    Wake up of"), arrayOfVars[i]->getParentSensorNameAndLocation(),
-                               F("..."));
-
-                        // Make a single attempt to wake the sensor after it is warmed up
-                        bool sensorSuccess = arrayOfVars[i]->parentSensor->wake();
-                        success &= sensorSuccess;
-                        // We increment up the number of sensors awake/active, even
-                        // if the wake up command failed!
-                        nSensorsAwake++;
-
-                        if (sensorSuccess) {MS_DBG(F("        ... succeeded."));}
-                        else {MS_DBG(F("        ... failed!"));}
-                    }
+                    MS_DBG(F("    Wake up of"), _sensorList[s]->getSensorNameAndLocation(),
+                           F("..."));
+
+                    // Make a single attempt to wake the sensor after it is warmed up
+                    bool sensorSuccess = _sensorList[s]->wake();
+                    success &= sensorSuccess;
+                    // We increment up the number of sensors awake/active, even
+                    // if the wake up command failed!
+                    nSensorsAwake++;
+
+                    if (sensorSuccess) {MS_DBG(F("        ... succeeded."));}
+                    else {MS_DBG(F("        ... failed!"));}
                 }
             }
         }
@@ -279,25 +229,19 @@ bool VariableArray::sensorsWake(void)
 // This puts sensors to sleep
 // We're not waiting for anything to be ready, we're just sending the command
 // to put it to sleep no matter what its current state is.
-// NOTE:  Calculated variables will always be skipped in this process because
-// a calculated variable will never be marked as the last variable from a sensor.
 bool VariableArray::sensorsSleep(void)
 {
     MS_DBG(F("Putting sensors to sleep..."));
     bool success = true;
-    for (uint8_t i = 0; i < _variableCount; i++)
+    for (uint8_t s = 0; s < _sensorCount; s++)
     {
-        if (isLastVarFromSensor(i)) // Skip non-unique sensors
-        {
-            MS_DBG(F("    "), arrayOfVars[i]->getParentSensorNameAndLocation(),
-                   F("..."));
+        MS_DBG(F("    "), _sensorList[s]->getSensorNameAndLocation(), F("..."));
 
-            bool sensorSuccess = arrayOfVars[i]->parentSensor->sleep();
-            success &= sensorSuccess;
+        bool sensorSuccess = _sensorList[s]->sleep();
+        success &= sensorSuccess;
 
-            if (sensorSuccess) {MS_DBG(F("        ... successfully put to sleep."));}
-            else {MS_DBG(F("        ... failed to sleep!"));}
-        }
+        if (sensorSuccess) {MS_DBG(F("        ... successfully put to sleep."));}
+        else {MS_DBG(F("        ... failed to sleep!"));}
     }
     return success;
 }
@@ -305,19 +249,14 @@ bool VariableArray::sensorsSleep(void)
 
 // This cuts power to the sensors
 // We're not waiting for anything to be ready, we're just cutting power.
-// NOTE:  Calculated variables will always be skipped in this process because
-// a calculated variable will never be marked as the last variable from a sensor.
 void VariableArray::sensorsPowerDown(void)
 {
     MS_DBG(F("Powering down sensors..."));
-    for (uint8_t i = 0; i < _variableCount; i++)
+    for (uint8_t s = 0; s < _sensorCount; s++)
     {
-        if (isLastVarFromSensor(i)) // Skip non-unique sensors
-        {
-            MS_DBG(F("    Powering down"), arrayOfVars[i]->getParentSensorNameAndLocation());
+        MS_DBG(F("    Powering down"), _sensorList[s]->getSensorNameAndLocation());
 
-            arrayOfVars[i]->parentSensor->powerDown();
-        }
+        _sensorList[s]->powerDown();
     }
 }
 
@@ -326,8 +265,6 @@ void VariableArray::sensorsPowerDown(void)
 // Please note that this does NOT run the update functions, it instead uses
 // the startSingleMeasurement and addSingleMeasurementResult functions to
 // take advantage of the ability of sensors to be measuring concurrently.
-// NOTE:  Calculated variables will always be skipped in this process because
-// a calculated variable will never be marked as the last variable from a sensor.
 bool VariableArray::updateAllSensors(void)
 {
     bool success = true;
@@ -339,184 +276,243 @@ bool VariableArray::updateAllSensors(void)
     bool deepDebugTiming = false;
     #endif
 
-    // Create an array with the unique-ness value (so we can skip the function calls later)
-    MS_DBG(F("Creating a mask array with the uniqueness for each sensor.."));
-    bool lastSensorVariable[_variableCount];
-    for (uint8_t i = 0; i < _variableCount; i++)
-    {
-        lastSensorVariable[i] = isLastVarFromSensor(i);
-    }
+    // Pick up any changes to the number of measurements to average
+    countMeasurementsToAverage();
 
     // Create an array for the number of measurements already completed and set all to zero
     MS_DBG(F("Creating an array for the number of completed measurements.."));
-    uint8_t nMeasurementsCompleted[_variableCount];
-    for (uint8_t i = 0; i < _variableCount; i++)
-    {
-        nMeasurementsCompleted[i] = 0;
-    }
-
-    // Create an array for the number of measurements to average (another short cut)
-    MS_DBG(F("Creating an array with the number of measurements to average.."));
-    uint8_t nMeasurementsToAverage[_variableCount];
-    for (uint8_t i = 0; i < _variableCount; i++)
+    uint8_t nMeasurementsCompleted[_sensorCount + 1];
+    for (uint8_t s = 0; s < _sensorCount; s++)
     {
-        if (lastSensorVariable[i])
-        {
-            nMeasurementsToAverage[i] =
-                arrayOfVars[i]->parentSensor->getNumberMeasurementsToAverage();
-        }
-        else nMeasurementsToAverage[i] = 0;
+        nMeasurementsCompleted[s] = 0;
     }
 
     // Clear the initial variable arrays
     MS_DBG(F("----->> Clearing all results arrays before taking new measurements. ..."));
-    for (uint8_t i = 0; i < _variableCount; i++)
+    for (uint8_t s = 0; s < _sensorCount; s++)
     {
-        if (lastSensorVariable[i])
-        {
-            arrayOfVars[i]->parentSensor->clearValues();
-        }
+        _sensorList[s]->clearValues();
     }
     MS_DBG(F("    ... Complete. <<-----"));
 
     // Check for any sensors that didn't wake up and mark them as "complete" so
     // they will be skipped in further looping.
-    for (uint8_t i = 0; i < _variableCount; i++)
+    for (uint8_t s = 0; s < _sensorCount; s++)
     {
-        if (lastSensorVariable[i]) // Skip non-unique sensors
+        if (bitRead(_sensorList[s]->getStatus(), 3) == 0 ||  // No attempt made to wake the sensor up
+            bitRead(_sensorList[s]->getStatus(), 4) == 0 )  // OR Wake up failed
         {
-            if (bitRead(arrayOfVars[i]->parentSensor->getStatus(), 3) == 0 ||  // No attempt made to wake the sensor up
-                bitRead(arrayOfVars[i]->parentSensor->getStatus(), 4) == 0 )  // OR Wake up failed
-            {
-                MS_DBG(i, F("--->>"), arrayOfVars[i]->getParentSensorNameAndLocation(),
-                       F("isn't awake/active!  No measurements will be taken! <<---"), i);
-
-                // Set the number of measurements already equal to whatever total
-                // number requested to ensure the sensor is skipped in further loops.
-                nMeasurementsCompleted[i] = nMeasurementsToAverage[i];
-                // Bump up the finished count.
-                nSensorsCompleted++;
-            }
+            MS_DBG(s, F("--->>"), _sensorList[s]->getSensorNameAndLocation(),
+                   F("isn't awake/active!  No measurements will be taken! <<---"), s);
+
+            // Set the number of measurements already equal to whatever total
+            // number requested to ensure the sensor is skipped in further loops.
+            nMeasurementsCompleted[s] = _sensorMeasurementsToAverage[s];
+            // Bump up the finished count.
+            nSensorsCompleted++;
         }
     }
 
-    while (nSensorsCompleted < _sensorCount)
+    // Build a queue of the next deadline for each sensor that still has
+    // measurements to take.  Instead of re-checking every sensor on every pass,
+    // we only check the sensor with the earliest deadline.
+    MS_DBG(F("Creating a queue of sensor deadlines.."));
+    sensorDeadline deadlineQueue[_sensorCount + 1];
+    uint8_t queueSize = 0;
+    for (uint8_t s = 0; s < _sensorCount; s++)
     {
-        for (uint8_t i = 0; i < _variableCount; i++)
+        if (_sensorMeasurementsToAverage[s] > nMeasurementsCompleted[s])
         {
+            pushDeadline(deadlineQueue, queueSize,
+                         _sensorList[s]->getNextStepTime(), s);
+        }
+    }
 
-            /***
-            // THIS IS PURELY FOR DEEP DEBUGGING OF THE TIMING!
-            // Leave this whole section commented out unless you want excessive
-            // printouts (ie, thousands of lines) of the timing information!!
-            if (lastSensorVariable[i] and
-                nMeasurementsToAverage[i] > nMeasurementsCompleted[i])
-            {
-                MS_DEEP_DBG(i), '-', arrayOfVars[i]->getParentSensorNameAndLocation(),
-                           F("- millis:"), millis(),
-                           F("- status: 0b"),
-                           bitRead(arrayOfVars[i]->parentSensor->getStatus(), 7),
-                           bitRead(arrayOfVars[i]->parentSensor->getStatus(), 6),
-                           bitRead(arrayOfVars[i]->parentSensor->getStatus(), 5),
-                           bitRead(arrayOfVars[i]->parentSensor->getStatus(), 4),
-                           bitRead(arrayOfVars[i]->parentSensor->getStatus(), 3),
-                           bitRead(arrayOfVars[i]->parentSensor->getStatus(), 2),
-                           bitRead(arrayOfVars[i]->parentSensor->getStatus(), 1),
-                           bitRead(arrayOfVars[i]->parentSensor->getStatus(), 0),
-                           F("- measurement #"), (nMeasurementsCompleted[i] + 1);
-            }
-            // END CHUNK FOR DEBUGGING!
-            ***/
+    while (queueSize > 0)
+    {
+        // Take the sensor that is due next off the queue and wait for its deadline
+        sensorDeadline nextDue = popDeadline(deadlineQueue, queueSize);
+        waitForDeadline(nextDue.dueTime);
+        uint8_t s = nextDue.sensorIndex;
+
+        /***
+        // THIS IS PURELY FOR DEEP DEBUGGING OF THE TIMING!
+        // Leave this whole section commented out unless you want excessive
+        // printouts (ie, thousands of lines) of the timing information!!
+        MS_DEEP_DBG(s, '-', _sensorList[s]->getSensorNameAndLocation(),
+                   F("- millis:"), millis(),
+                   F("- status: 0b"),
+                   bitRead(_sensorList[s]->getStatus(), 7),
+                   bitRead(_sensorList[s]->getStatus(), 6),
+                   bitRead(_sensorList[s]->getStatus(), 5),
+                   bitRead(_sensorList[s]->getStatus(), 4),
+                   bitRead(_sensorList[s]->getStatus(), 3),
+                   bitRead(_sensorList[s]->getStatus(), 2),
+                   bitRead(_sensorList[s]->getStatus(), 1),
+                   bitRead(_sensorList[s]->getStatus(), 0),
+                   F("- measurement #"), (nMeasurementsCompleted[s] + 1));
+        // END CHUNK FOR DEBUGGING!
+        ***/
+
+        // first, make sure the sensor is stable
+        if (_sensorList[s]->isStable(deepDebugTiming))
+        {
 
-            // Only do checks on sensors that still have measurements to finish
-            if (lastSensorVariable[i] and
-                nMeasurementsToAverage[i] > nMeasurementsCompleted[i])
+            // now, if the sensor is not currently measuring...
+            if (bitRead(_sensorList[s]->getStatus(), 5) == 0)  // NO attempt yet to start a measurement
             {
-                // first, make sure the sensor is stable
-                if ( arrayOfVars[i]->parentSensor->isStable(deepDebugTiming))
-                {
-
-                    // now, if the sensor is not currently measuring...
-                    if (bitRead(arrayOfVars[i]->parentSensor->getStatus(), 5) == 0)  // NO attempt yet to start a measurement
+                    // Start a reading
+                    MS_DBG(s, '.', nMeasurementsCompleted[s]+1,
+                           F("--->> Starting reading"), nMeasurementsCompleted[s]+1,
+                           F("on"), _sensorList[s]->getSensorNameAndLocation(), '-');
+
+                    sensorStepState sensorState_start = _sensorList[s]->startMeasurementStep();
+                    // If the sensor is still in the middle of starting the
+                    // measurement, put it back in the queue until it's ready
+                    if (sensorState_start == STEP_PENDING)
                     {
-                            // Start a reading
-                            MS_DBG(i, '.', nMeasurementsCompleted[i]+1,
-                                   F("--->> Starting reading"), nMeasurementsCompleted[i]+1,
-                                   F("on"), arrayOfVars[i]->getParentSensorNameAndLocation(), '-');
-
-                            bool sensorSuccess_start = arrayOfVars[i]->parentSensor->startSingleMeasurement();
-                            success &= sensorSuccess_start;
-
-                            if (sensorSuccess_start) {MS_DBG(F("   ... Success. <<---"), i, '.', nMeasurementsCompleted[i]+1);}
-                            else {MS_DBG(F("   ... Failed! <<---"), i, '.', nMeasurementsCompleted[i]+1);}
+                        MS_DBG(F("   ... Pending. <<---"), s, '.', nMeasurementsCompleted[s]+1);
+                        pushDeadline(deadlineQueue, queueSize,
+                                     _sensorList[s]->getNextStepTime(), s);
+                        continue;
                     }
+                    bool sensorSuccess_start = (sensorState_start == STEP_DONE);
+                    success &= sensorSuccess_start;
 
-                    // otherwise, it is currently measuring so...
-                    // if a measurement is finished, get the result and tick up
-                    // the number of finished measurements
-                    // NOTE:  isMeasurementComplete(deepDebugTiming) will
-                    // immediately return true if the attempt to start a
-                    // measurement failed (bit 6 not set).  In that case, the
-                    // addSingleMeasurementResult() will be "adding" -9999 values.
-                    if (arrayOfVars[i]->parentSensor->isMeasurementComplete(deepDebugTiming))
-                    {
-                        // Get the value
-                        MS_DBG(i, '.', nMeasurementsCompleted[i]+1,
-                              F("--->> Collected result of reading"),
-                              nMeasurementsCompleted[i]+1, F("from"),
-                              arrayOfVars[i]->getParentSensorNameAndLocation(), F("..."));
-
-                        bool sensorSuccess_result = arrayOfVars[i]->parentSensor->addSingleMeasurementResult();
-                        success &= sensorSuccess_result;
-                        nMeasurementsCompleted[i] += 1;  // increment the number of measurements that sensor has completed
-
-                        if (sensorSuccess_result) {MS_DBG(F("   ... Success. <<---"), i, '.', nMeasurementsCompleted[i]);}
-                       //  if (sensorSuccess_result)
-                       //  {
-                       //      MS_DBG(F("   ... Success"),
-                       //             arrayOfVars[i]->parentSensor->getStringValueArray(),
-                       //             F("<<---"), i, '.',
-                       //             nMeasurementsCompleted[i]);
-                       // }
-                        else {MS_DBG(F("   ... Failed! <<---"), i, '.', nMeasurementsCompleted[i]);}
-                    }
+                    if (sensorSuccess_start) {MS_DBG(F("   ... Success. <<---"), s, '.', nMeasurementsCompleted[s]+1);}
+                    else {MS_DBG(F("   ... Failed! <<---"), s, '.', nMeasurementsCompleted[s]+1);}
+            }
 
+            // otherwise, it is currently measuring so...
+            // if a measurement is finished, get the result and tick up
+            // the number of finished measurements
+            // NOTE:  isMeasurementComplete(deepDebugTiming) will
+            // immediately return true if the attempt to start a
+            // measurement failed (bit 6 not set).  In that case, the
+            // addSingleMeasurementResult() will be "adding" -9999 values.
+            if (_sensorList[s]->isMeasurementComplete(deepDebugTiming))
+            {
+                // Get the value
+                MS_DBG(s, '.', nMeasurementsCompleted[s]+1,
+                      F("--->> Collected result of reading"),
+                      nMeasurementsCompleted[s]+1, F("from"),
+                      _sensorList[s]->getSensorNameAndLocation(), F("..."));
+
+                sensorStepState sensorState_result = _sensorList[s]->addResultStep();
+                // If the sensor is still in the middle of getting the result,
+                // put it back in the queue until it's ready
+                if (sensorState_result == STEP_PENDING)
+                {
+                    MS_DBG(F("   ... Pending. <<---"), s, '.', nMeasurementsCompleted[s]+1);
+                    pushDeadline(deadlineQueue, queueSize,
+                                 _sensorList[s]->getNextStepTime(), s);
+                    continue;
                 }
-
-                // if all the measurements are done, mark the whole sensor as done
-                if (nMeasurementsCompleted[i] == nMeasurementsToAverage[i])
+                bool sensorSuccess_result = (sensorState_result == STEP_DONE);
+                success &= sensorSuccess_result;
+                nMeasurementsCompleted[s] += 1;  // increment the number of measurements that sensor has completed
+
+                if (sensorSuccess_result) {MS_DBG(F("   ... Success. <<---"), s, '.', nMeasurementsCompleted[s]);}
+                else {MS_DBG(F("   ... Failed! <<---"), s, '.', nMeasurementsCompleted[s]);}
+
+                // If an adaptive sensor already has enough readings, set the
+                // number of measurements completed to the total requested to
+                // mark it finished.
+                if (nMeasurementsCompleted[s] < _sensorMeasurementsToAverage[s] &&
+                    _sensorList[s]->isAveragingComplete(nMeasurementsCompleted[s]))
                 {
-                    MS_DBG(F("--- Finished all measurements from"),
-                           arrayOfVars[i]->getParentSensorNameAndLocation(), F("---"));
-
-                    nSensorsCompleted++;
-                    MS_DBG(F("*****---"), nSensorsCompleted, F("sensors now complete ---*****"));
+                    nMeasurementsCompleted[s] = _sensorMeasurementsToAverage[s];
                 }
             }
+
+        }
+
+        // if all the measurements are done, mark the whole sensor as done
+        if (nMeasurementsCompleted[s] == _sensorMeasurementsToAverage[s])
+        {
+            MS_DBG(F("--- Finished all measurements from"),
+                   _sensorList[s]->getSensorNameAndLocation(), F("---"));
+
+            nSensorsCompleted++;
+            MS_DBG(F("*****---"), nSensorsCompleted, F("sensors now complete ---*****"));
+        }
+        // If the sensor still has measurements to finish, put it back in the
+        // queue with its new deadline
+        else
+        {
+            pushDeadline(deadlineQueue, queueSize,
+                         _sensorList[s]->getNextStepTime(), s);
         }
     }
 
     // Average measurements and notify varibles of the updates
     MS_DBG(F("----->> Averaging results and notifying all variables. ..."));
+    for (uint8_t s = 0; s < _sensorCount; s++)
+    {
+        // MS_DBG(F("--- Averaging results from"), _sensorList[s]->getSensorNameAndLocation(), F("---"));
+        _sensorList[s]->averageMeasurements();
+        // MS_DBG(F("--- Notifying variables from"), _sensorList[s]->getSensorNameAndLocation(), F("---"));
+        _sensorList[s]->notifyVariables();
+    }
+    MS_DBG(F("... Complete. <<-----"));
+
+    // Calculate the calculated variables from the new values
+    refreshCalculatedVariables();
+
+    return success;
+}
+
+
+// This calculates all of the calculated variables once, in dependency order
+void VariableArray::refreshCalculatedVariables(void)
+{
+    MS_DBG(F("----->> Calculating calculated variables. ..."));
+    uint8_t nLeft = 0;
     for (uint8_t i = 0; i < _variableCount; i++)
     {
-        if (lastSensorVariable[i])
+        if (arrayOfVars[i]->isCalculated)
         {
-            // MS_DBG(F("--- Averaging results from"), arrayOfVars[i]->getParentSensorNameAndLocation(), F("---"));
-            arrayOfVars[i]->parentSensor->averageMeasurements();
-            // MS_DBG(F("--- Notifying variables from"), arrayOfVars[i]->getParentSensorNameAndLocation(), F("---"));
-            arrayOfVars[i]->parentSensor->notifyVariables();
+            arrayOfVars[i]->clearCalculatedValue();
+            nLeft++;
         }
     }
-    MS_DBG(F("... Complete. <<-----"));
 
-    return success;
+    // Keep making passes through the list, calculating any variable whose
+    // dependencies have all been calculated, until all are done.  If a pass
+    // makes no progress, the rest have dependencies that are circular or not
+    // in the array, so calculate them anyway.
+    while (nLeft > 0)
+    {
+        uint8_t nBefore = nLeft;
+        for (uint8_t i = 0; i < _variableCount; i++)
+        {
+            Variable *var = arrayOfVars[i];
+            if (var->isCalculated && !var->hasCalculatedValue() &&
+                var->dependenciesCalculated())
+            {
+                var->calculateValue();
+                MS_DBG(F("  "), var->getVarCode(), F("="), var->getValue());
+                nLeft--;
+            }
+        }
+        if (nLeft == nBefore)
+        {
+            MS_DBG(F("  Unresolved calculation dependencies!"));
+            for (uint8_t i = 0; i < _variableCount; i++)
+            {
+                Variable *var = arrayOfVars[i];
+                if (var->isCalculated && !var->hasCalculatedValue()) var->calculateValue();
+            }
+            nLeft = 0;
+        }
+    }
+    MS_DBG(F("   ... Complete. <<-----"));
 }
 
 
 // This function is an even more complete version of the updateAllSensors
 // function - it handles power up/down and wake/sleep.
-bool VariableArray::completeUpdate(void)
+bool VariableArray::completeUpdate(loggerModem *connectingModem)
 {
     bool success = true;
     uint8_t nSensorsCompleted = 0;
@@ -527,325 +523,293 @@ bool VariableArray::completeUpdate(void)
     bool deepDebugTiming = false;
     #endif
 
-    // Create an array with the unique-ness value (so we can skip the function calls later)
-    MS_DBG(F("Creating a mask array with the uniqueness for each sensor.."));
-    bool lastSensorVariable[_variableCount];
-    for (uint8_t i = 0; i < _variableCount; i++)
-    {
-        lastSensorVariable[i] = isLastVarFromSensor(i);
-    }
+    // Pick up any changes to the number of measurements to average
+    countMeasurementsToAverage();
 
     // Create an array for the number of measurements already completed and set all to zero
     MS_DBG(F("Creating an array for the number of completed measurements.."));
-    uint8_t nMeasurementsCompleted[_variableCount];
-    for (uint8_t i = 0; i < _variableCount; i++)
+    uint8_t nMeasurementsCompleted[_sensorCount + 1];
+    for (uint8_t s = 0; s < _sensorCount; s++)
     {
-        nMeasurementsCompleted[i] = 0;
+        nMeasurementsCompleted[s] = 0;
     }
 
-    // Create an array for the number of measurements to average (another short cut)
-    MS_DBG(F("Creating an array with the number of measurements to average.."));
-    uint8_t nMeasurementsToAverage[_variableCount];
-    for (uint8_t i = 0; i < _variableCount; i++)
+    // Another array for the number of measurements already completed per power pin
+    uint8_t nCompletedOnPin[_powerGroupCount + 1];
+    for (uint8_t g = 0; g < _powerGroupCount; g++)
     {
-        if (lastSensorVariable[i])
-        {
-            nMeasurementsToAverage[i] =
-                arrayOfVars[i]->parentSensor->getNumberMeasurementsToAverage();
-        }
-        else nMeasurementsToAverage[i] = 0;
+        nCompletedOnPin[g] = 0;
     }
 
-    // Create an array of the power pins
-    MS_DBG(F("Creating an array of the power pins.."));
-    int8_t powerPins[_variableCount];
-    for (uint8_t i = 0; i < _variableCount; i++)
+    // Clear the initial variable arrays
+    MS_DBG(F("----->> Clearing all results arrays before taking new measurements. ..."));
+    for (uint8_t s = 0; s < _sensorCount; s++)
     {
-        if (lastSensorVariable[i])
-        {
-            powerPins[i] = arrayOfVars[i]->parentSensor->getPowerPin();
-        }
-        else powerPins[i] = 0;
+        _sensorList[s]->clearValues();
     }
+    MS_DBG(F("   ... Complete. <<-----"));
 
-    // Create an array of the last variable on each power pin
-    MS_DBG(F("Creating arrays of the power pin locations.."));
-    bool lastPinVariable[_variableCount];
-    for (uint8_t i = 0; i < _variableCount; i++)
+    // Mark which power pins have been turned on
+    bool pinPowered[_powerGroupCount + 1];
+    uint32_t cycleStart = millis();
+
+    // If the power up is not staggered, power up all of the sensors together
+    if (!_staggerPowerUp)
     {
-        lastPinVariable[i] = 1;
+        MS_DBG(F("----->> Powering up all sensors together. ..."));
+        sensorsPowerUp();
+        MS_DBG(F("   ... Complete. <<-----"));
     }
-    // Create an array containing the index of the power pin in the powerPins array
-    int8_t powerPinIndex[_variableCount];
-    for (uint8_t i = 0; i < _variableCount; i++)
+    for (uint8_t g = 0; g < _powerGroupCount; g++)
     {
-        powerPinIndex[i] = 0;
+        pinPowered[g] = !_staggerPowerUp;
     }
-    // Create an array to tell us how many measurements must be taken
-    // before all the sensors attached to a power pin are done
-    uint8_t nMeasurementsOnPin[_variableCount];
-    for (uint8_t i = 0; i < _variableCount; i++)
+
+    // Build a queue of the next deadline for each sensor.  Instead of
+    // re-checking every sensor on every pass, we only check the sensor with
+    // the earliest deadline.  When the power up is staggered, the first
+    // deadline for each sensor is the time its power pin should be turned on.
+    MS_DBG(F("Creating a queue of sensor deadlines.."));
+    sensorDeadline deadlineQueue[_sensorCount + 1];
+    uint8_t queueSize = 0;
+    for (uint8_t s = 0; s < _sensorCount; s++)
     {
-        nMeasurementsOnPin[i] = nMeasurementsToAverage[i];
+        if (_sensorMeasurementsToAverage[s] > nMeasurementsCompleted[s])
+        {
+            uint32_t dueTime;
+            if (pinPowered[_sensorPowerGroup[s]])
+                dueTime = _sensorList[s]->getNextStepTime();
+            else
+                dueTime = cycleStart + getPowerPinStartOffset(_sensorPowerGroup[s]);
+            pushDeadline(deadlineQueue, queueSize, dueTime, s);
+        }
     }
-    // Now correctly populate the previous three arrays
-    for (uint8_t i = 0; i < _variableCount; i++)
+
+    while (queueSize > 0)
     {
-        for (uint8_t j = i + 1; j < _variableCount; j++)
+        // Take the sensor that is due next off the queue and wait for its deadline
+        sensorDeadline nextDue = popDeadline(deadlineQueue, queueSize);
+        waitForDeadline(nextDue.dueTime, connectingModem);
+        uint8_t s = nextDue.sensorIndex;
+        uint8_t g = _sensorPowerGroup[s];
+
+        // If this sensor's power pin is not yet on, it's now time to turn it on
+        if (!pinPowered[g])
         {
-            if (!lastSensorVariable[i])
-            {
-                lastPinVariable[i] = 0;
-                // MS_DBG(i, F("isn't the last variable on power pin because not last on sensor."));
-            }
-            else if (powerPins[i] == powerPins[j])
+            MS_DBG(F("----->> Powering up sensors on pin"), _powerGroupPin[g], F("..."));
+            for (uint8_t k = 0; k < _sensorCount; k++)
             {
-                lastPinVariable[i] = 0;
-                // MS_DBG(i, F("isn't the last variable on power pin, matches"), j);
+                if (_sensorPowerGroup[k] == g) _sensorList[k]->powerUp();
             }
-            i++;
+            pinPowered[g] = true;
+            MS_DBG(F("   ... Complete. <<-----"));
         }
-    }
-    for (uint8_t i = 0; i < _variableCount; i++)
-    {
-        if (lastPinVariable[i])
+
+        /***
+        // THIS IS PURELY FOR DEEP DEBUGGING OF THE TIMING!
+        // Leave this whole section commented out unless you want excessive
+        // printouts (ie, thousands of lines) of the timing information!!
+        MS_DEEP_DBG(s, '-', _sensorList[s]->getSensorNameAndLocation(),
+                    F("- millis:"), millis(),
+                    F("- status: 0b"),
+                    bitRead(_sensorList[s]->getStatus(), 7),
+                    bitRead(_sensorList[s]->getStatus(), 6),
+                    bitRead(_sensorList[s]->getStatus(), 5),
+                    bitRead(_sensorList[s]->getStatus(), 4),
+                    bitRead(_sensorList[s]->getStatus(), 3),
+                    bitRead(_sensorList[s]->getStatus(), 2),
+                    bitRead(_sensorList[s]->getStatus(), 1),
+                    bitRead(_sensorList[s]->getStatus(), 0),
+                    F("- measurement #"), (nMeasurementsCompleted[s] + 1));
+        // END CHUNK FOR DEBUGGING!
+        ***/
+
+        // If no attempts yet made to wake the sensor up
+        if (bitRead(_sensorList[s]->getStatus(), 3) == 0)
         {
-            powerPinIndex[i] = i;
-            nMeasurementsOnPin[i] = nMeasurementsToAverage[i];
-            for (uint8_t j = 0; j < _variableCount; j++)
+            // and if it is already warmed up
+            if (_sensorList[s]->isWarmedUp(deepDebugTiming))
             {
-                if (powerPins[j] == powerPins[i] && i != j)
+                MS_DBG(s, F("--->> Waking"), _sensorList[s]->getSensorNameAndLocation(), F("..."));
+
+                // Make a single attempt to wake the sensor after it is warmed up
+                sensorStepState sensorState_wake = _sensorList[s]->wakeStep();
+                // If the sensor is still in the middle of waking, put it back
+                // in the queue until it's ready
+                if (sensorState_wake == STEP_PENDING)
                 {
-                    powerPinIndex[j] = i;
-                    nMeasurementsOnPin[i] += nMeasurementsToAverage[j];
-                    nMeasurementsOnPin[j] = 0;
+                    MS_DBG(F("   ... Pending. <<---"), s);
+                    pushDeadline(deadlineQueue, queueSize,
+                                 _sensorList[s]->getNextStepTime(), s);
+                    continue;
                 }
+                bool sensorSuccess_wake = (sensorState_wake == STEP_DONE);
+                success &= sensorSuccess_wake;
+
+                if (sensorSuccess_wake) {MS_DBG(F("   ... Success. <<---"), s);}
+                else {MS_DBG(F("   ... Failed! <<---"), s);}
             }
         }
-    }
-
-    // This is just for debugging
-    #ifdef MS_VARIABLEARRAY_DEBUG_DEEP
-    uint8_t arrayPositions[_variableCount];
-    for (uint8_t i = 0; i < _variableCount; i++)
-    {
-        arrayPositions[i] = i;
-    }
-    String nameLocation[_variableCount];
-    for (uint8_t i = 0; i < _variableCount; i++)
-    {
-        // nameLocation[i] = arrayOfVars[i]->getParentSensorNameAndLocation();
-        nameLocation[i] = arrayOfVars[i]->getParentSensorName();
-    }
-    MS_DEEP_DBG(F("----------------------------------"));
-    MS_DEEP_DBG(F("arrayPositions:\t\t\t"));
-    prettyPrintArray(arrayPositions);
-    MS_DEEP_DBG(F("sensor:\t\t\t"));
-    prettyPrintArray(nameLocation);
-    MS_DEEP_DBG(F("lastSensorVariable:\t\t"));
-    prettyPrintArray(lastSensorVariable);
-    MS_DEEP_DBG(F("nMeasurementsToAverage:\t\t"));
-    prettyPrintArray(nMeasurementsToAverage);
-    MS_DEEP_DBG(F("powerPins:\t\t\t"));
-    prettyPrintArray(powerPins);
-    MS_DEEP_DBG(F("lastPinVariable:\t\t"));
-    prettyPrintArray(lastPinVariable);
-    MS_DEEP_DBG(F("nMeasurementsOnPin:\t\t"));
-    prettyPrintArray(nMeasurementsOnPin);
-    MS_DEEP_DBG(F("powerPinIndex:\t\t\t"));
-    prettyPrintArray(powerPinIndex);
-    #endif
-
-    // Another array for the number of measurements already completed per power pin
-    uint8_t nCompletedOnPin[_variableCount];
-    for (uint8_t i = 0; i < _variableCount; i++)
-    {
-        nCompletedOnPin[i] = 0;
-    }
 
-    // Clear the initial variable arrays
-    MS_DBG(F("----->> Clearing all results arrays before taking new measurements. ..."));
-    for (uint8_t i = 0; i < _variableCount; i++)
-    {
-        if (lastSensorVariable[i])
+        // If attempts were made to wake the sensor, but they failed
+        // then we're just bumping up the number of measurements to completion
+        if (bitRead(_sensorList[s]->getStatus(), 3) == 1 &&
+            bitRead(_sensorList[s]->getStatus(), 4) == 0)
         {
-            arrayOfVars[i]->parentSensor->clearValues();
+            MS_DBG(s, F("--->>"), _sensorList[s]->getSensorNameAndLocation(),
+                   F("did not wake up! No measurements will be taken! <<---"), s);
+            // increment the number of measurements that the power pin has completed
+            nCompletedOnPin[g] += _sensorMeasurementsToAverage[s] - nMeasurementsCompleted[s];
+            // Set the number of measurements already equal to whatever total
+            // number requested to ensure the sensor is skipped in further loops.
+            nMeasurementsCompleted[s] = _sensorMeasurementsToAverage[s];
         }
-    }
-    MS_DBG(F("   ... Complete. <<-----"));
-
-    // power up all of the sensors together
-    MS_DBG(F("----->> Powering up all sensors together. ..."));
-    sensorsPowerUp();
-    MS_DBG(F("   ... Complete. <<-----"));
 
-    while (nSensorsCompleted < _sensorCount)
-    {
-        for (uint8_t i = 0; i < _variableCount; i++)
+        // If the sensor was successfully awoken/activated...
+        // .. make sure the sensor is stable
+        if (nMeasurementsCompleted[s] < _sensorMeasurementsToAverage[s] &&
+            bitRead(_sensorList[s]->getStatus(), 4) == 1 &&
+            _sensorList[s]->isStable(deepDebugTiming))
         {
-            /***
-            // THIS IS PURELY FOR DEEP DEBUGGING OF THE TIMING!
-            // Leave this whole section commented out unless you want excessive
-            // printouts (ie, thousands of lines) of the timing information!!
-            if (lastSensorVariable[i] and
-                nMeasurementsToAverage[i] > nMeasurementsCompleted[i])
-            {
-                MS_DEEP_DBG(i), '-',
-                            arrayOfVars[i]->getParentSensorNameAndLocation(),
-                            F("- millis:"), millis(),
-                            F("- status: 0b"),
-                            bitRead(arrayOfVars[i]->parentSensor->getStatus(), 7),
-                            bitRead(arrayOfVars[i]->parentSensor->getStatus(), 6),
-                            bitRead(arrayOfVars[i]->parentSensor->getStatus(), 5),
-                            bitRead(arrayOfVars[i]->parentSensor->getStatus(), 4),
-                            bitRead(arrayOfVars[i]->parentSensor->getStatus(), 3),
-                            bitRead(arrayOfVars[i]->parentSensor->getStatus(), 2),
-                            bitRead(arrayOfVars[i]->parentSensor->getStatus(), 1),
-                            bitRead(arrayOfVars[i]->parentSensor->getStatus(), 0),
-                            F("- measurement #"), (nMeasurementsCompleted[i] + 1);
-            }
-            // END CHUNK FOR DEBUGGING!
-            ***/
 
-            // Only do checks on sensors that still have measurements to finish
-            if (lastSensorVariable[i] && nMeasurementsToAverage[i] > nMeasurementsCompleted[i])
+            // If no attempt has yet been made to start a measurement, start one
+            if (bitRead(_sensorList[s]->getStatus(), 5) == 0)
             {
-                // If no attempts yet made to wake the sensor up
-                if (bitRead(arrayOfVars[i]->parentSensor->getStatus(), 3) == 0)
-                {
-                    // and if it is already warmed up
-                    if (arrayOfVars[i]->parentSensor->isWarmedUp(deepDebugTiming))
+                    // Start a reading
+                    MS_DBG(s, '.', nMeasurementsCompleted[s]+1,
+                           F("--->> Starting reading"), nMeasurementsCompleted[s]+1,
+                           F("on"), _sensorList[s]->getSensorNameAndLocation(), F("..."));
+
+                    sensorStepState sensorState_start = _sensorList[s]->startMeasurementStep();
+                    // If the sensor is still in the middle of starting the
+                    // measurement, put it back in the queue until it's ready
+                    if (sensorState_start == STEP_PENDING)
                     {
-                        MS_DBG(i, F("--->> Waking"), arrayOfVars[i]->getParentSensorNameAndLocation(), F("..."));
-
-                        // Make a single attempt to wake the sensor after it is warmed up
-                        bool sensorSuccess_wake = arrayOfVars[i]->parentSensor->wake();
-                        success &= sensorSuccess_wake;
-
-                        if (sensorSuccess_wake) {MS_DBG(F("   ... Success. <<---"), i);}
-                        else {MS_DBG(F("   ... Failed! <<---"), i);}
+                        MS_DBG(F("   ... Pending. <<---"), s, '.', nMeasurementsCompleted[s]+1);
+                        pushDeadline(deadlineQueue, queueSize,
+                                     _sensorList[s]->getNextStepTime(), s);
+                        continue;
                     }
-                }
+                    bool sensorSuccess_start = (sensorState_start == STEP_DONE);
+                    success &= sensorSuccess_start;
+
+                    if (sensorSuccess_start) {MS_DBG(F("   ... Success. <<---"), s, '.', nMeasurementsCompleted[s]+1);}
+                    else {MS_DBG(F("   ... Failed! <<---"), s, '.', nMeasurementsCompleted[s]+1);}
+            }
 
-                // If attempts were made to wake the sensor, but they failed
-                // then we're just bumping up the number of measurements to completion
-                if (bitRead(arrayOfVars[i]->parentSensor->getStatus(), 3) == 1 &&
-                    bitRead(arrayOfVars[i]->parentSensor->getStatus(), 4) == 0)
+            // If a measurement is finished, get the result and tick up
+            // the number of finished measurements.  We aren't bothering
+            // to check if the measurement start was successful,
+            // isMeasurementComplete(deepDebugTiming) will do that and we stil want the
+            // addSingleMeasurementResult() function to fill in the -9999
+            // results for a failed measurement.
+            if (_sensorList[s]->isMeasurementComplete(deepDebugTiming))
+            {
+                // Get the value
+                MS_DBG(s, '.', nMeasurementsCompleted[s]+1,
+                       F("--->> Collected result of reading"),
+                       nMeasurementsCompleted[s]+1, F("from"),
+                       _sensorList[s]->getSensorNameAndLocation(), F("..."));
+
+                sensorStepState sensorState_result = _sensorList[s]->addResultStep();
+                // If the sensor is still in the middle of getting the result,
+                // put it back in the queue until it's ready
+                if (sensorState_result == STEP_PENDING)
                 {
-                    MS_DBG(i, F("--->>"), arrayOfVars[i]->getParentSensorNameAndLocation(),
-                           F("did not wake up! No measurements will be taken! <<---"), i);
-                    // Set the number of measurements already equal to whatever total
-                    // number requested to ensure the sensor is skipped in further loops.
-                    nMeasurementsCompleted[i] = nMeasurementsToAverage[i];
-                    // increment the number of measurements that the power pin has completed
-                    nCompletedOnPin[powerPinIndex[i]] += nMeasurementsToAverage[i];
+                    MS_DBG(F("   ... Pending. <<---"), s, '.', nMeasurementsCompleted[s]+1);
+                    pushDeadline(deadlineQueue, queueSize,
+                                 _sensorList[s]->getNextStepTime(), s);
+                    continue;
                 }
-
-                // If the sensor was successfully awoken/activated...
-                // .. make sure the sensor is stable
-                if (bitRead(arrayOfVars[i]->parentSensor->getStatus(), 4) == 1 &&
-                    arrayOfVars[i]->parentSensor->isStable(deepDebugTiming))
+                bool sensorSuccess_result = (sensorState_result == STEP_DONE);
+                success &= sensorSuccess_result;
+                nMeasurementsCompleted[s] += 1;  // increment the number of measurements that sensor has completed
+                nCompletedOnPin[g] += 1;  // increment the number of measurements that the power pin has completed
+
+                if (sensorSuccess_result) {MS_DBG(F("   ... Success. <<---"), s, '.', nMeasurementsCompleted[s]);}
+                else {MS_DBG(F("   ... Failed! <<---"), s, '.', nMeasurementsCompleted[s]);}
+
+                // If an adaptive sensor already has enough readings, count the
+                // rest as done for both the sensor and its power pin, so the
+                // pin can be turned off as soon as the other sensors on it are
+                // finished.
+                if (nMeasurementsCompleted[s] < _sensorMeasurementsToAverage[s] &&
+                    _sensorList[s]->isAveragingComplete(nMeasurementsCompleted[s]))
                 {
-
-                    // If no attempt has yet been made to start a measurement, start one
-                    if (bitRead(arrayOfVars[i]->parentSensor->getStatus(), 5) == 0)
-                    {
-                            // Start a reading
-                            MS_DBG(i, '.', nMeasurementsCompleted[i]+1,
-                                   F("--->> Starting reading"), nMeasurementsCompleted[i]+1,
-                                   F("on"), arrayOfVars[i]->getParentSensorNameAndLocation(), F("..."));
-
-                            bool sensorSuccess_start = arrayOfVars[i]->parentSensor->startSingleMeasurement();
-                            success &= sensorSuccess_start;
-
-                            if (sensorSuccess_start) {MS_DBG(F("   ... Success. <<---"), i, '.', nMeasurementsCompleted[i]+1);}
-                            else {MS_DBG(F("   ... Failed! <<---"), i, '.', nMeasurementsCompleted[i]+1);}
-                    }
-
-                    // If a measurement is finished, get the result and tick up
-                    // the number of finished measurements.  We aren't bothering
-                    // to check if the measurement start was successful,
-                    // isMeasurementComplete(deepDebugTiming) will do that and we stil want the
-                    // addSingleMeasurementResult() function to fill in the -9999
-                    // results for a failed measurement.
-                    if (arrayOfVars[i]->parentSensor->isMeasurementComplete(deepDebugTiming))
-                    {
-                        // Get the value
-                        MS_DBG(i, '.', nMeasurementsCompleted[i]+1,
-                               F("--->> Collected result of reading"),
-                               nMeasurementsCompleted[i]+1, F("from"),
-                               arrayOfVars[i]->getParentSensorNameAndLocation(), F("..."));
-
-                        bool sensorSuccess_result = arrayOfVars[i]->parentSensor->addSingleMeasurementResult();
-                        success &= sensorSuccess_result;
-                        nMeasurementsCompleted[i] += 1;  // increment the number of measurements that sensor has completed
-                        nCompletedOnPin[powerPinIndex[i]] += 1;  // increment the number of measurements that the power pin has completed
-
-                        if (sensorSuccess_result) {MS_DBG(F("   ... Success. <<---"), i, '.', nMeasurementsCompleted[i]);}
-                       //  if (sensorSuccess_result)
-                       //  {
-                       //      MS_DBG(F("   ... Success"),
-                       //             arrayOfVars[i]->parentSensor->getStringValueArray(),
-                       //             F("<<---"), i, '.',
-                       //             nMeasurementsCompleted[i]);
-                       // }
-                        else {MS_DBG(F("   ... Failed! <<---"), i, '.', nMeasurementsCompleted[i]);}
-                    }
-
+                    nCompletedOnPin[g] += _sensorMeasurementsToAverage[s] - nMeasurementsCompleted[s];
+                    nMeasurementsCompleted[s] = _sensorMeasurementsToAverage[s];
                 }
+            }
 
-                // If all the measurements are done
-                if (nMeasurementsCompleted[i] == nMeasurementsToAverage[i])
-                {
-                    MS_DBG(i, F("--->> Finished all measurements from"),
-                           arrayOfVars[i]->getParentSensorNameAndLocation(),
-                           F(", putting it to sleep. ..."));
+        }
 
-                    // Put the completed sensor to sleep
-                    bool sensorSuccess_sleep = arrayOfVars[i]->parentSensor->sleep();
-                    success &= sensorSuccess_sleep;
+        // If all the measurements are done
+        if (nMeasurementsCompleted[s] == _sensorMeasurementsToAverage[s])
+        {
+            MS_DBG(s, F("--->> Finished all measurements from"),
+                   _sensorList[s]->getSensorNameAndLocation(),
+                   F(", putting it to sleep. ..."));
+
+            // Put the completed sensor to sleep
+            sensorStepState sensorState_sleep = _sensorList[s]->sleepStep();
+            // If the sensor is still in the middle of going to sleep, put it
+            // back in the queue until it's ready
+            if (sensorState_sleep == STEP_PENDING)
+            {
+                MS_DBG(F("   ... Pending. <<---"), s);
+                pushDeadline(deadlineQueue, queueSize,
+                             _sensorList[s]->getNextStepTime(), s);
+                continue;
+            }
+            bool sensorSuccess_sleep = (sensorState_sleep == STEP_DONE);
+            success &= sensorSuccess_sleep;
 
-                    if (sensorSuccess_sleep) {MS_DBG(F("   ... Success. <<---"), i);}
-                    else {MS_DBG(F("   ... Failed! <<---"), i);}
+            if (sensorSuccess_sleep) {MS_DBG(F("   ... Success. <<---"), s);}
+            else {MS_DBG(F("   ... Failed! <<---"), s);}
 
-                    // Now cut the power, if ready, to this sensors and all that share the pin
-                    if (nCompletedOnPin[powerPinIndex[i]] == nMeasurementsOnPin[powerPinIndex[i]])
+            // Now cut the power, if ready, to this sensors and all that share the pin
+            if (nCompletedOnPin[g] == _powerGroupMeasurements[g])
+            {
+                for (uint8_t k = 0; k < _sensorCount; k++)
+                {
+                    if (_sensorPowerGroup[k] == g)
                     {
-                        for (uint8_t k = 0; k < _variableCount; k++)
-                        {
-                            if (powerPinIndex[k] == powerPinIndex[i] && lastSensorVariable[k] )
-                            {
-                                arrayOfVars[k]->parentSensor->powerDown();
-                                MS_DBG(k, F("--->>"),
-                                       arrayOfVars[k]->getParentSensorNameAndLocation(),
-                                       F("powered down. <<---"), k);
-                            }
-                        }
+                        _sensorList[k]->powerDown();
+                        MS_DBG(k, F("--->>"),
+                               _sensorList[k]->getSensorNameAndLocation(),
+                               F("powered down. <<---"), k);
                     }
-
-                    nSensorsCompleted++;  // mark the whole sensor as done
-                    MS_DBG(F("*****---"), nSensorsCompleted, F("sensors now complete ---*****"));
                 }
             }
+
+            nSensorsCompleted++;  // mark the whole sensor as done
+            MS_DBG(F("*****---"), nSensorsCompleted, F("sensors now complete ---*****"));
+        }
+        // If the sensor still has measurements to finish, put it back in the
+        // queue with its new deadline
+        else
+        {
+            pushDeadline(deadlineQueue, queueSize,
+                         _sensorList[s]->getNextStepTime(), s);
         }
     }
 
     // Average measurements and notify varibles of the updates
     MS_DBG(F("----->> Averaging results and notifying all variables. ..."));
-    for (uint8_t i = 0; i < _variableCount; i++)
+    for (uint8_t s = 0; s < _sensorCount; s++)
     {
-        if (lastSensorVariable[i])
-        {
-            MS_DBG(F("--- Averaging results from"),
-                   arrayOfVars[i]->getParentSensorNameAndLocation(), F("---"));
-            arrayOfVars[i]->parentSensor->averageMeasurements();
-            MS_DBG(F("--- Notifying variables from"),
-                   arrayOfVars[i]->getParentSensorNameAndLocation(), F("---"));
-            arrayOfVars[i]->parentSensor->notifyVariables();
-        }
+        MS_DBG(F("--- Averaging results from"),
+               _sensorList[s]->getSensorNameAndLocation(), F("---"));
+        _sensorList[s]->averageMeasurements();
+        MS_DBG(F("--- Notifying variables from"),
+               _sensorList[s]->getSensorNameAndLocation(), F("---"));
+        _sensorList[s]->notifyVariables();
     }
     MS_DBG(F("... Complete. <<-----"));
 
+    // Calculate the calculated variables from the new values
+    refreshCalculatedVariables();
+
     return success;
 }
 
@@ -854,13 +818,15 @@ bool VariableArray::completeUpdate(void)
 // Calculated variable results will be included
 void VariableArray::printSensorData(Stream *stream)
 {
+    char valueBuffer[VALUE_STRING_BUFFER_SIZE];
     for (uint8_t i = 0; i < _variableCount; i++)
     {
+        arrayOfVars[i]->formatValue(valueBuffer, VALUE_STRING_BUFFER_SIZE);
         if (arrayOfVars[i]->isCalculated)
         {
             stream->print(arrayOfVars[i]->getVarName());
             stream->print(F(" is calculated to be "));
-            stream->print(arrayOfVars[i]->getValueString());
+            stream->print(valueBuffer);
             stream->print(F(" "));
             stream->print(arrayOfVars[i]->getVarUnit());
             stream->println();
@@ -880,7 +846,7 @@ void VariableArray::printSensorData(Stream *stream)
             stream->print(F(" reports "));
             stream->print(arrayOfVars[i]->getVarName());
             stream->print(F(" is "));
-            stream->print(arrayOfVars[i]->getValueString());
+            stream->print(valueBuffer);
             stream->print(F(" "));
             stream->print(arrayOfVars[i]->getVarUnit());
             stream->println();
@@ -889,34 +855,331 @@ void VariableArray::printSensorData(Stream *stream)
 }
 
 
-// Check for unique sensors
-bool VariableArray::isLastVarFromSensor(int arrayIndex)
+// This adds a sensor deadline to the min-heap, sifting it up into place
+void VariableArray::pushDeadline(sensorDeadline queue[], uint8_t &queueSize,
+                                 uint32_t dueTime, uint8_t sensorIndex)
+{
+    uint8_t child = queueSize++;
+    while (child > 0)
+    {
+        uint8_t parent = (child - 1)/2;
+        // Stop once the parent is due no later than the new entry
+        if ((int32_t)(dueTime - queue[parent].dueTime) >= 0) break;
+        queue[child] = queue[parent];
+        child = parent;
+    }
+    queue[child].dueTime = dueTime;
+    queue[child].sensorIndex = sensorIndex;
+}
+
+
+// This removes and returns the earliest deadline from the min-heap
+sensorDeadline VariableArray::popDeadline(sensorDeadline queue[], uint8_t &queueSize)
 {
-    /*MS_DEEP_DBG(F("Checking if"), arrayOfVars[arrayIndex]->getVarName(), '(',
-           arrayIndex, F(") is the last variable from a sensor..."));*/
+    sensorDeadline earliest = queue[0];
+    sensorDeadline last = queue[--queueSize];
 
-    // Calculated variables are never the last variable from a sensor, simply
-    // because the don't come from a sensor at all.
-    if (arrayOfVars[arrayIndex]->isCalculated)
+    // Sift the last entry down from the top of the heap
+    uint8_t parent = 0;
+    while (true)
     {
-        // MS_DEEP_DBG(F("   ... Nope, it's calculated!"));
-        return false;
+        uint8_t child = 2*parent + 1;
+        if (child >= queueSize) break;
+        // Pick the earlier of the two children
+        if (child + 1 < queueSize &&
+            (int32_t)(queue[child + 1].dueTime - queue[child].dueTime) < 0)
+            child++;
+        if ((int32_t)(queue[child].dueTime - last.dueTime) >= 0) break;
+        queue[parent] = queue[child];
+        parent = child;
     }
-    else
+    queue[parent] = last;
+
+    return earliest;
+}
+
+
+// This waits until a sensor deadline has passed
+// NOTE:  This is "blocking" - that is, nothing else can happen during this wait.
+void VariableArray::waitForDeadline(uint32_t dueTime)
+{
+    int32_t remaining = (int32_t)(dueTime - millis());
+    if (remaining <= 0) return;
+
+    if (_idleSleep && remaining >= MS_MIN_IDLE_SLEEP_MS)
     {
-        String sensNameLoc = arrayOfVars[arrayIndex]->getParentSensorNameAndLocation();
-        bool unique = true;
-        for (uint8_t j = arrayIndex + 1; j < _variableCount; j++)
+        MS_DBG(F("Idling processor for"), remaining, F("ms until next sensor deadline."));
+        idleUntil(dueTime);
+    }
+    while ((int32_t)(millis() - dueTime) < 0) {}
+}
+
+
+// This waits for a deadline, moving along a modem's connection to the
+// internet whenever one of its steps comes due first
+void VariableArray::waitForDeadline(uint32_t dueTime, loggerModem *connectingModem)
+{
+    while (connectingModem != NULL && connectingModem->isConnectingInternet() &&
+           (int32_t)(connectingModem->getNextConnectStepTime() - dueTime) < 0)
+    {
+        waitForDeadline(connectingModem->getNextConnectStepTime());
+        connectingModem->connectInternetStep();
+    }
+    waitForDeadline(dueTime);
+}
+
+
+// This puts the processor into idle mode until a deadline has passed.
+// We use idle rather than the deeper sleep modes from Logger::systemSleep()
+// because those stop the timer behind millis(), which all of the sensor
+// timing depends on.  The millis() timer interrupt wakes the processor about
+// once a millisecond; it goes right back to sleep if the deadline hasn't come.
+void VariableArray::idleUntil(uint32_t dueTime)
+{
+    #if defined ARDUINO_ARCH_SAMD
+
+    // Make sure we're not going into deep sleep; SysTick keeps running and
+    // wakes the processor on every tick
+    SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+    while ((int32_t)(millis() - dueTime) < 0)
+    {
+        __DSB();
+        __WFI();
+    }
+
+    #elif defined ARDUINO_ARCH_AVR
+
+    // SLEEP_MODE_IDLE stops the CPU clock only; timer 0 and the UARTs still run
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    while ((int32_t)(millis() - dueTime) < 0)
+    {
+        // Temporarily disable interrupts so a tick can't sneak in between the
+        // check and the sleep.  The instruction right after interrupts() is
+        // always run before any pending interrupt, so sleep_cpu() is reached.
+        noInterrupts();
+        if ((int32_t)(millis() - dueTime) >= 0)
         {
-            if (sensNameLoc == arrayOfVars[j]->getParentSensorNameAndLocation())
+            interrupts();
+            break;
+        }
+        sleep_enable();
+        interrupts();
+        sleep_cpu();
+        sleep_disable();
+    }
+
+    #endif
+}
+
+
+// This builds the "plan" of which sensors are in the array and how they are
+// grouped by power pin.  This is done once so the functions that loop through
+// the sensors don't need to compare variables against each other every time.
+// Sensors are listed in the order of the *last* variable from each sensor.
+void VariableArray::buildSensorPlan(void)
+{
+    _sensorCount = 0;
+    _powerGroupCount = 0;
+
+    // Find the unique sensors
+    // Calculated variables never come from a sensor, so they're skipped
+    for (uint8_t i = 0; i < _variableCount; i++)
+    {
+        if (arrayOfVars[i]->isCalculated) continue;
+        bool lastFromSensor = true;
+        for (uint8_t j = i + 1; j < _variableCount; j++)
+        {
+            if (!arrayOfVars[j]->isCalculated &&
+                arrayOfVars[j]->parentSensor == arrayOfVars[i]->parentSensor)
             {
-                unique = false;
-                // MS_DEEP_DBG(F("   ... Nope, there are others after it!"));
+                lastFromSensor = false;
                 break;
             }
         }
-        // if (unique) MS_DEEP_DBG(F("   ... Yes, it is!"));
-        return unique;
+        if (!lastFromSensor) continue;
+
+        if (_sensorCount >= MAX_NUMBER_SENSORS)
+        {
+            PRINTOUT(F("There are more than"), MAX_NUMBER_SENSORS,
+                     F("sensors in the array!  Increase MAX_NUMBER_SENSORS."));
+            break;
+        }
+        _sensorList[_sensorCount] = arrayOfVars[i]->parentSensor;
+        _sensorCount++;
+    }
+
+    // Group the sensors by power pin
+    for (uint8_t s = 0; s < _sensorCount; s++)
+    {
+        int8_t pin = _sensorList[s]->getPowerPin();
+        uint8_t g = 0;
+        while (g < _powerGroupCount && _powerGroupPin[g] != pin) g++;
+        if (g == _powerGroupCount)
+        {
+            _powerGroupPin[g] = pin;
+            _powerGroupCount++;
+        }
+        _sensorPowerGroup[s] = g;
+    }
+
+    countMeasurementsToAverage();
+
+    MS_DBG(F("There are"), _sensorCount, F("unique sensors on"),
+           _powerGroupCount, F("power pins in the group."));
+    MS_DBG(F("A complete update should take about"), _predictedCycleTime_ms, F("ms."));
+
+    // This is just for debugging
+    #ifdef MS_VARIABLEARRAY_DEBUG_DEEP
+    MS_DEEP_DBG(F("----------------------------------"));
+    MS_DEEP_DBG(F("sensorMeasurementsToAverage:\t"));
+    prettyPrintArray(_sensorMeasurementsToAverage, _sensorCount);
+    MS_DEEP_DBG(F("sensorPowerGroup:\t\t"));
+    prettyPrintArray(_sensorPowerGroup, _sensorCount);
+    MS_DEEP_DBG(F("powerGroupPin:\t\t\t"));
+    prettyPrintArray(_powerGroupPin, _powerGroupCount);
+    MS_DEEP_DBG(F("powerGroupMeasurements:\t\t"));
+    prettyPrintArray(_powerGroupMeasurements, _powerGroupCount);
+    #endif
+}
+
+
+// This returns the shortest time a power pin must be on: sensors sharing a pin
+// are all on together, so the pin must stay on for the slowest of them.
+uint32_t VariableArray::getPowerGroupOnTime(uint8_t powerGroup)
+{
+    uint32_t onTime_ms = 0;
+    for (uint8_t s = 0; s < _sensorCount; s++)
+    {
+        if (_sensorPowerGroup[s] == powerGroup)
+        {
+            onTime_ms = max(onTime_ms, _sensorList[s]->getMinimumPoweredTime());
+        }
+    }
+    return onTime_ms;
+}
+
+
+// This returns how long after the start of an update a power pin should be
+// turned on.  Pins that are not staggered are turned on right away.  When
+// staggered, each pin is turned on just late enough that all of its sensors
+// should finish at the same time as the slowest pin.  Any power not controlled
+// by this library (pin -1) is always on, so it is never delayed.
+uint32_t VariableArray::getPowerPinStartOffset(uint8_t powerGroup)
+{
+    if (!_staggerPowerUp || _powerGroupPin[powerGroup] < 0) return 0;
+    return _predictedCycleTime_ms - getPowerGroupOnTime(powerGroup);
+}
+
+
+// This sets the current drawn by everything on each power pin, for the energy
+// predictions
+void VariableArray::setPowerPinCurrents(const int8_t powerPins[],
+                                        const float currents_mA[], uint8_t pinCount)
+{
+    _currentPins = powerPins;
+    _pinCurrents_mA = currents_mA;
+    _currentPinCount = (powerPins != NULL && currents_mA != NULL) ? pinCount : 0;
+}
+
+
+// Private helper function - This looks up the current drawn by a power pin
+float VariableArray::getPowerPinCurrent(int8_t powerPin)
+{
+    for (uint8_t i = 0; i < _currentPinCount; i++)
+    {
+        if (_currentPins[i] == powerPin) return _pinCurrents_mA[i];
+    }
+    return 0;
+}
+
+
+// This returns the predicted time a power pin will be on during an update
+// Power not controlled by this library is counted for the whole update.
+uint32_t VariableArray::getPredictedPowerPinOnTime(int8_t powerPin)
+{
+    for (uint8_t g = 0; g < _powerGroupCount; g++)
+    {
+        if (_powerGroupPin[g] == powerPin)
+        {
+            if (powerPin < 0) return _predictedCycleTime_ms;
+            return getPowerGroupOnTime(g);
+        }
+    }
+    return 0;
+}
+
+
+// This returns the predicted energy (in mJ) used by the sensors in an update
+float VariableArray::getPredictedEnergyPerCycle(float supplyVoltage)
+{
+    float energy_mJ = 0;
+    for (uint8_t g = 0; g < _powerGroupCount; g++)
+    {
+        // mA * V = mW, and mW * ms = uJ
+        energy_mJ += getPowerPinCurrent(_powerGroupPin[g])*supplyVoltage*
+                     getPredictedPowerPinOnTime(_powerGroupPin[g])/1000;
+    }
+    return energy_mJ;
+}
+
+
+// This prints out the power plan for the sensors to a stream
+void VariableArray::printPowerPlan(Stream *stream, float supplyVoltage)
+{
+    stream->print(F("A complete update should take about "));
+    stream->print(_predictedCycleTime_ms);
+    stream->println(F(" ms."));
+    for (uint8_t g = 0; g < _powerGroupCount; g++)
+    {
+        stream->print(F("Power pin "));
+        stream->print(_powerGroupPin[g]);
+        stream->print(F(" turns on at "));
+        stream->print(getPowerPinStartOffset(g));
+        stream->print(F(" ms and stays on for "));
+        stream->print(getPredictedPowerPinOnTime(_powerGroupPin[g]));
+        stream->print(F(" ms at "));
+        stream->print(getPowerPinCurrent(_powerGroupPin[g]));
+        stream->println(F(" mA"));
+        for (uint8_t s = 0; s < _sensorCount; s++)
+        {
+            if (_sensorPowerGroup[s] == g)
+            {
+                stream->print(F("    "));
+                stream->println(_sensorList[s]->getSensorNameAndLocation());
+            }
+        }
+    }
+    stream->print(F("Predicted sensor energy per update: "));
+    stream->print(getPredictedEnergyPerCycle(supplyVoltage));
+    stream->print(F(" mJ at "));
+    stream->print(supplyVoltage);
+    stream->println(F(" V"));
+}
+
+
+// This reads the number of measurements to average from each sensor and
+// totals up the number that must be taken before each pin can be turned off.
+// This is done at the start of every update, so the number of measurements
+// can be changed at any time.
+void VariableArray::countMeasurementsToAverage(void)
+{
+    for (uint8_t g = 0; g < _powerGroupCount; g++)
+    {
+        _powerGroupMeasurements[g] = 0;
+    }
+    for (uint8_t s = 0; s < _sensorCount; s++)
+    {
+        _sensorMeasurementsToAverage[s] = _sensorList[s]->getNumberMeasurementsToAverage();
+        _powerGroupMeasurements[_sensorPowerGroup[s]] += _sensorMeasurementsToAverage[s];
+    }
+    _maxSamplestoAverage = countMaxToAverage();
+
+    // The sensors' powered times depend on the number of measurements, so
+    // the update takes as long as the slowest pin with the current numbers
+    _predictedCycleTime_ms = 0;
+    for (uint8_t g = 0; g < _powerGroupCount; g++)
+    {
+        _predictedCycleTime_ms = max(_predictedCycleTime_ms, getPowerGroupOnTime(g));
     }
 }
 
@@ -926,12 +1189,9 @@ bool VariableArray::isLastVarFromSensor(int arrayIndex)
 uint8_t VariableArray::countMaxToAverage(void)
 {
     uint8_t numReps = 0;
-    for (uint8_t i = 0; i < _variableCount; i++)
+    for (uint8_t s = 0; s < _sensorCount; s++)
     {
-        if (isLastVarFromSensor(i)) // Skip non-unique sensors
-        {
-            numReps = max(numReps, arrayOfVars[i]->parentSensor->getNumberMeasurementsToAverage());
-        }
+        numReps = max(numReps, _sensorMeasurementsToAverage[s]);
     }
     // MS_DBG(F("The largest number of measurements to average will be"), numReps);
     return numReps;
@@ -29,6 +29,31 @@
 #undef MS_DEBUGGING_DEEP
 #include "VariableBase.h"
 #include "SensorBase.h"
+class loggerModem;  // Forward declaration
+
+// Bring in the library to put the processor in idle mode while waiting on sensors
+#if defined(ARDUINO_ARCH_AVR) || defined(__AVR__)
+  #include <avr/sleep.h>
+#endif
+
+// The shortest wait (in ms) worth putting the processor into idle mode for
+#ifndef MS_MIN_IDLE_SLEEP_MS
+#define MS_MIN_IDLE_SLEEP_MS 5
+#endif
+
+// The largest number of unique sensors in a single variable array
+#ifndef MAX_NUMBER_SENSORS
+#define MAX_NUMBER_SENSORS 25
+#endif
+
+// This is a single entry in the queue of sensor deadlines used to schedule
+// the sensors in the update functions.  The sensor index is the position of
+// the sensor in the array's sensor list.
+typedef struct sensorDeadline
+{
+    uint32_t dueTime;
+    uint8_t sensorIndex;
+} sensorDeadline;
 
 // Defines another class for interfacing with a list of pointers to sensor instances
 class VariableArray
@@ -88,27 +113,114 @@ public:
     bool updateAllSensors(void);
 
     // This function powers, wakes, updates values, sleeps and powers down.
-    bool completeUpdate(void);
+    // If a modem is given that has been told to start connecting to the
+    // internet (loggerModem::startConnectInternet()), the connection steps
+    // are run while waiting on the sensors, so the connection is ready (or
+    // nearly so) when the sensors are done.
+    // NOTE:  The stepped connection stops once the modem is registered on
+    // the network.  The data connection is opened afterwards, by
+    // loggerModem::finishConnectInternet(), so it never holds up the sensors.
+    bool completeUpdate(loggerModem *connectingModem = NULL);
+
+    // This calculates and stores the value of every calculated variable,
+    // with each one after the calculated variables it depends on.
+    // This is called at the end of updateAllSensors() and completeUpdate().
+    void refreshCalculatedVariables(void);
 
     // This function prints out the results for any connected sensors to a stream
     void printSensorData(Stream *stream = &Serial);
 
+    // This sets whether the processor should be put into a light "idle" sleep
+    // while waiting for the next sensor deadline in the update functions.
+    // In idle mode the processor core is stopped but the clocks, timers, and
+    // serial ports keep running, so millis() stays correct and any interrupt
+    // (including the millis() timer tick) wakes the processor.
+    // This is off by default.
+    void setIdleSleep(bool enableIdleSleep){_idleSleep = enableIdleSleep;}
+
+    // This sets whether the power pins should be turned on all at once at the
+    // beginning of completeUpdate() or staggered.  When staggered, each power
+    // pin is turned on just late enough that its sensors should finish at the
+    // same time as the slowest pin, based on the warm-up, stabilization, and
+    // measurement times and the number of measurements to average.  Sensors
+    // sharing a power pin are always powered together.
+    // This is off by default.
+    void setStaggeredPowerUp(bool staggerPowerUp){_staggerPowerUp = staggerPowerUp;}
+
+    // These functions predict the power use of the sensors over a complete
+    // update, for sizing batteries and solar panels.  The predictions use the
+    // shortest possible time each pin can be on; real updates will be longer.
+    // Set the current drawn (in mA) by everything on each power pin while it
+    // is on.  The arrays are supplied by the user and must stay in scope, ie:
+    //     const int8_t powerPins[] = {22, -1};
+    //     const float pinCurrents_mA[] = {45.0, 2.5};
+    //     varArray.setPowerPinCurrents(powerPins, pinCurrents_mA, 2);
+    // Pins that aren't listed are counted as drawing no current.
+    void setPowerPinCurrents(const int8_t powerPins[], const float currents_mA[],
+                             uint8_t pinCount);
+    // The predicted length (in ms) of a complete update
+    uint32_t getPredictedCycleTime(void){return _predictedCycleTime_ms;}
+    // The predicted time (in ms) a power pin will be on during an update
+    uint32_t getPredictedPowerPinOnTime(int8_t powerPin);
+    // The predicted energy (in mJ) used by the sensors in an update
+    float getPredictedEnergyPerCycle(float supplyVoltage = 3.3);
+    // This prints out the power plan to a stream
+    void printPowerPlan(Stream *stream = &Serial, float supplyVoltage = 3.3);
+
 protected:
     uint8_t _variableCount;
     uint8_t _sensorCount;
     uint8_t _maxSamplestoAverage;
+    bool _idleSleep;
+
+    // This is the "plan" for the sensors in the array.  It is built once by
+    // begin() so none of the functions looping through the sensors need to
+    // work out which variables belong to which sensors.
+    // The unique sensors, in the order of the last variable from each
+    Sensor *_sensorList[MAX_NUMBER_SENSORS];
+    // The number of measurements to average from each sensor, read again at
+    // the start of each update
+    uint8_t _sensorMeasurementsToAverage[MAX_NUMBER_SENSORS];
+    // The power pin group each sensor belongs to
+    uint8_t _sensorPowerGroup[MAX_NUMBER_SENSORS];
+    // The number of unique power pins, the pin for each group, and the total
+    // number of measurements to take before the pin can be turned off
+    uint8_t _powerGroupCount;
+    int8_t _powerGroupPin[MAX_NUMBER_SENSORS];
+    uint8_t _powerGroupMeasurements[MAX_NUMBER_SENSORS];
+    // The shortest time for a complete update
+    uint32_t _predictedCycleTime_ms;
+    // The user-supplied current drawn by each power pin
+    const int8_t *_currentPins;
+    const float *_pinCurrents_mA;
+    uint8_t _currentPinCount;
+    bool _staggerPowerUp;
 
 private:
-    bool isLastVarFromSensor(int arrayIndex);
+    void buildSensorPlan(void);
+    uint32_t getPowerGroupOnTime(uint8_t powerGroup);
+    uint32_t getPowerPinStartOffset(uint8_t powerGroup);
+    float getPowerPinCurrent(int8_t powerPin);
+    void countMeasurementsToAverage(void);
     uint8_t countMaxToAverage(void);
     bool checkVariableUUIDs(void);
 
+    // These keep a min-heap of sensor deadlines so the update functions only
+    // need to check the sensor that is due next.
+    // NOTE:  Time stamps are compared by difference so millis() roll-over is ok.
+    void pushDeadline(sensorDeadline queue[], uint8_t &queueSize,
+                      uint32_t dueTime, uint8_t sensorIndex);
+    sensorDeadline popDeadline(sensorDeadline queue[], uint8_t &queueSize);
+    void waitForDeadline(uint32_t dueTime);
+    void waitForDeadline(uint32_t dueTime, loggerModem *connectingModem);
+    void idleUntil(uint32_t dueTime);
+
 #ifdef MS_VARIABLEARRAY_DEBUG_DEEP
     template<typename T>
-    void prettyPrintArray(T arrayToPrint[])
+    void prettyPrintArray(T arrayToPrint[], uint8_t count)
     {
         DEEP_DEBUGGING_SERIAL_OUTPUT.print("[,\t");
-        for (uint8_t i = 0; i < _variableCount; i++)
+        for (uint8_t i = 0; i < count; i++)
         {
             DEEP_DEBUGGING_SERIAL_OUTPUT.print(arrayToPrint[i]);
             DEEP_DEBUGGING_SERIAL_OUTPUT.print(",\t");
@@ -33,11 +33,17 @@ Variable::Variable(Sensor *parentSense,
 
     isCalculated = false;
     _calcFxn = NULL;
+    _parentStats = NULL;
+    _statistic = 0;
     attachSensor(parentSense);
 
     // When we create the variable, we also want to initialize it with a current
     // value of -9999 (ie, a bad result).
     _currentValue = -9999;
+    _dependencies = NULL;
+    _dependencyCount = 0;
+    _valueCalculated = false;
+    _calculating = false;
 
     // MS_DBG(F("Measured Variable object created"));
 }
@@ -56,16 +62,57 @@ Variable::Variable(const uint8_t sensorVarNum,
 
     isCalculated = false;
     _calcFxn = NULL;
+    _parentStats = NULL;
+    _statistic = 0;
     parentSensor = NULL;
 
     // When we create the variable, we also want to initialize it with a current
     // value of -9999 (ie, a bad result).
     _currentValue = -9999;
+    _dependencies = NULL;
+    _dependencyCount = 0;
+    _valueCalculated = false;
+    _calculating = false;
 
     // MS_DBG(F("Measured Variable object created"));
 }
 
 
+// The constructor for a variable reporting a statistic of a sensor result.
+// This is a measured variable with the same parent sensor as the result, but
+// it is updated by the statistics instead of by the sensor's value array.
+Variable::Variable(ResultStatistics *parentStats,
+                   uint8_t statistic,
+                   uint8_t decimalResolution,
+                   const char *varName,
+                   const char *varUnit,
+                   const char *varCode,
+                   const char *uuid)
+  : _sensorVarNum(parentStats->sensorVarNum)
+{
+    setVarUUID(uuid);
+    setVarCode(varCode);
+    setVarUnit(varUnit);
+    setVarName(varName);
+    setResolution(decimalResolution);
+
+    isCalculated = false;
+    _calcFxn = NULL;
+    parentSensor = parentStats->parentSensor;
+    _parentStats = parentStats;
+    _statistic = statistic;
+    _parentStats->registerVariable(statistic, this);
+
+    // When we create the variable, we also want to initialize it with a current
+    // value of -9999 (ie, a bad result).
+    _currentValue = -9999;
+    _dependencies = NULL;
+    _dependencyCount = 0;
+    _valueCalculated = false;
+    _calculating = false;
+}
+
+
 // The constructor for a calculated variable  - that is, one whose value is
 // calculated by the calcFxn which returns a float.
 Variable::Variable(float (*calcFxn)(),
@@ -85,10 +132,16 @@ Variable::Variable(float (*calcFxn)(),
     isCalculated = true;
     setCalculation(calcFxn);
     parentSensor = NULL;
+    _parentStats = NULL;
+    _statistic = 0;
 
     // When we create the variable, we also want to initialize it with a current
     // value of -9999 (ie, a bad result).
     _currentValue = -9999;
+    _dependencies = NULL;
+    _dependencyCount = 0;
+    _valueCalculated = false;
+    _calculating = false;
 
     // MS_DBG(F("Calculated Variable object created"));
 }
@@ -108,10 +161,16 @@ Variable::Variable(float (*calcFxn)(),
     isCalculated = true;
     setCalculation(calcFxn);
     parentSensor = NULL;
+    _parentStats = NULL;
+    _statistic = 0;
 
     // When we create the variable, we also want to initialize it with a current
     // value of -9999 (ie, a bad result).
     _currentValue = -9999;
+    _dependencies = NULL;
+    _dependencyCount = 0;
+    _valueCalculated = false;
+    _calculating = false;
 
     // MS_DBG(F("Calculated Variable object created"));
 }
@@ -126,11 +185,17 @@ Variable::Variable()
 
     isCalculated = true;
     _calcFxn = NULL;
+    _parentStats = NULL;
+    _statistic = 0;
     parentSensor = NULL;
 
     // When we create the variable, we also want to initialize it with a current
     // value of -9999 (ie, a bad result).
     _currentValue = -9999;
+    _dependencies = NULL;
+    _dependencyCount = 0;
+    _valueCalculated = false;
+    _calculating = false;
 
     // MS_DBG(F("Calculated Variable object created"));
 }
@@ -213,7 +278,8 @@ void Variable::onSensorUpdate(Sensor *parentSense)
 {
     if (!isCalculated)
     {
-        _currentValue = parentSense->sensorValues[_sensorVarNum];
+        if (_parentStats != NULL) _currentValue = _parentStats->getStatistic(_statistic);
+        else _currentValue = parentSense->sensorValues[_sensorVarNum];
         MS_DBG(F("... received"), _currentValue);
     }
 }
@@ -266,6 +332,7 @@ void Variable::setCalculation(float (*calcFxn)())
     {
         // MS_DBG(F("Calculation function set"));
         _calcFxn = calcFxn;
+        _valueCalculated = false;
     }
     // else
     // {
@@ -388,7 +455,15 @@ float Variable::getValue(bool updateValue)
         // the calculation because we don't know which sensors those are.
         // Make sure you update the parent sensors manually for a calculated
         // variable!!
-        return _calcFxn();
+        // Use the stored result from the last variable array update, if
+        // there is one, unless asked to recalculate.
+        if (_valueCalculated && !updateValue) return _currentValue;
+        // Guard against a calculation that ends up depending on itself
+        if (_calculating) return -9999;
+        _calculating = true;
+        float value = _calcFxn();
+        _calculating = false;
+        return value;
     }
     else
     {
@@ -398,16 +473,133 @@ float Variable::getValue(bool updateValue)
 }
 
 
+// This declares the variables a calculated variable depends on
+Variable *Variable::setDependencies(Variable *dependencies[], uint8_t dependencyCount)
+{
+    _dependencies = dependencies;
+    _dependencyCount = dependencyCount;
+    return this;
+}
+
+
+// This checks if all of the calculated variables this one depends on have
+// stored results.  Measured variables are always ready.
+bool Variable::dependenciesCalculated(void)
+{
+    for (uint8_t i = 0; i < _dependencyCount; i++)
+    {
+        if (_dependencies[i] != NULL &&
+            _dependencies[i]->isCalculated &&
+            !_dependencies[i]->hasCalculatedValue())
+            return false;
+    }
+    return true;
+}
+
+
+// This runs the calculation and stores the result for getValue()
+float Variable::calculateValue(void)
+{
+    if (!isCalculated) return _currentValue;
+    _valueCalculated = false;
+    _currentValue = getValue();
+    _valueCalculated = true;
+    return _currentValue;
+}
+
+
 // This returns the current value of the variable as a string
 // with the correct number of significant figures
 String Variable::getValueString(bool updateValue)
 {
-    // Need this because otherwise get extra spaces in strings from int
-    if (_decimalResolution == 0)
+    char valueBuffer[VALUE_STRING_BUFFER_SIZE];
+    formatValue(valueBuffer, VALUE_STRING_BUFFER_SIZE, updateValue);
+    return String(valueBuffer);
+}
+
+
+// This writes the current value of the variable into a character buffer
+uint8_t Variable::formatValue(char *buffer, uint8_t bufferSize, bool updateValue)
+{
+    return formatFloat(getValue(updateValue), _decimalResolution, buffer, bufferSize);
+}
+
+
+// This writes a number to a buffer with a fixed number of decimal places.
+// This uses the same rounding as the Arduino Print class, but writes to a
+// buffer instead of a stream or a heap-allocated String.  With no decimal
+// places, the number is truncated, as getValueString() always did through an
+// int.
+uint8_t Variable::formatFloat(float value, uint8_t decimalResolution,
+                              char *buffer, uint8_t bufferSize)
+{
+    if (buffer == NULL || bufferSize == 0) return 0;
+
+    // Build the number in a scratch buffer so it can be cut to fit
+    // Room for a sign, 10 integer digits, a decimal point and the decimals
+    char scratch[VALUE_STRING_BUFFER_SIZE];
+    uint8_t len = 0;
+    if (decimalResolution > VALUE_STRING_BUFFER_SIZE - 13)
+        decimalResolution = VALUE_STRING_BUFFER_SIZE - 13;
+
+    if (value == -9999) {strcpy(scratch, "-9999"); len = 5;}
+    else if (isnan(value)) {strcpy(scratch, "nan"); len = 3;}
+    else if (isinf(value)) {strcpy(scratch, value < 0 ? "-inf" : "inf"); len = strlen(scratch);}
+    // An unsigned long can't hold the integer part of anything bigger
+    else if (value > 4294967040.0 || value < -4294967040.0) {strcpy(scratch, "ovf"); len = 3;}
+    else
     {
-        int16_t val = int(getValue(updateValue));
-        return String(val);
+        if (value < 0)
+        {
+            scratch[len++] = '-';
+            value = -value;
+        }
+
+        // Round to the number of decimal places
+        if (decimalResolution > 0)
+        {
+            float rounding = 0.5;
+            for (uint8_t i = 0; i < decimalResolution; i++) rounding /= 10.0;
+            value += rounding;
+        }
+
+        // Write out the integer part, backwards, then flip it
+        uint32_t intPart = (uint32_t)value;
+        float remainder = value - (float)intPart;
+        uint8_t intStart = len;
+        do
+        {
+            scratch[len++] = '0' + (intPart % 10);
+            intPart /= 10;
+        } while (intPart > 0);
+        for (uint8_t i = intStart, j = len - 1; i < j; i++, j--)
+        {
+            char c = scratch[i];
+            scratch[i] = scratch[j];
+            scratch[j] = c;
+        }
+
+        // Write out the decimal places one at a time
+        if (decimalResolution > 0) scratch[len++] = '.';
+        for (uint8_t i = 0; i < decimalResolution; i++)
+        {
+            remainder *= 10.0;
+            uint8_t digit = (uint8_t)remainder;
+            scratch[len++] = '0' + digit;
+            remainder -= digit;
+        }
+        scratch[len] = '\0';
+
+        // Don't write "-0" for a small negative number that comes out as zero
+        if (scratch[0] == '-' && strspn(scratch + 1, "0.") == (size_t)(len - 1))
+        {
+            memmove(scratch, scratch + 1, len);
+            len--;
+        }
     }
-    else
-    {return String(getValue(updateValue), _decimalResolution);}
+
+    if (len > bufferSize - 1) len = bufferSize - 1;
+    memcpy(buffer, scratch, len);
+    buffer[len] = '\0';
+    return len;
 }
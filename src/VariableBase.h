@@ -20,11 +20,16 @@
 
 // Forward Declared Dependences
 class Sensor;
+class ResultStatistics;
 
 // Included Dependencies
 #include "ModSensorDebugger.h"
 #undef MS_DEBUGGING_STD
 
+// The size of a character buffer big enough for any formatted value,
+// including the terminating null
+#define VALUE_STRING_BUFFER_SIZE 20
+
 class Variable
 {
 public:
@@ -43,6 +48,17 @@ public:
              const char *varUnit,
              const char *varCode);
 
+    // The constructor for a variable reporting one of the statistics (see the
+    // resultStatistic list in SensorBase.h) of the readings of a sensor result.
+    // The variable is updated along with the sensor's other variables.
+    Variable(ResultStatistics *parentStats,
+             uint8_t statistic,
+             uint8_t decimalResolution,
+             const char *varName,
+             const char *varUnit,
+             const char *varCode,
+             const char *uuid);
+
      // The constructors for a calculated variable - that is, one whose value is
      // calculated by the calcFxn which returns a float.
     Variable(float (*calcFxn)(),
@@ -96,6 +112,25 @@ public:
     // This ties a calculated variable to its calculation function
     void setCalculation(float (*calcFxn)());
 
+    // This declares the other variables whose values a calculated variable's
+    // function uses.  When a variable array updates, it calculates all of its
+    // calculated variables once, after their sensors are updated and in an
+    // order where every calculated variable comes after the calculated
+    // variables it depends on.  Until the next update, getValue() returns the
+    // stored result instead of running the calculation again.
+    // The dependency list must stay in scope; it is not copied.
+    // To get the benefit, calculation functions should use the getValue() of
+    // the other calculated variables rather than calling their functions.
+    Variable *setDependencies(Variable *dependencies[], uint8_t dependencyCount);
+    // This checks if all of the calculated variables this variable depends
+    // on have stored results
+    bool dependenciesCalculated(void);
+    // These run and store the calculation, clear the stored result, and check
+    // if there is a stored result
+    float calculateValue(void);
+    void clearCalculatedValue(void){_valueCalculated = false;}
+    bool hasCalculatedValue(void){return _valueCalculated;}
+
     // This sets up the variable (generally attaching it to its parent)
     // bool setup(void);
 
@@ -121,6 +156,19 @@ public:
     // This returns the current value of the variable as a string with the
     // correct number of significant figures
     String getValueString(bool updateValue = false);
+    // This writes the current value of the variable into a character buffer
+    // with the correct number of significant figures, and returns the number
+    // of characters written.  It does not allocate any memory, so it should
+    // be used instead of getValueString() for all output.
+    // The buffer should be at least VALUE_STRING_BUFFER_SIZE long.
+    uint8_t formatValue(char *buffer, uint8_t bufferSize, bool updateValue = false);
+    // This writes a number to a character buffer with the given number of
+    // decimal places, and returns the number of characters written.
+    // With no decimal places the number is truncated (12.7 is written as 12),
+    // and a negative number that comes out as zero is written without a sign.
+    // Bad values (-9999) are always written as "-9999".
+    static uint8_t formatFloat(float value, uint8_t decimalResolution,
+                               char *buffer, uint8_t bufferSize);
 
     // This is the parent sensor for the variable
     Sensor *parentSensor;
@@ -133,6 +181,16 @@ private:
     float (*_calcFxn)(void);
 
     const uint8_t _sensorVarNum;
+    // For a variable reporting a statistic, the source of the statistic
+    ResultStatistics *_parentStats;
+    uint8_t _statistic;
+
+    // For a calculated variable, the variables it depends on and whether the
+    // current value is a stored result of the calculation
+    Variable **_dependencies;
+    uint8_t _dependencyCount;
+    bool _valueCalculated;
+    bool _calculating;
     uint8_t _decimalResolution;
 
     const char *_varName;
@@ -9,6 +9,8 @@
 #include "dataPublisherBase.h"
 
 char dataPublisher::txBuffer[MS_SEND_BUFFER_SIZE] = {'\0'};
+uint16_t dataPublisher::txBufferLen = 0;
+Stream *dataPublisher::txBufferOutClient = NULL;
 
 // Basic chunks of HTTP
 const char *dataPublisher::getHeader = "GET ";
@@ -23,6 +25,7 @@ dataPublisher::dataPublisher()
     _inClient = NULL;
     _sendEveryX = 1;
     _sendOffset = 0;
+    _holdWarned = false;
     // MS_DBG(F("dataPublisher object created"));
 }
 dataPublisher::dataPublisher(Logger& baseLogger, uint8_t sendEveryX, uint8_t sendOffset)
@@ -31,6 +34,7 @@ dataPublisher::dataPublisher(Logger& baseLogger, uint8_t sendEveryX, uint8_t sen
     _baseLogger->registerDataPublisher(this);  // register self with logger
     _sendEveryX = sendEveryX;
     _sendOffset = sendOffset;
+    _holdWarned = false;
     _inClient = NULL;
     // MS_DBG(F("dataPublisher object created"));
 }
@@ -40,6 +44,7 @@ dataPublisher::dataPublisher(Logger& baseLogger, Client *inClient, uint8_t sendE
     _baseLogger->registerDataPublisher(this);  // register self with logger
     _sendEveryX = sendEveryX;
     _sendOffset = sendOffset;
+    _holdWarned = false;
     _inClient = inClient;
     // MS_DBG(F("dataPublisher object created"));
 }
@@ -60,7 +65,6 @@ void dataPublisher::attachToLogger(Logger& baseLogger)
 
 
 // Sets the parameters for frequency of sending and any offset, if needed
-// NOTE:  These parameters are not currently used!!
 void dataPublisher::setSendFrequency(uint8_t sendEveryX, uint8_t sendOffset)
 {
     _sendEveryX = sendEveryX;
@@ -68,6 +72,33 @@ void dataPublisher::setSendFrequency(uint8_t sendEveryX, uint8_t sendOffset)
 }
 
 
+// This checks if the publisher is due to send on the given logging interval
+bool dataPublisher::isSendDue(uint32_t intervalNumber)
+{
+    if (_sendEveryX <= 1) return true;
+    // A publisher with nowhere to keep the records in between sends every one
+    if (!isBatching() && (_baseLogger == NULL || !_baseLogger->isOutboxEnabled()))
+    {
+        return true;
+    }
+    return intervalNumber % _sendEveryX == _sendOffset % _sendEveryX;
+}
+
+
+// This is called when the publisher can't send the current record because
+// the connection failed.  Without a batch there's nowhere to keep it, so it's
+// lost; say so once.
+void dataPublisher::holdRecord(void)
+{
+    if (_holdWarned) return;
+    _holdWarned = true;
+    PRINTOUT(F("WARNING:"), getEndpoint(),
+             F("can't keep records to send later, so records from failed"),
+             F("connections will be lost!"),
+             F("Enable the logger's outbox to send every record."));
+}
+
+
 // "Begins" the publisher - attaches client and logger
 void dataPublisher::begin(Logger& baseLogger, Client *inClient)
 {
@@ -80,45 +111,104 @@ void dataPublisher::begin(Logger& baseLogger)
 }
 
 
-// Empties the outgoing buffer
-void dataPublisher::emptyTxBuffer(void)
+// Empties the outgoing buffer and sets where it will go
+void dataPublisher::txBufferInit(Stream *outClient)
 {
-    MS_DBG(F("Dumping the TX Buffer"));
-    for (int i = 0; i < MS_SEND_BUFFER_SIZE; i++)
-    {
-        txBuffer[i] = '\0';
-    }
+    txBufferOutClient = outClient;
+    txBufferLen = 0;
+    txBuffer[0] = '\0';
 }
 
 
-// Returns how much space is left in the buffer
-int dataPublisher::bufferFree(void)
+// Adds text to the outgoing buffer, sending the buffer out each time it fills
+void dataPublisher::txBufferAppend(const char *text, size_t length)
 {
-    MS_DBG(F("Current TX Buffer Size:"), strlen(txBuffer));
-    return MS_SEND_BUFFER_SIZE - strlen(txBuffer);
+    while (length > 0)
+    {
+        // Leave room for the null terminator
+        size_t room = MS_SEND_BUFFER_SIZE - 1 - txBufferLen;
+        if (room == 0)
+        {
+            // Without a stream to send to, there's nothing to do but drop it
+            if (txBufferOutClient == NULL)
+            {
+                MS_DBG(F("TX Buffer is full!"));
+                return;
+            }
+            txBufferFlush();
+            room = MS_SEND_BUFFER_SIZE - 1;
+        }
+        size_t nCopy = length < room ? length : room;
+        memcpy(&txBuffer[txBufferLen], text, nCopy);
+        txBufferLen += nCopy;
+        txBuffer[txBufferLen] = '\0';
+        text += nCopy;
+        length -= nCopy;
+    }
+}
+void dataPublisher::txBufferAppend(const char *text)
+{
+    txBufferAppend(text, strlen(text));
+}
+void dataPublisher::txBufferAppend(char c)
+{
+    txBufferAppend(&c, 1);
 }
 
 
-// Sends the tx buffer to a stream and then clears it
-void dataPublisher::printTxBuffer(Stream *stream, bool addNewLine)
+// Sends the outgoing buffer to the stream and then empties it
+void dataPublisher::txBufferFlush(bool addNewLine)
 {
     // Send the out buffer so far to the serial for debugging
     #if defined(STANDARD_SERIAL_OUTPUT)
-        STANDARD_SERIAL_OUTPUT.write(txBuffer, strlen(txBuffer));
+        STANDARD_SERIAL_OUTPUT.write(txBuffer, txBufferLen);
         if (addNewLine)
         {
             PRINTOUT('\n');
         }
         STANDARD_SERIAL_OUTPUT.flush();
     #endif
-    stream->write(txBuffer, strlen(txBuffer));
-    if (addNewLine) \
+    if (txBufferOutClient != NULL)
     {
-        stream->print("\r\n");
+        txBufferOutClient->write(txBuffer, txBufferLen);
+        if (addNewLine)
+        {
+            txBufferOutClient->print("\r\n");
+        }
+        txBufferOutClient->flush();
     }
-    stream->flush();
 
     // empty the buffer after printing it
+    txBufferLen = 0;
+    txBuffer[0] = '\0';
+}
+
+
+// Empties the outgoing buffer
+// The older functions may have filled the buffer with strcat() or by writing
+// after strlen(), so the whole buffer is cleared and its length is recounted
+// before it's used.
+void dataPublisher::emptyTxBuffer(void)
+{
+    memset(txBuffer, '\0', MS_SEND_BUFFER_SIZE);
+    txBufferLen = 0;
+}
+
+
+// Returns how much space is left in the buffer
+int dataPublisher::bufferFree(void)
+{
+    txBufferLen = strlen(txBuffer);
+    return MS_SEND_BUFFER_SIZE - 1 - txBufferLen;
+}
+
+
+// Sends the tx buffer to a stream and then clears it
+void dataPublisher::printTxBuffer(Stream *stream, bool addNewLine)
+{
+    txBufferLen = strlen(txBuffer);
+    txBufferOutClient = stream;
+    txBufferFlush(addNewLine);
     emptyTxBuffer();
 }
 
@@ -136,6 +226,28 @@ int16_t dataPublisher::publishData()
         return publishData(_inClient);
     }
 }
+
+
+// This sends the batch on the "default" client of the modem
+int16_t dataPublisher::publishBatch()
+{
+    if (_inClient == NULL)
+    {
+        PRINTOUT(F("ERROR! No web client assigned to publish data!"));
+        return 0;
+    }
+    else
+    {
+        return publishBatch(_inClient);
+    }
+}
+
+
+// This checks if the value returned by publishData() means the data was accepted
+bool dataPublisher::wasPublishSuccessful(int16_t result)
+{
+    return result >= 200 && result < 300;
+}
 // Duplicates for backwards compatibility
 int16_t dataPublisher::sendData(Client *_outClient)
 {
@@ -55,8 +55,23 @@ public:
     void attachToLogger(Logger& baseLogger);
 
     // Sets the parameters for frequency of sending and any offset, if needed
-    // NOTE:  These parameters are not currently used!!
+    // The publisher sends on the logging intervals whose number, divided by
+    // sendEveryX, leaves a remainder of sendOffset.  The intervals are
+    // numbered from the start of the epoch (Jan 1, 1970, in the logger's time
+    // zone), ie, the marked time divided by the logging interval.  For
+    // example, with a 5 minute logging interval, sendEveryX = 12 and
+    // sendOffset = 11 sends at 55 minutes past each hour.  The logger only
+    // publishes (and only powers up the modem) on intervals when at least one
+    // publisher is due.
+    // NOTE:  The intervals are only skipped by a publisher that can keep the
+    // records from them:  one collecting records into a batch (ie, EnviroDIY
+    // with a batch buffer), or any publisher once the logger's outbox is
+    // enabled (Logger::enableOutbox()).  Any other publisher still sends on
+    // every logging interval, so no records are lost.
     void setSendFrequency(uint8_t sendEveryX, uint8_t sendOffset);
+    // This checks if the publisher is due to send on the given logging
+    // interval number (counted from the start of the epoch)
+    bool isSendDue(uint32_t intervalNumber);
 
     // "Begins" the publisher - attaches client and logger
     // Not doing this in the constructor because we expect the publishers to be
@@ -76,6 +91,30 @@ public:
     // being available
     virtual int16_t publishData(Client *_outClient) = 0;
     virtual int16_t publishData();
+    // This checks if the value returned by publishData() means the data was
+    // accepted.  By default, that's any HTTP success (2xx) status code.
+    virtual bool wasPublishSuccessful(int16_t result);
+
+    // These let a publisher collect several records and send them all in a
+    // single request.  By default, a publisher sends one record at a time.
+    // This checks if the publisher is collecting records into a batch
+    virtual bool isBatching(void){return false;}
+    // This adds the current record to the batch, returning false if there
+    // isn't room for it
+    virtual bool addRecordToBatch(void){return false;}
+    // This returns the number of records in the batch
+    virtual uint8_t getBatchCount(void){return 0;}
+    // This sends every record in the batch in one request and empties the
+    // batch if they were accepted
+    virtual int16_t publishBatch(Client *_outClient){return 0;}
+    virtual int16_t publishBatch();
+    // This empties the batch
+    virtual void clearBatch(void){}
+    // This is called on logging intervals when the publisher isn't due to
+    // send or the connection failed, so a batching publisher can keep the
+    // record to send later.  A publisher that can't keep records only warns
+    // that the record is lost.
+    virtual void holdRecord(void);
     // These are duplicates of the above functions for backwards compatibility
     virtual int16_t sendData(Client *_outClient);
     virtual int16_t sendData();
@@ -90,16 +129,37 @@ protected:
     // The internal client
     Client *_inClient;
 
+    // The TX buffer is always null terminated and its length is tracked, so
+    // nothing needs to scan it to find the end.
     static char txBuffer[MS_SEND_BUFFER_SIZE];
+    static uint16_t txBufferLen;
+    // The stream the TX buffer is sent to when it fills up
+    static Stream *txBufferOutClient;
+
+    // This empties the TX buffer and sets the stream it will be sent to when
+    // it fills up.  With no stream, anything that doesn't fit is dropped.
+    static void txBufferInit(Stream *outClient);
+    // These add text to the TX buffer, sending out the buffer whenever it's
+    // full so the text is never cut off
+    static void txBufferAppend(const char *text, size_t length);
+    static void txBufferAppend(const char *text);
+    static void txBufferAppend(char c);
+    // This sends the TX buffer to the stream and the debugging port, then
+    // empties it
+    static void txBufferFlush(bool addNewLine = false);
+
+    // These are the older functions for working with the TX buffer
     // This returns the number of empty spots in the buffer
     static int bufferFree(void);
-    // This fills the TX buffer with nulls ('\0')
+    // This empties the TX buffer
     static void emptyTxBuffer(void);
     // This writes the TX buffer to a stream and also to the debugging port
     static void printTxBuffer(Stream *stream, bool addNewLine = false);
 
     uint8_t _sendEveryX;
     uint8_t _sendOffset;
+    // Whether the warning about records not being kept has been printed
+    bool _holdWarned;
 
     // Basic chunks of HTTP
     static const char *getHeader;
@@ -38,6 +38,7 @@ DigiXBeeCellularTransparent::~DigiXBeeCellularTransparent(){}
 
 MS_MODEM_DID_AT_RESPOND(DigiXBeeCellularTransparent);
 MS_MODEM_IS_INTERNET_AVAILABLE(DigiXBeeCellularTransparent);
+MS_MODEM_IS_NETWORK_REGISTERED(DigiXBeeCellularTransparent);
 MS_MODEM_VERIFY_MEASUREMENT_COMPLETE(DigiXBeeCellularTransparent);
 MS_MODEM_GET_MODEM_SIGNAL_QUALITY(DigiXBeeCellularTransparent);
 MS_MODEM_GET_MODEM_BATTERY_NA(DigiXBeeCellularTransparent);
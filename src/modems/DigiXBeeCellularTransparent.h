@@ -70,6 +70,7 @@ public:
 protected:
     bool didATRespond(void) override;
     bool isInternetAvailable(void) override;
+    bool isNetworkRegistered(void) override;
     bool verifyMeasurementComplete(bool debug=false) override;
     bool extraModemSetup(void) override;
 
@@ -38,6 +38,7 @@ DigiXBeeLTEBypass::~DigiXBeeLTEBypass(){}
 
 MS_MODEM_DID_AT_RESPOND(DigiXBeeLTEBypass);
 MS_MODEM_IS_INTERNET_AVAILABLE(DigiXBeeLTEBypass);
+MS_MODEM_IS_NETWORK_REGISTERED(DigiXBeeLTEBypass);
 MS_MODEM_VERIFY_MEASUREMENT_COMPLETE(DigiXBeeLTEBypass);
 MS_MODEM_GET_MODEM_SIGNAL_QUALITY(DigiXBeeLTEBypass);
 MS_MODEM_GET_MODEM_BATTERY_AVAILABLE(DigiXBeeLTEBypass);
@@ -40,6 +40,7 @@ DigiXBeeWifi::~DigiXBeeWifi(){}
 
 MS_MODEM_DID_AT_RESPOND(DigiXBeeWifi);
 MS_MODEM_IS_INTERNET_AVAILABLE(DigiXBeeWifi);
+MS_MODEM_IS_NETWORK_REGISTERED(DigiXBeeWifi);
 MS_MODEM_GET_MODEM_BATTERY_AVAILABLE(DigiXBeeWifi);
 MS_MODEM_GET_MODEM_TEMPERATURE_AVAILABLE(DigiXBeeWifi);
 MS_MODEM_CONNECT_INTERNET(DigiXBeeWifi);
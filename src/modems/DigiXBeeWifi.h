@@ -69,6 +69,7 @@ public:
 protected:
     bool didATRespond(void) override;
     bool isInternetAvailable(void) override;
+    bool isNetworkRegistered(void) override;
     bool verifyMeasurementComplete(bool debug=false) override;
     bool extraModemSetup(void) override;
 
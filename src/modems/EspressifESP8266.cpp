@@ -51,6 +51,7 @@ EspressifESP8266::~EspressifESP8266(){}
 
 MS_MODEM_DID_AT_RESPOND(EspressifESP8266);
 MS_MODEM_IS_INTERNET_AVAILABLE(EspressifESP8266);
+MS_MODEM_IS_NETWORK_REGISTERED(EspressifESP8266);
 MS_MODEM_VERIFY_MEASUREMENT_COMPLETE(EspressifESP8266);
 MS_MODEM_GET_MODEM_SIGNAL_QUALITY(EspressifESP8266);
 MS_MODEM_GET_MODEM_BATTERY_NA(EspressifESP8266);
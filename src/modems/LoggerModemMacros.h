@@ -33,6 +33,24 @@
     }
 #endif
 
+// This checks if the modem is registered on the network, whether or not it
+// has a data connection yet
+#if defined TINY_GSM_MODEM_XBEE || defined TINY_GSM_MODEM_HAS_GPRS
+#define MS_MODEM_IS_NETWORK_REGISTERED(specificModem) \
+    bool specificModem::isNetworkRegistered(void)     \
+    {                                                 \
+        return gsmModem.isNetworkConnected();         \
+    }
+#else
+// Wifi modems without the connection parameters saved to flash can't join the
+// network until connectInternet() sends them, so don't wait for them
+#define MS_MODEM_IS_NETWORK_REGISTERED(specificModem) \
+    bool specificModem::isNetworkRegistered(void)     \
+    {                                                 \
+        return true;                                  \
+    }
+#endif
+
 // This checks to see if enough time has passed for measurement completion
 // In the case of the modem, we consider a measurement to be "complete" when
 // the modem has registered on the network *and* returns good signal strength.
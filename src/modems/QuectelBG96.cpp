@@ -42,6 +42,7 @@ QuectelBG96::~QuectelBG96(){}
 
 MS_MODEM_DID_AT_RESPOND(QuectelBG96);
 MS_MODEM_IS_INTERNET_AVAILABLE(QuectelBG96);
+MS_MODEM_IS_NETWORK_REGISTERED(QuectelBG96);
 MS_MODEM_VERIFY_MEASUREMENT_COMPLETE(QuectelBG96);
 MS_MODEM_GET_MODEM_SIGNAL_QUALITY(QuectelBG96);
 MS_MODEM_GET_MODEM_BATTERY_AVAILABLE(QuectelBG96);
@@ -42,6 +42,7 @@ SIMComSIM7000::~SIMComSIM7000(){}
 
 MS_MODEM_DID_AT_RESPOND(SIMComSIM7000);
 MS_MODEM_IS_INTERNET_AVAILABLE(SIMComSIM7000);
+MS_MODEM_IS_NETWORK_REGISTERED(SIMComSIM7000);
 MS_MODEM_VERIFY_MEASUREMENT_COMPLETE(SIMComSIM7000);
 MS_MODEM_GET_MODEM_SIGNAL_QUALITY(SIMComSIM7000);
 MS_MODEM_GET_MODEM_BATTERY_AVAILABLE(SIMComSIM7000);
@@ -44,6 +44,7 @@ SIMComSIM800::~SIMComSIM800(){}
 
 MS_MODEM_DID_AT_RESPOND(SIMComSIM800);
 MS_MODEM_IS_INTERNET_AVAILABLE(SIMComSIM800);
+MS_MODEM_IS_NETWORK_REGISTERED(SIMComSIM800);
 MS_MODEM_VERIFY_MEASUREMENT_COMPLETE(SIMComSIM800);
 MS_MODEM_GET_MODEM_SIGNAL_QUALITY(SIMComSIM800);
 MS_MODEM_GET_MODEM_BATTERY_AVAILABLE(SIMComSIM800);
@@ -42,6 +42,7 @@ SequansMonarch::~SequansMonarch(){}
 
 MS_MODEM_DID_AT_RESPOND(SequansMonarch);
 MS_MODEM_IS_INTERNET_AVAILABLE(SequansMonarch);
+MS_MODEM_IS_NETWORK_REGISTERED(SequansMonarch);
 MS_MODEM_VERIFY_MEASUREMENT_COMPLETE(SequansMonarch);
 MS_MODEM_GET_MODEM_SIGNAL_QUALITY(SequansMonarch);
 MS_MODEM_GET_MODEM_BATTERY_NA(SequansMonarch);
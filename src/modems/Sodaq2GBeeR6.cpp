@@ -67,6 +67,7 @@ Sodaq2GBeeR6::~Sodaq2GBeeR6(){}
 
 MS_MODEM_DID_AT_RESPOND(Sodaq2GBeeR6);
 MS_MODEM_IS_INTERNET_AVAILABLE(Sodaq2GBeeR6);
+MS_MODEM_IS_NETWORK_REGISTERED(Sodaq2GBeeR6);
 MS_MODEM_VERIFY_MEASUREMENT_COMPLETE(Sodaq2GBeeR6);
 MS_MODEM_GET_MODEM_SIGNAL_QUALITY(Sodaq2GBeeR6);
 MS_MODEM_GET_MODEM_BATTERY_AVAILABLE(Sodaq2GBeeR6);
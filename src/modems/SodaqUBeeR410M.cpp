@@ -68,6 +68,7 @@ SodaqUBeeR410M::~SodaqUBeeR410M(){}
 
 MS_MODEM_DID_AT_RESPOND(SodaqUBeeR410M);
 MS_MODEM_IS_INTERNET_AVAILABLE(SodaqUBeeR410M);
+MS_MODEM_IS_NETWORK_REGISTERED(SodaqUBeeR410M);
 MS_MODEM_VERIFY_MEASUREMENT_COMPLETE(SodaqUBeeR410M);
 MS_MODEM_GET_MODEM_SIGNAL_QUALITY(SodaqUBeeR410M);
 MS_MODEM_GET_MODEM_BATTERY_AVAILABLE(SodaqUBeeR410M);
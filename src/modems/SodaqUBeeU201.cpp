@@ -42,6 +42,7 @@ SodaqUBeeU201::~SodaqUBeeU201(){}
 
 MS_MODEM_DID_AT_RESPOND(SodaqUBeeU201);
 MS_MODEM_IS_INTERNET_AVAILABLE(SodaqUBeeU201);
+MS_MODEM_IS_NETWORK_REGISTERED(SodaqUBeeU201);
 MS_MODEM_VERIFY_MEASUREMENT_COMPLETE(SodaqUBeeU201);
 MS_MODEM_GET_MODEM_SIGNAL_QUALITY(SodaqUBeeU201);
 MS_MODEM_GET_MODEM_BATTERY_AVAILABLE(SodaqUBeeU201);
@@ -75,12 +75,14 @@ void DreamHostPublisher::printSensorDataDreamHost(Stream *stream)
     stream->print(timestampTagDH);
     stream->print(String(Logger::markedEpochTime - 946684800));  // Correct time from epoch to y2k
 
+    char valueBuffer[VALUE_STRING_BUFFER_SIZE];
     for (uint8_t i = 0; i < _baseLogger->getArrayVarCount(); i++)
     {
         stream->print('&');
         stream->print(_baseLogger->getVarCodeAtI(i));
         stream->print('=');
-        stream->print(_baseLogger->getValueStringAtI(i));
+        _baseLogger->formatValueAtI(i, valueBuffer);
+        stream->print(valueBuffer);
     }
 }
 
@@ -133,47 +135,41 @@ int16_t DreamHostPublisher::publishData(Client *_outClient)
     {
         MS_DBG(F("Client connected after"), MS_PRINT_DEBUG_TIMER, F("ms\n"));
 
+        // Start the outgoing buffer, which will be sent out to the client
+        // whenever it fills
+        txBufferInit(_outClient);
+
         // copy the initial post header into the tx buffer
-        strcpy(txBuffer, getHeader);
+        txBufferAppend(getHeader);
 
         // add in the dreamhost receiver URL
-        strcat(txBuffer, _DreamHostPortalRX);
+        txBufferAppend(_DreamHostPortalRX);
 
         // start the URL parameters
-        if (bufferFree() < 16) printTxBuffer(_outClient);
-        strcat(txBuffer, loggerTag);
-        strcat(txBuffer, _baseLogger->getLoggerID());
+        txBufferAppend(loggerTag);
+        txBufferAppend(_baseLogger->getLoggerID());
 
-        if (bufferFree() < 22) printTxBuffer(_outClient);
-        strcat(txBuffer, timestampTagDH);
+        txBufferAppend(timestampTagDH);
         ltoa((Logger::markedEpochTime - 946684800), tempBuffer, 10);  // BASE 10
-        strcat(txBuffer, tempBuffer);
+        txBufferAppend(tempBuffer);
 
         for (uint8_t i = 0; i < _baseLogger->getArrayVarCount(); i++)
         {
-            // Once the buffer fills, send it out
-            if (bufferFree() < 47) printTxBuffer(_outClient);
-
-            txBuffer[strlen(txBuffer)] = '&';
+            txBufferAppend('&');
             _baseLogger->getVarCodeAtI(i).toCharArray(tempBuffer, 37);
-            strcat(txBuffer, tempBuffer);
-            txBuffer[strlen(txBuffer)] = '=';
-            _baseLogger->getValueStringAtI(i).toCharArray(tempBuffer, 37);
-            strcat(txBuffer, tempBuffer);
+            txBufferAppend(tempBuffer);
+            txBufferAppend('=');
+            txBufferAppend(tempBuffer, _baseLogger->formatValueAtI(i, tempBuffer, 37));
         }
 
         // add the rest of the HTTP GET headers to the outgoing buffer
-        if (bufferFree() < 52) printTxBuffer(_outClient);
-        strcat(txBuffer, HTTPtag);
-        strcat(txBuffer, hostHeader);
-        strcat(txBuffer, dreamhostHost);
-        txBuffer[strlen(txBuffer)] = '\r';
-        txBuffer[strlen(txBuffer)] = '\n';
-        txBuffer[strlen(txBuffer)] = '\r';
-        txBuffer[strlen(txBuffer)] = '\n';
+        txBufferAppend(HTTPtag);
+        txBufferAppend(hostHeader);
+        txBufferAppend(dreamhostHost);
+        txBufferAppend("\r\n\r\n", 4);
 
         // Send out the finished request (or the last unsent section of it)
-        printTxBuffer(_outClient);
+        txBufferFlush();
 
         // Wait 10 seconds for a response from the server
         uint32_t start = millis();
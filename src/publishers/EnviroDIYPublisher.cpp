@@ -28,24 +28,28 @@ const char *EnviroDIYPublisher::contentTypeHeader = "\r\nContent-Type: applicati
 
 const char *EnviroDIYPublisher::samplingFeatureTag = "{\"sampling_feature\":\"";
 const char *EnviroDIYPublisher::timestampTag = "\",\"timestamp\":\"";
+const char *EnviroDIYPublisher::timestampArrayTag = "\",\"timestamp\":[";
 
 
 // Constructors
 EnviroDIYPublisher::EnviroDIYPublisher()
   : dataPublisher()
 {
+    setBatchBuffer(NULL, 0);
     // MS_DBG(F("dataPublisher object created"));
 }
 EnviroDIYPublisher::EnviroDIYPublisher(Logger& baseLogger,
                                  uint8_t sendEveryX, uint8_t sendOffset)
   : dataPublisher(baseLogger, sendEveryX, sendOffset)
 {
+    setBatchBuffer(NULL, 0);
     // MS_DBG(F("dataPublisher object created"));
 }
 EnviroDIYPublisher::EnviroDIYPublisher(Logger& baseLogger, Client *inClient,
                                  uint8_t sendEveryX, uint8_t sendOffset)
   : dataPublisher(baseLogger, inClient, sendEveryX, sendOffset)
 {
+    setBatchBuffer(NULL, 0);
     // MS_DBG(F("dataPublisher object created"));
 }
 EnviroDIYPublisher::EnviroDIYPublisher(Logger& baseLogger,
@@ -54,6 +58,7 @@ EnviroDIYPublisher::EnviroDIYPublisher(Logger& baseLogger,
                                  uint8_t sendEveryX, uint8_t sendOffset)
   : dataPublisher(baseLogger, sendEveryX, sendOffset)
 {
+    setBatchBuffer(NULL, 0);
     setToken(registrationToken);
     _baseLogger->setSamplingFeatureUUID(samplingFeatureUUID);
     // MS_DBG(F("dataPublisher object created"));
@@ -64,6 +69,7 @@ EnviroDIYPublisher::EnviroDIYPublisher(Logger& baseLogger, Client *inClient,
                                  uint8_t sendEveryX, uint8_t sendOffset)
   : dataPublisher(baseLogger, inClient, sendEveryX, sendOffset)
 {
+    setBatchBuffer(NULL, 0);
     setToken(registrationToken);
     _baseLogger->setSamplingFeatureUUID(samplingFeatureUUID);
     // MS_DBG(F("dataPublisher object created"));
@@ -82,17 +88,23 @@ void EnviroDIYPublisher::setToken(const char *registrationToken)
 // Calculates how long the JSON will be
 uint16_t EnviroDIYPublisher::calculateJsonSize()
 {
-    uint16_t jsonLength = 21;  // {"sampling_feature":"
-    jsonLength += 36;  // sampling feature UUID
-    jsonLength += 15;  // ","timestamp":"
-    jsonLength += 25;  // markedISO8601Time
+    uint16_t jsonLength = strlen(samplingFeatureTag);
+    jsonLength += strlen(_baseLogger->getSamplingFeatureUUID());
+    jsonLength += strlen(timestampTag);
+    // The time is shorter for a logger in UTC (ending in Z)
+    char timeBuffer[ISO8601_TIME_LENGTH + 1];
+    jsonLength += _baseLogger->formatMarkedTime_ISO8601(timeBuffer, sizeof(timeBuffer));
     jsonLength += 2;  //  ",
+    // If the values have already been formatted, their length is known
+    bool haveRecord = _baseLogger->isRecordCurrent();
+    if (haveRecord) jsonLength += _baseLogger->getRecordValuesLength();
+    char valueBuffer[VALUE_STRING_BUFFER_SIZE];
     for (uint8_t i = 0; i < _baseLogger->getArrayVarCount(); i++)
     {
         jsonLength += 1;  //  "
-        jsonLength += 36;  // variable UUID
+        jsonLength += _baseLogger->getVarUUIDAtI(i).length();
         jsonLength += 2;  //  ":
-        jsonLength += _baseLogger->getValueStringAtI(i).length();
+        if (!haveRecord) jsonLength += _baseLogger->formatValueAtI(i, valueBuffer);
         if (i + 1 != _baseLogger->getArrayVarCount())
         {
             jsonLength += 1;  // ,
@@ -104,6 +116,43 @@ uint16_t EnviroDIYPublisher::calculateJsonSize()
 }
 
 
+// Calculates how long the JSON for the whole batch will be
+// Everything in the batch is already formatted, so this is one pass through it
+uint16_t EnviroDIYPublisher::calculateBatchJsonSize()
+{
+    uint8_t nVars = _baseLogger->getArrayVarCount();
+    uint16_t jsonLength = strlen(samplingFeatureTag);
+    jsonLength += strlen(_baseLogger->getSamplingFeatureUUID());
+    jsonLength += strlen(timestampArrayTag);
+
+    char timeBuffer[ISO8601_TIME_LENGTH + 1];
+    uint16_t pos = 0;
+    for (uint8_t r = 0; r < _batchCount; r++)
+    {
+        jsonLength += 2;  // "time"
+        jsonLength += Logger::formatDateTime_ISO8601(getBatchRecordTime(pos),
+                                                     timeBuffer, sizeof(timeBuffer));
+        // The values are everything after the time, less their terminators
+        jsonLength += getBatchRecordLength(pos) - 4 - nVars;
+        pos += 2 + getBatchRecordLength(pos);
+    }
+    // The commas between the times and between the values for each variable
+    if (_batchCount > 1) jsonLength += (_batchCount - 1)*(1 + nVars);
+    jsonLength += 1;  // ]
+
+    for (uint8_t i = 0; i < nVars; i++)
+    {
+        jsonLength += 2;  // ,"
+        jsonLength += _baseLogger->getVarUUIDAtI(i).length();
+        jsonLength += 3;  // ":[
+        jsonLength += 1;  // ]
+    }
+    jsonLength += 1;  // }
+
+    return jsonLength;
+}
+
+
 /*
 // Calculates how long the full post request will be, including headers
 uint16_t EnviroDIYPublisher::calculatePostSize()
@@ -129,15 +178,19 @@ void EnviroDIYPublisher::printSensorDataJSON(Stream *stream)
     stream->print(samplingFeatureTag);
     stream->print(_baseLogger->getSamplingFeatureUUID());
     stream->print(timestampTag);
-    stream->print(_baseLogger->formatDateTime_ISO8601(Logger::markedEpochTime));
+    char timeBuffer[ISO8601_TIME_LENGTH + 1];
+    _baseLogger->formatMarkedTime_ISO8601(timeBuffer, sizeof(timeBuffer));
+    stream->print(timeBuffer);
     stream->print(F("\","));
 
+    char valueBuffer[VALUE_STRING_BUFFER_SIZE];
     for (uint8_t i = 0; i < _baseLogger->getArrayVarCount(); i++)
     {
         stream->print('"');
         stream->print(_baseLogger->getVarUUIDAtI(i));
         stream->print(F("\":"));
-        stream->print(_baseLogger->getValueStringAtI(i));
+        _baseLogger->formatValueAtI(i, valueBuffer);
+        stream->print(valueBuffer);
         if (i + 1 != _baseLogger->getArrayVarCount())
         {
             stream->print(',');
@@ -194,14 +247,260 @@ void EnviroDIYPublisher::begin(Logger& baseLogger,
 // EnviroDIY/ODM2DataSharingPortal and then streams out a post request
 // over that connection.
 // The return is the http status code of the response.
+// When batching, the current record is added to the batch and the whole
+// batch is sent.  If the batch is already full, it is sent on its own and the
+// current record is kept in the emptied batch for the next time.
 // int16_t EnviroDIYPublisher::postDataEnviroDIY(void)
 int16_t EnviroDIYPublisher::publishData(Client *_outClient)
+{
+    if (isBatching())
+    {
+        if (addRecordToBatch()) return publishBatch(_outClient);
+        if (_batchCount > 0)
+        {
+            // The batch is full, so send it first to make room
+            int16_t responseCode = publishBatch(_outClient);
+            // Don't try again over a connection that just failed; keep
+            // the record for the next time instead
+            if (!wasPublishSuccessful(responseCode))
+            {
+                holdRecord();
+                return responseCode;
+            }
+            // Keep the record in the emptied batch for the next send, rather
+            // than making a second post for it now
+            if (addRecordToBatch()) return responseCode;
+        }
+    }
+    // A record too big for the buffer on its own is sent by itself
+    return postRequest(_outClient, false);
+}
+
+
+// This keeps the current record in the batch to send later
+void EnviroDIYPublisher::holdRecord(void)
+{
+    if (!isBatching())
+    {
+        dataPublisher::holdRecord();
+        return;
+    }
+    // If the batch is full, drop the oldest records to make room
+    bool added = addRecordToBatch();
+    while (!added && _batchCount > 0)
+    {
+        PRINTOUT(F("Batch is full, dropping the oldest record!"));
+        dropOldestBatchRecord();
+        added = addRecordToBatch();
+    }
+    if (added)
+    {
+        MS_DBG(_batchCount, F("records are waiting in the batch"));
+    }
+    else
+    {
+        PRINTOUT(F("The batch buffer is too small for a single record!"));
+    }
+}
+
+
+// This turns on sending several records in each post request
+void EnviroDIYPublisher::setBatchBuffer(uint8_t buffer[], uint16_t bufferSize)
+{
+    _batchBuffer = buffer;
+    _batchBufferSize = buffer != NULL ? bufferSize : 0;
+    _batchLength = 0;
+    _batchCount = 0;
+}
+
+
+// This checks if the publisher is collecting records into a batch
+bool EnviroDIYPublisher::isBatching(void)
+{
+    return _batchBuffer != NULL && _batchBufferSize > 0;
+}
+
+
+// This adds the current record to the batch
+bool EnviroDIYPublisher::addRecordToBatch(void)
+{
+    if (!isBatching() || _batchCount == 255) return false;
+
+    // Leave room for the length of the record before anything else
+    uint16_t start = _batchLength;
+    uint16_t pos = start + 2;
+    if (pos + 4 > _batchBufferSize) return false;
+
+    // The time stamp
+    uint32_t epochTime = Logger::markedEpochTime;
+    for (uint8_t b = 0; b < 4; b++)
+    {
+        _batchBuffer[pos++] = (epochTime >> (8*b)) & 0xFF;
+    }
+
+    // The formatted values, each with its terminator
+    char valueBuffer[VALUE_STRING_BUFFER_SIZE];
+    for (uint8_t i = 0; i < _baseLogger->getArrayVarCount(); i++)
+    {
+        uint8_t len = _baseLogger->formatValueAtI(i, valueBuffer);
+        if (pos + len + 1 > _batchBufferSize) return false;
+        memcpy(&_batchBuffer[pos], valueBuffer, len + 1);
+        pos += len + 1;
+    }
+
+    uint16_t recordLength = pos - start - 2;
+    _batchBuffer[start] = recordLength & 0xFF;
+    _batchBuffer[start + 1] = recordLength >> 8;
+    _batchLength = pos;
+    _batchCount++;
+    return true;
+}
+
+
+// This sends every record in the batch in one post request
+int16_t EnviroDIYPublisher::publishBatch(Client *_outClient)
+{
+    if (_batchCount == 0) return 0;
+    MS_DBG(F("Sending a batch of"), _batchCount, F("records"));
+    int16_t responseCode = postRequest(_outClient, true);
+    // Keep the records to try again if they weren't accepted
+    if (wasPublishSuccessful(responseCode)) clearBatch();
+    return responseCode;
+}
+
+
+// This empties the batch
+void EnviroDIYPublisher::clearBatch(void)
+{
+    _batchLength = 0;
+    _batchCount = 0;
+}
+
+
+// Protected helper function - This removes the oldest record from the batch
+void EnviroDIYPublisher::dropOldestBatchRecord(void)
+{
+    if (_batchCount == 0) return;
+    uint16_t oldestLength = 2 + getBatchRecordLength(0);
+    memmove(_batchBuffer, &_batchBuffer[oldestLength], _batchLength - oldestLength);
+    _batchLength -= oldestLength;
+    _batchCount--;
+}
+
+
+// Protected helper functions - These read a record in the batch
+uint16_t EnviroDIYPublisher::getBatchRecordLength(uint16_t position)
+{
+    return _batchBuffer[position] | (_batchBuffer[position + 1] << 8);
+}
+uint32_t EnviroDIYPublisher::getBatchRecordTime(uint16_t position)
+{
+    uint32_t epochTime = 0;
+    for (uint8_t b = 0; b < 4; b++)
+    {
+        epochTime |= (uint32_t)_batchBuffer[position + 2 + b] << (8*b);
+    }
+    return epochTime;
+}
+const char *EnviroDIYPublisher::getBatchRecordValue(uint16_t position, uint8_t position_i)
+{
+    const char *value = (const char *)&_batchBuffer[position + 6];
+    for (uint8_t i = 0; i < position_i; i++)
+    {
+        value += strlen(value) + 1;
+    }
+    return value;
+}
+
+
+// Protected helper function - This adds the JSON for the current record to
+// the TX buffer
+void EnviroDIYPublisher::appendRecordJSON(void)
+{
+    char tempBuffer[37] = "";
+
+    txBufferAppend(samplingFeatureTag);
+    txBufferAppend(_baseLogger->getSamplingFeatureUUID());
+
+    txBufferAppend(timestampTag);
+    txBufferAppend(tempBuffer, _baseLogger->formatMarkedTime_ISO8601(tempBuffer, 37));
+    txBufferAppend('"');
+    txBufferAppend(',');
+
+    for (uint8_t i = 0; i < _baseLogger->getArrayVarCount(); i++)
+    {
+        txBufferAppend('"');
+        _baseLogger->getVarUUIDAtI(i).toCharArray(tempBuffer, 37);
+        txBufferAppend(tempBuffer);
+        txBufferAppend('"');
+        txBufferAppend(':');
+        txBufferAppend(tempBuffer, _baseLogger->formatValueAtI(i, tempBuffer, 37));
+        if (i + 1 != _baseLogger->getArrayVarCount())
+        {
+            txBufferAppend(',');
+        }
+        else
+        {
+            txBufferAppend('}');
+        }
+    }
+}
+
+
+// Protected helper function - This adds the JSON for the whole batch to the
+// TX buffer, with arrays of the times and of each variable's values
+void EnviroDIYPublisher::appendBatchJSON(void)
+{
+    char tempBuffer[37] = "";
+
+    txBufferAppend(samplingFeatureTag);
+    txBufferAppend(_baseLogger->getSamplingFeatureUUID());
+
+    txBufferAppend(timestampArrayTag);
+    uint16_t pos = 0;
+    for (uint8_t r = 0; r < _batchCount; r++)
+    {
+        if (r > 0) txBufferAppend(',');
+        txBufferAppend('"');
+        txBufferAppend(tempBuffer, Logger::formatDateTime_ISO8601(getBatchRecordTime(pos),
+                                                                  tempBuffer, 37));
+        txBufferAppend('"');
+        pos += 2 + getBatchRecordLength(pos);
+    }
+    txBufferAppend(']');
+
+    for (uint8_t i = 0; i < _baseLogger->getArrayVarCount(); i++)
+    {
+        txBufferAppend(',');
+        txBufferAppend('"');
+        _baseLogger->getVarUUIDAtI(i).toCharArray(tempBuffer, 37);
+        txBufferAppend(tempBuffer);
+        txBufferAppend('"');
+        txBufferAppend(':');
+        txBufferAppend('[');
+        pos = 0;
+        for (uint8_t r = 0; r < _batchCount; r++)
+        {
+            if (r > 0) txBufferAppend(',');
+            txBufferAppend(getBatchRecordValue(pos, i));
+            pos += 2 + getBatchRecordLength(pos);
+        }
+        txBufferAppend(']');
+    }
+    txBufferAppend('}');
+}
+
+
+// Protected helper function - This sends a post request with either the
+// current record or the batch
+int16_t EnviroDIYPublisher::postRequest(Client *_outClient, bool sendBatch)
 {
     // Create a buffer for the portions of the request and response
     char tempBuffer[37] = "";
     uint16_t did_respond = 0;
 
-    MS_DBG(F("Outgoing JSON size:"), calculateJsonSize());
+    uint16_t jsonLength = sendBatch ? calculateBatchJsonSize() : calculateJsonSize();
+    MS_DBG(F("Outgoing JSON size:"), jsonLength);
 
     // Open a TCP/IP connection to the Enviro DIY Data Portal (WebSDL)
     MS_DBG(F("Connecting client"));
@@ -210,74 +509,36 @@ int16_t EnviroDIYPublisher::publishData(Client *_outClient)
     {
         MS_DBG(F("Client connected after"), MS_PRINT_DEBUG_TIMER, F("ms\n"));
 
+        // Start the outgoing buffer, which will be sent out to the client
+        // whenever it fills
+        txBufferInit(_outClient);
+
         // copy the initial post header into the tx buffer
-        strcpy(txBuffer, postHeader);
-        strcat(txBuffer, postEndpoint);
-        strcat(txBuffer, HTTPtag);
+        txBufferAppend(postHeader);
+        txBufferAppend(postEndpoint);
+        txBufferAppend(HTTPtag);
 
         // add the rest of the HTTP POST headers to the outgoing buffer
-        // before adding each line/chunk to the outgoing buffer, we make sure
-        // there is space for that line, sending out buffer if not
-        if (bufferFree() < 28) printTxBuffer(_outClient);
-        strcat(txBuffer, hostHeader);
-        strcat(txBuffer, enviroDIYHost);
-
-        if (bufferFree() < 47) printTxBuffer(_outClient);
-        strcat(txBuffer, tokenHeader);
-        strcat(txBuffer, _registrationToken);
-
-        // if (bufferFree() < 27) printTxBuffer(_outClient);
-        // strcat(txBuffer, cacheHeader);
-
-        // if (bufferFree() < 21) printTxBuffer(_outClient);
-        // strcat(txBuffer, connectionHeader);
-
-        if (bufferFree() < 26) printTxBuffer(_outClient);
-        strcat(txBuffer, contentLengthHeader);
-        itoa(calculateJsonSize(), tempBuffer, 10);  // BASE 10
-        strcat(txBuffer, tempBuffer);
+        txBufferAppend(hostHeader);
+        txBufferAppend(enviroDIYHost);
+        txBufferAppend(tokenHeader);
+        txBufferAppend(_registrationToken);
 
-        if (bufferFree() < 42) printTxBuffer(_outClient);
-        strcat(txBuffer, contentTypeHeader);
+        // txBufferAppend(cacheHeader);
+        // txBufferAppend(connectionHeader);
 
-        // put the start of the JSON into the outgoing response_buffer
-        if (bufferFree() < 21) printTxBuffer(_outClient);
-        strcat(txBuffer, samplingFeatureTag);
+        txBufferAppend(contentLengthHeader);
+        itoa(jsonLength, tempBuffer, 10);  // BASE 10
+        txBufferAppend(tempBuffer);
 
-        if (bufferFree() < 36) printTxBuffer(_outClient);
-        strcat(txBuffer, _baseLogger->getSamplingFeatureUUID());
+        txBufferAppend(contentTypeHeader);
 
-        if (bufferFree() < 42) printTxBuffer(_outClient);
-        strcat(txBuffer, timestampTag);
-        _baseLogger->formatDateTime_ISO8601(Logger::markedEpochTime).toCharArray(tempBuffer, 37);
-        strcat(txBuffer, tempBuffer);
-        txBuffer[strlen(txBuffer)] = '"';
-        txBuffer[strlen(txBuffer)] = ',';
-
-        for (uint8_t i = 0; i < _baseLogger->getArrayVarCount(); i++)
-        {
-            // Once the buffer fills, send it out
-            if (bufferFree() < 47) printTxBuffer(_outClient);
-
-            txBuffer[strlen(txBuffer)] = '"';
-            _baseLogger->getVarUUIDAtI(i).toCharArray(tempBuffer, 37);
-            strcat(txBuffer, tempBuffer);
-            txBuffer[strlen(txBuffer)] = '"';
-            txBuffer[strlen(txBuffer)] = ':';
-            _baseLogger->getValueStringAtI(i).toCharArray(tempBuffer, 37);
-            strcat(txBuffer, tempBuffer);
-            if (i + 1 != _baseLogger->getArrayVarCount())
-            {
-                txBuffer[strlen(txBuffer)] = ',';
-            }
-            else
-            {
-                txBuffer[strlen(txBuffer)] = '}';
-            }
-        }
+        // put the JSON into the outgoing buffer
+        if (sendBatch) appendBatchJSON();
+        else appendRecordJSON();
 
         // Send out the finished request (or the last unsent section of it)
-        printTxBuffer(_outClient, true);
+        txBufferFlush(true);
 
         // Wait 10 seconds for a response from the server
         uint32_t start = millis();
@@ -81,6 +81,27 @@ public:
     // int16_t postDataEnviroDIY(void);
     virtual int16_t publishData(Client *_outClient);
 
+    // This turns on sending several records in each post request, using the
+    // given buffer to hold the records until they're sent.  On the logging
+    // intervals when the publisher isn't due to send (see setSendFrequency()),
+    // the record is added to the batch; when it is due, the current record
+    // and everything in the batch are posted together.  If a post fails, the
+    // records are kept and sent with the next batch; only if the buffer fills
+    // up are the oldest records dropped.
+    // In a batch, the timestamp and each variable are arrays, ie:
+    //   {"sampling_feature":"...","timestamp":["t1","t2"],"uuid1":[v1,v2],...}
+    // Each record takes 6 bytes plus one more than the length of each of its
+    // formatted values.
+    void setBatchBuffer(uint8_t buffer[], uint16_t bufferSize);
+    virtual bool isBatching(void);
+    virtual bool addRecordToBatch(void);
+    virtual uint8_t getBatchCount(void){return _batchCount;}
+    virtual int16_t publishBatch(Client *_outClient);
+    virtual void clearBatch(void);
+    virtual void holdRecord(void);
+    // Calculates how long the JSON for the whole batch will be
+    uint16_t calculateBatchJsonSize();
+
 protected:
 
     // portions of the POST request
@@ -96,10 +117,32 @@ protected:
     // portions of the JSON
     static const char *samplingFeatureTag;
     static const char *timestampTag;
+    static const char *timestampArrayTag;
+
+    // This sends a post request with either the current record or the batch
+    // and returns the http status code of the response
+    int16_t postRequest(Client *_outClient, bool sendBatch);
+    // These add the JSON for the current record or the batch to the TX buffer
+    void appendRecordJSON(void);
+    void appendBatchJSON(void);
+    // This removes the oldest record from the batch
+    void dropOldestBatchRecord(void);
+    // These find a record in the batch and a value within that record
+    uint16_t getBatchRecordLength(uint16_t position);
+    uint32_t getBatchRecordTime(uint16_t position);
+    const char *getBatchRecordValue(uint16_t position, uint8_t position_i);
 
 private:
     // Tokens and UUID's for EnviroDIY
     const char *_registrationToken;
+
+    // The batch of records waiting to be posted
+    // Each record is a 2 byte length, a 4 byte timestamp, and then the
+    // formatted values, each null terminated.
+    uint8_t *_batchBuffer;
+    uint16_t _batchBufferSize;
+    uint16_t _batchLength;
+    uint8_t _batchCount;
 };
 
 #endif  // Header Guard
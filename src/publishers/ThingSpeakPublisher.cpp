@@ -148,27 +148,27 @@ int16_t ThingSpeakPublisher::publishData(Client *_outClient)
     strcat(topicBuffer, _thingSpeakChannelKey);
     MS_DBG(F("Topic ["), strlen(topicBuffer), F("]:"), String(topicBuffer));
 
-    emptyTxBuffer();
+    // The whole message must fit in the buffer to be published, so there is
+    // no client to send it out to when it fills
+    txBufferInit(NULL);
 
-    _baseLogger->formatDateTime_ISO8601(Logger::markedEpochTime).toCharArray(tempBuffer, 26);
-    strcat(txBuffer, "created_at=");
-    strcat(txBuffer, tempBuffer);
-    txBuffer[strlen(txBuffer)] = '&';
+    txBufferAppend("created_at=");
+    txBufferAppend(tempBuffer, _baseLogger->formatMarkedTime_ISO8601(tempBuffer, 26));
+    txBufferAppend('&');
 
     for (uint8_t i = 0; i < numChannels; i++)
     {
-        strcat(txBuffer, "field");
+        txBufferAppend("field");
         itoa(i+1, tempBuffer, 10);  // BASE 10
-        strcat(txBuffer, tempBuffer);
-        txBuffer[strlen(txBuffer)] = '=';
-        _baseLogger->getValueStringAtI(i).toCharArray(tempBuffer, 26);
-        strcat(txBuffer, tempBuffer);
+        txBufferAppend(tempBuffer);
+        txBufferAppend('=');
+        txBufferAppend(tempBuffer, _baseLogger->formatValueAtI(i, tempBuffer, 26));
         if (i + 1 != numChannels)
         {
-            txBuffer[strlen(txBuffer)] = '&';
+            txBufferAppend('&');
         }
     }
-    MS_DBG(F("Message ["), strlen(txBuffer), F("]:"), String(txBuffer));
+    MS_DBG(F("Message ["), txBufferLen, F("]:"), String(txBuffer));
 
     // Set the client connection parameters
     _mqttClient.setClient(*_outClient);
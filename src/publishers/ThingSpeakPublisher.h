@@ -87,6 +87,8 @@ public:
     // This sends the data to ThingSpeak
     // bool mqttThingSpeak(void);
     virtual int16_t publishData(Client *_outClient);
+    // The MQTT publish returns true on success rather than an HTTP code
+    virtual bool wasPublishSuccessful(int16_t result){return result == true;}
 
 protected:
     static const char *mqttServer;
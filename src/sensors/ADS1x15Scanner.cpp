@@ -0,0 +1,156 @@
+/*
+ *ADS1x15Scanner.cpp
+ *This file is part of the EnviroDIY modular sensors library for Arduino
+ *
+ *Initial library developement done by Sara Damiano (sdamiano@stroudcenter.org).
+ *
+ *This file is for sharing a single TI ADS1115 (or ADS1015) analog to digital
+ *converter between all of the analog sensors attached to its channels.
+ *This is dependent on the soligen2010 fork of the Adafruit ADS1015 library.
+*/
+
+#include "ADS1x15Scanner.h"
+
+
+// The first scanner in the list of scanners
+ADS1x15Scanner *ADS1x15Scanner::_firstScanner = NULL;
+
+
+// The constructor
+ADS1x15Scanner::ADS1x15Scanner(uint8_t i2cAddress)
+  : _ads(i2cAddress)
+{
+    _nextScanner = NULL;
+    _i2cAddress = i2cAddress;
+    _begun = false;
+    _channelMask = 0;
+    _dataRateSet = false;
+    _dataRate = RATE_ADS1115_128SPS;
+    _oversample = 1;
+    _haveScan = false;
+    _millisScanned = 0;
+    for (uint8_t i = 0; i < ADS1X15_NUM_CHANNELS; i++) _voltages[i] = -9999;
+}
+
+
+// This finds or adds the scanner for an I2C address
+// NOTE:  This is called from the sensor constructors, so no debugging output!
+ADS1x15Scanner* ADS1x15Scanner::getScanner(uint8_t i2cAddress, ADS1x15Scanner *ownScanner)
+{
+    for (ADS1x15Scanner *scanner = _firstScanner; scanner != NULL; scanner = scanner->_nextScanner)
+    {
+        if (scanner->_i2cAddress == i2cAddress) return scanner;
+    }
+
+    ownScanner->_nextScanner = _firstScanner;
+    _firstScanner = ownScanner;
+    return ownScanner;
+}
+
+
+// This sets the data rate and oversampling for the ADC at an address
+bool ADS1x15Scanner::configure(uint8_t i2cAddress, adsSPS_t dataRate, uint8_t oversample)
+{
+    for (ADS1x15Scanner *scanner = _firstScanner; scanner != NULL; scanner = scanner->_nextScanner)
+    {
+        if (scanner->_i2cAddress == i2cAddress)
+        {
+            scanner->_dataRateSet = true;
+            scanner->_dataRate = dataRate;
+            if (oversample < 1) oversample = 1;
+            if (oversample > ADS1X15_MAX_OVERSAMPLE) oversample = ADS1X15_MAX_OVERSAMPLE;
+            scanner->_oversample = oversample;
+            // Make sure the new settings are used for the next scan
+            scanner->_begun = false;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+// This registers a channel to be read in each scan
+void ADS1x15Scanner::addChannel(uint8_t channel)
+{
+    if (channel < ADS1X15_NUM_CHANNELS) _channelMask |= (1 << channel);
+}
+
+
+// This scans the channels if there isn't already a scan from after the time
+bool ADS1x15Scanner::scanIfOlderThan(uint32_t millisMeasurementRequested)
+{
+    if (_haveScan && (int32_t)(_millisScanned - millisMeasurementRequested) >= 0)
+    {
+        MS_DBG(F("Using ADS1x15 scan from"), millis() - _millisScanned, F("ms ago"));
+        return true;
+    }
+    return scan();
+}
+
+
+// This reads all of the registered channels back to back
+bool ADS1x15Scanner::scan(void)
+{
+    // Only set up the ADC the first time
+    // ADS Library default settings:
+    //  - TI1115 (16 bit)
+    //    - single-shot mode (powers down between conversions)
+    //    - 128 samples per second (8ms conversion time)
+    //    - 2/3 gain +/- 6.144V range (limited to VDD +0.3V max)
+    //  - TI1015 (12 bit)
+    //    - single-shot mode (powers down between conversions)
+    //    - 1600 samples per second (625µs conversion time)
+    //    - 2/3 gain +/- 6.144V range (limited to VDD +0.3V max)
+    // The whole configuration is sent with every single-shot conversion, so
+    // the settings don't need to be re-sent if the ADC loses power.
+    if (!_begun)
+    {
+        // Bump the gain up to 1x = +/- 4.096V range
+        _ads.setGain(GAIN_ONE);
+        if (_dataRateSet) _ads.setSPS(_dataRate);
+        // Begin ADC
+        _ads.begin();
+        _begun = true;
+    }
+
+    // Mark the time before starting, so sensors that started a measurement
+    // during the scan will get a newer one.
+    _millisScanned = millis();
+    MS_DBG(F("Scanning ADS1x15 at 0x"), String(_i2cAddress, HEX),
+           F("with"), _oversample, F("conversions per channel"));
+
+    bool anyGood = false;
+    for (uint8_t channel = 0; channel < ADS1X15_NUM_CHANNELS; channel++)
+    {
+        if (!bitRead(_channelMask, channel)) continue;
+
+        // Read Analog to Digital Converter (ADC)
+        // We're allowing the ADS1115 library to do the bit-to-volts conversion for us
+        float sum = 0;
+        uint8_t nGood = 0;
+        for (uint8_t i = 0; i < _oversample; i++)
+        {
+            float sample = _ads.readADC_SingleEnded_V(channel);
+            // Skip results out of range
+            if (sample < 3.6 and sample > -0.3)
+            {
+                sum += sample;
+                nGood++;
+            }
+        }
+        _voltages[channel] = (nGood > 0) ? sum/nGood : -9999;
+        if (nGood > 0) anyGood = true;
+        MS_DBG(F("  Channel"), channel, ':', _voltages[channel]);
+    }
+
+    _haveScan = true;
+    return anyGood;
+}
+
+
+// This returns the last voltage from a channel
+float ADS1x15Scanner::getVoltage(uint8_t channel)
+{
+    if (!_haveScan || channel >= ADS1X15_NUM_CHANNELS) return -9999;
+    return _voltages[channel];
+}
@@ -0,0 +1,96 @@
+/*
+ *ADS1x15Scanner.h
+ *This file is part of the EnviroDIY modular sensors library for Arduino
+ *
+ *Initial library developement done by Sara Damiano (sdamiano@stroudcenter.org).
+ *
+ *This file is for sharing a single TI ADS1115 (or ADS1015) analog to digital
+ *converter between all of the analog sensors (external voltages, Campbell
+ *OBS3's, Apogee SQ212's) attached to its channels.
+ *This is dependent on the soligen2010 fork of the Adafruit ADS1015 library.
+*/
+
+// Header Guards
+#ifndef ADS1x15Scanner_h
+#define ADS1x15Scanner_h
+
+// Debugging Statement
+// #define MS_ADS1X15SCANNER_DEBUG
+
+#ifdef MS_ADS1X15SCANNER_DEBUG
+#define MS_DEBUGGING_STD "ADS1x15Scanner"
+#endif
+
+// Included Dependencies
+#include "ModSensorDebugger.h"
+#undef MS_DEBUGGING_STD
+#include <Adafruit_ADS1015.h>
+
+// The number of single-ended channels on the ADS1x15
+#define ADS1X15_NUM_CHANNELS 4
+
+// The largest number of conversions to average for each channel in a scan
+#define ADS1X15_MAX_OVERSAMPLE 64
+
+
+// This keeps track of a single ADS1x15 that may be shared by several analog
+// sensors.  Each sensor registers the channel it's on, and when any of them
+// needs a result, all of the registered channels are read in one back-to-back
+// sequence.  The other sensors then use the results from that scan instead of
+// setting up the ADC and converting again, as long as the scan was done after
+// their own measurements were started.
+// All channels are read at 1x gain (+/- 4.096V range).
+// Each analog sensor carries one of these; the first one made for an I2C
+// address is the one used by every sensor on that ADC.
+class ADS1x15Scanner
+{
+public:
+    ADS1x15Scanner(uint8_t i2cAddress);
+
+    // This finds the scanner for an I2C address, adding ownScanner as the
+    // scanner for the address if it's new.  This can't fail.
+    static ADS1x15Scanner* getScanner(uint8_t i2cAddress, ADS1x15Scanner *ownScanner);
+
+    // This sets the data rate and the number of conversions to average for
+    // each channel for the ADC at an I2C address.  The data rate must be one
+    // of the RATE_ADS1115_xxSPS (or RATE_ADS1015_xxxxSPS) values from the
+    // Adafruit library.  Faster rates are noisier but take much less time;
+    // averaging several fast conversions is usually better than one slow one.
+    // Returns false if no sensor is using the ADC at that address.
+    // By default, the library's data rate is used with no averaging.
+    static bool configure(uint8_t i2cAddress, adsSPS_t dataRate, uint8_t oversample = 1);
+
+    // This registers a channel to be read in each scan
+    void addChannel(uint8_t channel);
+
+    // This scans all registered channels, unless there is already a scan
+    // from after the given time.  Returns true if there are results.
+    bool scanIfOlderThan(uint32_t millisMeasurementRequested);
+    // This scans all of the registered channels
+    bool scan(void);
+
+    // This returns the voltage from a channel in the last scan, or -9999
+    float getVoltage(uint8_t channel);
+
+private:
+    static ADS1x15Scanner *_firstScanner;
+    ADS1x15Scanner *_nextScanner;
+
+    #ifndef MS_USE_ADS1015
+    Adafruit_ADS1115 _ads;  // Use this for the 16-bit version
+    #else
+    Adafruit_ADS1015 _ads;  // Use this for the 12-bit version
+    #endif
+    uint8_t _i2cAddress;
+    bool _begun;
+    uint8_t _channelMask;
+    bool _dataRateSet;
+    adsSPS_t _dataRate;
+    uint8_t _oversample;
+
+    bool _haveScan;
+    uint32_t _millisScanned;
+    float _voltages[ADS1X15_NUM_CHANNELS];
+};
+
+#endif  // Header Guard
@@ -45,6 +45,7 @@
 #undef MS_DEBUGGING_STD
 #include "VariableBase.h"
 #include "SensorBase.h"
+#include "ADS1x15Scanner.h"
 
 // Sensor Specific Defines
 #define ADS1115_ADDRESS 0x48
@@ -89,6 +90,9 @@ public:
 protected:
     uint8_t _adsChannel;
     uint8_t _i2cAddress;
+    // The ADC this sensor is attached to, which may be shared with other sensors
+    ADS1x15Scanner _ownScanner;
+    ADS1x15Scanner *_scanner;
 
 };
 
@@ -86,11 +86,16 @@ bool BoschBME280::setup(void)
 }
 
 
-bool BoschBME280::wake(void)
+// This is split into two parts so other sensors can be handled during the
+// delay needed after changing the sampling mode.
+sensorStepState BoschBME280::wakeStep(void)
 {
-    // Sensor::wake() checks if the power pin is on and sets the wake timestamp
-    // and status bits.  If it returns false, there's no reason to go on.
-    if (!Sensor::wake()) return false;
+    // After the delay, Sensor::wake() sets the wake timestamp and status bits.
+    if (_stepPhase > 0) return finishStep(Sensor::wake());
+
+    // If the sensor doesn't have power, let Sensor::wake() set the status
+    // bits for the failed attempt.  There's no reason to go on.
+    if (!bitRead(_sensorStatus, 2)) return finishStep(Sensor::wake());
 
     // Restart always needed after power-up to set sampling modes
     // As of Adafruit library version 1.0.7, this function includes all of the
@@ -117,9 +122,14 @@ bool BoschBME280::wake(void)
                              Adafruit_BME280::SAMPLING_X16,  //  humidity oversampling
                              Adafruit_BME280::FILTER_OFF, // built-in IIR filter
                              Adafruit_BME280::STANDBY_MS_1000);  // sleep time between measurements (N/A in forced mode)
-    delay(100);  // Need this delay after changing sampling mode
 
-    return true;
+    // Need this delay after changing sampling mode
+    _stepPhase = 1;
+    return retryStepAt(millis() + 100);
+}
+bool BoschBME280::wake(void)
+{
+    return runStepToCompletion(&Sensor::wakeStep);
 }
 
 
@@ -77,6 +77,7 @@ public:
     ~BoschBME280();
 
     bool wake(void) override;
+    sensorStepState wakeStep(void) override;
     bool setup(void) override;
     String getSensorLocation(void) override;
 
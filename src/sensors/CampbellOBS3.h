@@ -41,6 +41,7 @@
 #undef MS_DEBUGGING_STD
 #include "VariableBase.h"
 #include "SensorBase.h"
+#include "ADS1x15Scanner.h"
 
 // Sensor Specific Defines
 #define ADS1115_ADDRESS 0x48
@@ -88,6 +89,9 @@ protected:
     uint8_t _adsChannel;
     float _x2_coeff_A, _x1_coeff_B, _x0_coeff_C;
     uint8_t _i2cAddress;
+    // The ADC this sensor is attached to, which may be shared with other sensors
+    ADS1x15Scanner _ownScanner;
+    ADS1x15Scanner *_scanner;
 };
 
 
@@ -84,7 +84,7 @@ public:
     // Destructor
     ~Decagon5TM(){}
 
-    virtual bool addSingleMeasurementResult(void) override;
+    virtual sensorStepState addResultStep(void) override;
 };
 
 
@@ -52,7 +52,6 @@
 
 
 #include "ExternalVoltage.h"
-#include <Adafruit_ADS1015.h>
 
 
 // The constructor - need the power pin the data pin, and gain if non standard
@@ -60,11 +59,15 @@ ExternalVoltage::ExternalVoltage(int8_t powerPin, uint8_t adsChannel, float gain
                                  uint8_t i2cAddress, uint8_t measurementsToAverage)
     : Sensor("ExternalVoltage", EXT_VOLT_NUM_VARIABLES,
              EXT_VOLT_WARM_UP_TIME_MS, EXT_VOLT_STABILIZATION_TIME_MS, EXT_VOLT_MEASUREMENT_TIME_MS,
-             powerPin, -1, measurementsToAverage)
+             powerPin, -1, measurementsToAverage),
+      _ownScanner(i2cAddress)
 {
     _adsChannel = adsChannel;
     _gain = gain;
     _i2cAddress = i2cAddress;
+    // Find the scanner for the ADC and add this channel to its scans
+    _scanner = ADS1x15Scanner::getScanner(i2cAddress, &_ownScanner);
+    _scanner->addChannel(adsChannel);
 }
 // Destructor
 ExternalVoltage::~ExternalVoltage(){}
@@ -96,34 +99,12 @@ bool ExternalVoltage::addSingleMeasurementResult(void)
     {
         MS_DBG(getSensorNameAndLocation(), F("is reporting:"));
 
-        // Create an Auxillary ADD object
-        // We create and set up the ADC object here so that each sensor using
-        // the ADC may set the gain appropriately without effecting others.
-        #ifndef MS_USE_ADS1015
-        Adafruit_ADS1115 ads(_i2cAddress);  // Use this for the 16-bit version
-        #else
-        Adafruit_ADS1015 ads(_i2cAddress);  // Use this for the 12-bit version
-        #endif
-        // ADS Library default settings:
-        //  - TI1115 (16 bit)
-        //    - single-shot mode (powers down between conversions)
-        //    - 128 samples per second (8ms conversion time)
-        //    - 2/3 gain +/- 6.144V range (limited to VDD +0.3V max)
-        //  - TI1015 (12 bit)
-        //    - single-shot mode (powers down between conversions)
-        //    - 1600 samples per second (625µs conversion time)
-        //    - 2/3 gain +/- 6.144V range (limited to VDD +0.3V max)
-
-        // Bump the gain up to 1x = +/- 4.096V range
-        ads.setGain(GAIN_ONE);
-        // Begin ADC
-        ads.begin();
-
-        // Read Analog to Digital Converter (ADC)
-        // Taking this reading includes the 8ms conversion delay.
-        // We're allowing the ADS1115 library to do the bit-to-volts conversion for us
-        adcVoltage = ads.readADC_SingleEnded_V(_adsChannel);  // Getting the reading
-        MS_DBG(F("  ads.readADC_SingleEnded_V("), _adsChannel, F("):"), adcVoltage);
+        // Get the voltage on this channel from a scan of all of the channels
+        // in use on the ADC.  The channels are only scanned again if there
+        // hasn't been a scan since this measurement was started.
+        _scanner->scanIfOlderThan(_millisMeasurementRequested);
+        adcVoltage = _scanner->getVoltage(_adsChannel);
+        MS_DBG(F("  Channel"), _adsChannel, F("voltage:"), adcVoltage);
 
         if (adcVoltage < 3.6 and adcVoltage > -0.3)  // Skip results out of range
         {
@@ -66,6 +66,7 @@
 #undef MS_DEBUGGING_STD
 #include "VariableBase.h"
 #include "SensorBase.h"
+#include "ADS1x15Scanner.h"
 
 // Sensor Specific Defines
 #define ADS1115_ADDRESS 0x48
@@ -106,6 +107,9 @@ protected:
     uint8_t _adsChannel;
     float _gain;
     uint8_t _i2cAddress;
+    // The ADC this sensor is attached to, which may be shared with other sensors
+    ADS1x15Scanner _ownScanner;
+    ADS1x15Scanner *_scanner;
 };
 
 
@@ -31,6 +31,8 @@ KellerParent::KellerParent(byte modbusAddress, Stream* stream,
     _stream = stream;
     _RS485EnablePin = enablePin;
     _powerPin2 = powerPin2;
+    _bus = ModbusBus::getBus(_stream, _powerPin2, &_ownBus);
+    _adapterPowered = false;
 }
 KellerParent::KellerParent(byte modbusAddress, Stream& stream,
                int8_t powerPin, int8_t powerPin2, int8_t enablePin, uint8_t measurementsToAverage,
@@ -45,6 +47,8 @@ KellerParent::KellerParent(byte modbusAddress, Stream& stream,
     _stream = &stream;
     _RS485EnablePin = enablePin;
     _powerPin2 = powerPin2;
+    _bus = ModbusBus::getBus(_stream, _powerPin2, &_ownBus);
+    _adapterPowered = false;
 }
 // Destructor
 KellerParent::~KellerParent(){}
@@ -89,13 +93,15 @@ void KellerParent::powerUp(void)
         // Mark the time that the sensor was powered
         _millisPowerOn = millis();
     }
-    if (_powerPin2 >= 0)
+    // The secondary power pin is for the RS-485 adapter, which is shared by
+    // all of the sensors on the stream.  It stays on until the last one is
+    // powered down.
+    if (!_adapterPowered)
     {
-        MS_DBG(F("Applying secondary power to"), getSensorNameAndLocation(),
-               F("with pin"), _powerPin2);
-        digitalWrite(_powerPin2, HIGH);
+        _bus->addPoweredUser();
+        _adapterPowered = true;
     }
-    if (_powerPin < 0 && _powerPin2 < 0)
+    if (_powerPin < 0 && _bus->getAdapterPowerPin() < 0)
     {
         MS_DBG(F("Power to"), getSensorNameAndLocation(),
                F("is not controlled by this library."));
@@ -122,14 +128,16 @@ void KellerParent::powerDown(void)
         // Unset the status bits for sensor power (bits 1 & 2),
         // activation (bits 3 & 4), and measurement request (bits 5 & 6)
         _sensorStatus &= 0b10000001;
+        // Abandon any step that was in progress
+        finishStep(false);
     }
-    if (_powerPin2 >= 0)
+    // Only turn off the RS-485 adapter if no other sensors on the stream need it
+    if (_adapterPowered)
     {
-        MS_DBG(F("Turning off secondary power to"), getSensorNameAndLocation(),
-               F("with pin"), _powerPin2);
-        digitalWrite(_powerPin2, LOW);
+        _bus->removePoweredUser();
+        _adapterPowered = false;
     }
-    if (_powerPin < 0 && _powerPin2 < 0)
+    if (_powerPin < 0 && _bus->getAdapterPowerPin() < 0)
     {
         MS_DBG(F("Power to"), getSensorNameAndLocation(),
                F("is not controlled by this library."));
@@ -138,10 +146,17 @@ void KellerParent::powerDown(void)
 }
 
 
-bool KellerParent::addSingleMeasurementResult(void)
+// This waits for its turn on the bus and then gets the results
+sensorStepState KellerParent::addResultStep(void)
 {
     bool success = false;
 
+    // Wait for our turn on the bus, if we need it
+    if (bitRead(_sensorStatus, 6) && !_bus->claim(this))
+    {
+        return retryStepAt(_bus->getReadyTime());
+    }
+
     // Initialize float variables
     float waterPressureBar = -9999;
     float waterTempertureC = -9999;
@@ -185,6 +200,13 @@ bool KellerParent::addSingleMeasurementResult(void)
     // Unset the status bits for a measurement request (bits 5 & 6)
     _sensorStatus &= 0b10011111;
 
+    // Let the next sensor have the bus
+    _bus->release(this);
+
     // Return true when finished
-    return success;
+    return finishStep(success);
+}
+bool KellerParent::addSingleMeasurementResult(void)
+{
+    return runStepToCompletion(&Sensor::addResultStep);
 }
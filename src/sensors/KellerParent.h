@@ -36,6 +36,7 @@
 #undef MS_DEBUGGING_STD
 #undef MS_DEBUGGING_DEEP
 #include "SensorBase.h"
+#include "ModbusBus.h"
 #include <KellerModbus.h>
 
 // Sensor Specific Defines
@@ -67,6 +68,8 @@ public:
     virtual void powerDown(void) override;
 
     virtual bool addSingleMeasurementResult(void);
+    // This waits its turn for the bus before getting the results
+    virtual sensorStepState addResultStep(void) override;
 
 private:
     keller sensor;
@@ -75,6 +78,11 @@ private:
     Stream* _stream;
     int8_t _RS485EnablePin;
     int8_t _powerPin2;
+    // The RS-485 bus this sensor is on.  The sensor's own bus object is only
+    // used if it's the first sensor on the stream.
+    ModbusBus _ownBus;
+    ModbusBus *_bus;
+    bool _adapterPowered;
 };
 
 #endif  // Header Guard
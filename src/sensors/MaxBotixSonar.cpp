@@ -21,6 +21,7 @@ MaxBotixSonar::MaxBotixSonar(Stream* stream, int8_t powerPin, int8_t triggerPin,
 {
     _triggerPin = triggerPin;
     _stream = stream;
+    _millisTriggered = 0;
 }
 MaxBotixSonar::MaxBotixSonar(Stream& stream, int8_t powerPin, int8_t triggerPin, uint8_t measurementsToAverage)
     : Sensor("MaxBotixMaxSonar", HRXL_NUM_VARIABLES,
@@ -29,6 +30,7 @@ MaxBotixSonar::MaxBotixSonar(Stream& stream, int8_t powerPin, int8_t triggerPin,
 {
     _triggerPin = triggerPin;
     _stream = &stream;
+    _millisTriggered = 0;
 }
 // Destructor
 MaxBotixSonar::~MaxBotixSonar(){}
@@ -110,45 +112,50 @@ bool MaxBotixSonar::wake(void)
 }
 
 
-bool MaxBotixSonar::addSingleMeasurementResult(void)
+// This makes a single range attempt on each call.  Instead of letting the
+// stream timeout be the "wait" for the measurement, the step is marked as
+// pending until a full reading is in the buffer, so other sensors can be
+// handled while the sonar pings.
+sensorStepState MaxBotixSonar::addResultStep(void)
 {
     // Initialize values
     bool success = false;
-    uint8_t rangeAttempts = 0;
     int16_t result = -9999;
 
-    // Clear anything out of the stream buffer
-    uint8_t junkChars = _stream->available();
-    if (junkChars)
+    // Before the first attempt, clear anything out of the stream buffer
+    if (_stepAttempts == 0 && _stepPhase == 0)
     {
-        MS_DBG(F("Dumping"), junkChars, F("characters from MaxBotix stream buffer:"));
-        for (uint8_t i = 0; i < junkChars; i++)
+        uint8_t junkChars = _stream->available();
+        if (junkChars)
         {
+            MS_DBG(F("Dumping"), junkChars, F("characters from MaxBotix stream buffer:"));
+            for (uint8_t i = 0; i < junkChars; i++)
+            {
+                #ifdef MS_MAXBOTIXSONAR_DEBUG
+                DEBUGGING_SERIAL_OUTPUT.print(_stream->read());
+                #else
+                _stream->read();
+                #endif
+            }
             #ifdef MS_MAXBOTIXSONAR_DEBUG
-            DEBUGGING_SERIAL_OUTPUT.print(_stream->read());
-            #else
-            _stream->read();
+            DEBUGGING_SERIAL_OUTPUT.println();
             #endif
         }
-        #ifdef MS_MAXBOTIXSONAR_DEBUG
-        DEBUGGING_SERIAL_OUTPUT.println();
-        #endif
     }
 
     // Check a measurement was *successfully* started (status bit 6 set)
     // Only go on to get a result if it was
     if (bitRead(_sensorStatus, 6))
     {
-        MS_DBG(getSensorNameAndLocation(), F("is reporting:"));
-
-        while (success == false && rangeAttempts < 25)
+        if (_stepPhase == 0)
         {
-             // If the sonar is running on a trigger, activating the trigger
-             // should in theory happen within the startSingleMeasurement
-             // function.  Because we're really taking up to 25 measurements
-             // for each "single measurement" until a valid value is returned
-             // and the measurement time is <166ms, we'll actually activate
-             // the trigger here.
+            if (_stepAttempts == 0) {MS_DBG(getSensorNameAndLocation(), F("is reporting:"));}
+            // If the sonar is running on a trigger, activating the trigger
+            // should in theory happen within the startSingleMeasurement
+            // function.  Because we're really taking up to 25 measurements
+            // for each "single measurement" until a valid value is returned
+            // and the measurement time is <166ms, we'll actually activate
+            // the trigger here.
             if (_triggerPin >= 0)
             {
                 MS_DBG(F("  Triggering Sonar with"), _triggerPin);
@@ -156,32 +163,52 @@ bool MaxBotixSonar::addSingleMeasurementResult(void)
                 delayMicroseconds(30);  // Trigger must be held high for >20 µs
                 digitalWrite(_triggerPin, LOW);
             }
+            _millisTriggered = millis();
+            _stepPhase = 1;
+        }
 
-            // Immediately ask for a result and let the stream timeout be our
-            // "wait" for the measurement.
+        // Wait until a full reading is in the buffer or the sonar should
+        // certainly have answered by now
+        if (_stream->available() < HRXL_READING_LENGTH &&
+            millis() - _millisTriggered < HRXL_RANGE_TIMEOUT_MS)
+        {
+            return retryStepAt(millis() + HRXL_POLL_INTERVAL_MS);
+        }
+
+        // Only parse if something came back, otherwise parseInt() will wait
+        // out the stream timeout and return 0 anyway
+        if (_stream->available())
+        {
             result = _stream->parseInt();
             _stream->read();  // To throw away the carriage return
-            MS_DBG(F("  Sonar Range:"), result);
-            rangeAttempts++;
-
-            // If it cannot obtain a result , the sonar is supposed to send a value
-            // just above it's max range.  For 10m models, this is 9999, for 5m models
-            // it's 4999.  The sonar might also send readings of 300 or 500 (the
-            // blanking distance) if there are too many acoustic echos.
-            // If the result becomes garbled or the sonar is disconnected, the
-            // parseInt function returns 0.  Luckily, these sensors are not
-            // capable of reading 0, so we also know the 0 value is bad.
-            if (result <= 300 || result == 500 || result == 4999 || result == 9999 || result == 0)
-            {
-                MS_DBG(F("  Bad or Suspicious Result, Retry Attempt #"), rangeAttempts);
-                result = -9999;
-            }
-            else
+        }
+        else result = 0;
+        MS_DBG(F("  Sonar Range:"), result);
+        _stepAttempts++;
+
+        // If it cannot obtain a result , the sonar is supposed to send a value
+        // just above it's max range.  For 10m models, this is 9999, for 5m models
+        // it's 4999.  The sonar might also send readings of 300 or 500 (the
+        // blanking distance) if there are too many acoustic echos.
+        // If the result becomes garbled or the sonar is disconnected, the
+        // parseInt function returns 0.  Luckily, these sensors are not
+        // capable of reading 0, so we also know the 0 value is bad.
+        if (result <= 300 || result == 500 || result == 4999 || result == 9999 || result == 0)
+        {
+            MS_DBG(F("  Bad or Suspicious Result, Retry Attempt #"), _stepAttempts);
+            result = -9999;
+            // Try again, up to 25 times
+            if (_stepAttempts < 25)
             {
-                MS_DBG(F("  Good result found"));
-                success = true;
+                _stepPhase = 0;
+                return retryStepAt(millis());
             }
         }
+        else
+        {
+            MS_DBG(F("  Good result found"));
+            success = true;
+        }
     }
     else
     {
@@ -196,5 +223,9 @@ bool MaxBotixSonar::addSingleMeasurementResult(void)
     _sensorStatus &= 0b10011111;
 
     // Return values shows if we got a not-obviously-bad reading
-    return success;
+    return finishStep(success);
+}
+bool MaxBotixSonar::addSingleMeasurementResult(void)
+{
+    return runStepToCompletion(&Sensor::addResultStep);
 }
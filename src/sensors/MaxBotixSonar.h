@@ -38,6 +38,12 @@
 #define HRXL_RESOLUTION 0
 #define HRXL_VAR_NUM 0
 
+// Each reading is sent as "R####<CR>"
+#define HRXL_READING_LENGTH 6
+// The longest to wait for a reading after a trigger, and how often to check
+#define HRXL_RANGE_TIMEOUT_MS 180
+#define HRXL_POLL_INTERVAL_MS 10
+
 // The main class for the MaxBotix Sonar
 class MaxBotixSonar : public Sensor
 {
@@ -52,10 +58,12 @@ public:
     bool wake(void) override;
 
     bool addSingleMeasurementResult(void) override;
+    sensorStepState addResultStep(void) override;
 
 private:
     int8_t _triggerPin;
     Stream* _stream;
+    uint32_t _millisTriggered;
 };
 
 
@@ -89,7 +89,7 @@ public:
     // Destructor
     ~MeterTeros11(){}
 
-    virtual bool addSingleMeasurementResult(void) override;
+    virtual sensorStepState addResultStep(void) override;
 };
 
 
@@ -0,0 +1,119 @@
+/*
+ *ModbusBus.cpp
+ *This file is part of the EnviroDIY modular sensors library for Arduino
+ *
+ *Initial library developement done by Sara Damiano (sdamiano@stroudcenter.org).
+ *
+ *This file is for sharing a single RS-485 stream and its adapter between
+ *all of the Modbus sensors (Yosemitech and Keller) attached to it.
+*/
+
+#include "ModbusBus.h"
+
+
+// The first bus in the list of buses
+ModbusBus *ModbusBus::_firstBus = NULL;
+
+
+// The constructor
+ModbusBus::ModbusBus()
+{
+    _nextBus = NULL;
+    _stream = NULL;
+    _adapterPowerPin = -1;
+    _poweredUsers = 0;
+    _claimant = NULL;
+    _millisClaimed = 0;
+    _millisReleased = 0;
+}
+
+
+// This finds or adds the bus for a stream
+// NOTE:  This is called from the sensor constructors, so no debugging output!
+ModbusBus* ModbusBus::getBus(Stream *stream, int8_t adapterPowerPin, ModbusBus *ownBus)
+{
+    for (ModbusBus *bus = _firstBus; bus != NULL; bus = bus->_nextBus)
+    {
+        if (bus->_stream == stream)
+        {
+            // If the first sensor on the stream didn't have an adapter power
+            // pin, use this one's
+            if (bus->_adapterPowerPin < 0) bus->_adapterPowerPin = adapterPowerPin;
+            return bus;
+        }
+    }
+
+    ownBus->_stream = stream;
+    ownBus->_adapterPowerPin = adapterPowerPin;
+    ownBus->_nextBus = _firstBus;
+    _firstBus = ownBus;
+    return ownBus;
+}
+
+
+// This adds a sensor to those needing the adapter power
+void ModbusBus::addPoweredUser(void)
+{
+    if (_poweredUsers == 0 && _adapterPowerPin >= 0)
+    {
+        MS_DBG(F("Powering RS-485 adapter with pin"), _adapterPowerPin);
+        digitalWrite(_adapterPowerPin, HIGH);
+    }
+    _poweredUsers++;
+}
+
+
+// This removes a sensor from those needing the adapter power
+void ModbusBus::removePoweredUser(void)
+{
+    if (_poweredUsers > 0) _poweredUsers--;
+    if (_poweredUsers == 0 && _adapterPowerPin >= 0)
+    {
+        MS_DBG(F("Turning off RS-485 adapter power with pin"), _adapterPowerPin);
+        digitalWrite(_adapterPowerPin, LOW);
+    }
+}
+
+
+// This claims the bus for a transaction
+bool ModbusBus::claim(const void *claimant)
+{
+    // If someone else has the bus and hasn't been on it too long, wait
+    if (_claimant != NULL && _claimant != claimant &&
+        millis() - _millisClaimed < MODBUS_CLAIM_TIMEOUT_MS)
+    {
+        return false;
+    }
+    // Wait for the line to be quiet after the last transaction
+    if (_claimant != claimant && millis() - _millisReleased < MODBUS_FRAME_GAP_MS)
+    {
+        return false;
+    }
+    if (_claimant != claimant) _millisClaimed = millis();
+    _claimant = claimant;
+    return true;
+}
+
+
+// This releases a claim on the bus and marks the end of the transaction
+void ModbusBus::release(const void *claimant)
+{
+    if (_claimant != claimant) return;
+    _claimant = NULL;
+    _millisReleased = millis();
+}
+
+
+// This returns the soonest time the bus might be free
+uint32_t ModbusBus::getReadyTime(void)
+{
+    uint32_t readyTime = _millisReleased + MODBUS_FRAME_GAP_MS + 1;
+    if (_claimant != NULL)
+    {
+        // We don't know how long the current transaction will take, so just
+        // check back after the frame gap
+        readyTime = millis() + MODBUS_FRAME_GAP_MS;
+    }
+    if ((int32_t)(readyTime - millis()) < 0) readyTime = millis();
+    return readyTime;
+}
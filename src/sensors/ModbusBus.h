@@ -0,0 +1,88 @@
+/*
+ *ModbusBus.h
+ *This file is part of the EnviroDIY modular sensors library for Arduino
+ *
+ *Initial library developement done by Sara Damiano (sdamiano@stroudcenter.org).
+ *
+ *This file is for sharing a single RS-485 stream and its adapter between
+ *all of the Modbus sensors (Yosemitech and Keller) attached to it.
+*/
+
+// Header Guards
+#ifndef ModbusBus_h
+#define ModbusBus_h
+
+// Debugging Statement
+// #define MS_MODBUSBUS_DEBUG
+
+#ifdef MS_MODBUSBUS_DEBUG
+#define MS_DEBUGGING_STD "ModbusBus"
+#endif
+
+// Included Dependencies
+#include "ModSensorDebugger.h"
+#undef MS_DEBUGGING_STD
+#include <Arduino.h>
+
+// The silent time (in ms) needed between the end of one Modbus transaction
+// and the start of the next.  The Modbus RTU standard requires 3.5 character
+// times; this is a little more than that at 9600 baud.
+#ifndef MODBUS_FRAME_GAP_MS
+#define MODBUS_FRAME_GAP_MS 5
+#endif
+
+// The longest a single sensor can hold the bus before another sensor is
+// allowed to take it over
+#ifndef MODBUS_CLAIM_TIMEOUT_MS
+#define MODBUS_CLAIM_TIMEOUT_MS 2000
+#endif
+
+
+// This keeps track of a single RS-485 stream that may be shared by several
+// Modbus sensors.  The adapter power pin (the "secondary" power pin of the
+// Modbus sensors) is turned on when the first sensor on the stream is powered
+// and is left on until the last sensor on the stream is powered down, so the
+// adapter isn't cycled for each sensor.  Only one sensor at a time can hold
+// the bus for a transaction, and the next transaction can't start until the
+// line has been quiet for the frame gap.
+// Each Modbus sensor carries one of these; the first one made for a stream
+// is the one used by every sensor on that stream.
+class ModbusBus
+{
+public:
+    ModbusBus();
+
+    // This finds the bus for a stream, adding ownBus as the bus for the
+    // stream if it's new.  This can't fail.
+    static ModbusBus* getBus(Stream *stream, int8_t adapterPowerPin, ModbusBus *ownBus);
+
+    Stream* getStream(void){return _stream;}
+    int8_t getAdapterPowerPin(void){return _adapterPowerPin;}
+
+    // These add and remove a sensor from those needing the adapter power.
+    // The adapter is powered for the first sensor and un-powered after the last.
+    void addPoweredUser(void);
+    void removePoweredUser(void);
+    bool isAdapterPowered(void){return _poweredUsers > 0;}
+
+    // These claim and release the bus for a transaction.  If another sensor
+    // has the bus, or the line hasn't been quiet long enough since the last
+    // transaction, claim() returns false and getReadyTime() gives the time
+    // to try again.
+    bool claim(const void *claimant);
+    void release(const void *claimant);
+    uint32_t getReadyTime(void);
+
+private:
+    static ModbusBus *_firstBus;
+    ModbusBus *_nextBus;
+
+    Stream *_stream;
+    int8_t _adapterPowerPin;
+    uint8_t _poweredUsers;
+    const void *_claimant;
+    uint32_t _millisClaimed;
+    uint32_t _millisReleased;
+};
+
+#endif  // Header Guard
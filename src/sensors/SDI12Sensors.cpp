@@ -14,6 +14,83 @@
 #include "SDI12Sensors.h"
 
 
+// The list of SDI-12 buses
+SDI12Bus SDI12Bus::_buses[MAX_NUMBER_SDI12_BUSES];
+uint8_t SDI12Bus::_busCount = 0;
+
+// This finds or adds the bus for a data pin
+// NOTE:  This is called from the sensor constructors, so no debugging output!
+SDI12Bus* SDI12Bus::getBus(int8_t dataPin, SDI12 *sdi12Object)
+{
+    for (uint8_t i = 0; i < _busCount; i++)
+    {
+        if (_buses[i]._dataPin == dataPin) return &_buses[i];
+    }
+    if (_busCount >= MAX_NUMBER_SDI12_BUSES) return NULL;
+
+    SDI12Bus *newBus = &_buses[_busCount++];
+    newBus->_dataPin = dataPin;
+    newBus->_sdi12 = sdi12Object;
+    newBus->_activeUsers = 0;
+    newBus->_claimant = NULL;
+    newBus->_millisClaimed = 0;
+    newBus->_claimHoldTime_ms = SDI12_BUS_CLAIM_TIMEOUT_MS;
+    return newBus;
+}
+
+
+// This adds a sensor to those using the bus, activating it if needed
+void SDI12Bus::addUser(void)
+{
+    // Use begin() instead of just setActive() to ensure timer is set correctly.
+    if (_activeUsers == 0 || !_sdi12->isActive()) _sdi12->begin();
+    _activeUsers++;
+}
+
+
+// This removes a sensor from those using the bus, de-activating it if no one
+// else is using it
+void SDI12Bus::removeUser(void)
+{
+    if (_activeUsers > 0) _activeUsers--;
+    if (_activeUsers == 0)
+    {
+        // Empty the buffer
+        _sdi12->clearBuffer();
+        // Use end() instead of just forceHold to un-set the timers
+        _sdi12->end();
+        _claimant = NULL;
+    }
+}
+
+
+// This claims the bus for a single command and response
+bool SDI12Bus::claim(const void *claimant, uint32_t holdTime_ms)
+{
+    // If someone else has the bus and hasn't been on it too long, wait
+    if (_claimant != NULL && _claimant != claimant &&
+        millis() - _millisClaimed < _claimHoldTime_ms)
+    {
+        return false;
+    }
+    // Claiming again restarts the clock on the claim
+    _millisClaimed = millis();
+    _claimHoldTime_ms = holdTime_ms;
+    _claimant = claimant;
+    // If another SDI-12 object was activated in the mean time, reactivate this one
+    if (!_sdi12->isActive()) _sdi12->begin();
+    return true;
+}
+
+
+// This releases a claim on the bus
+void SDI12Bus::release(const void *claimant)
+{
+    if (_claimant == claimant) _claimant = NULL;
+}
+
+
+
 // The constructor - need the number of measurements the sensor will return, SDI-12 address, the power pin, and the data pin
 SDI12Sensors::SDI12Sensors(char SDI12address, int8_t powerPin, int8_t dataPin, uint8_t measurementsToAverage,
                            const char *sensorName, const uint8_t numReturnedVars,
@@ -21,9 +98,21 @@ SDI12Sensors::SDI12Sensors(char SDI12address, int8_t powerPin, int8_t dataPin, u
     : Sensor(sensorName, numReturnedVars,
              warmUpTime_ms, stabilizationTime_ms, measurementTime_ms,
              powerPin, dataPin, measurementsToAverage),
-    _SDI12Internal(dataPin)
+    _SDI12Own(dataPin),
+    _bus(SDI12Bus::getBus(dataPin, &_SDI12Own)),
+    _SDI12Internal(_bus ? *_bus->getSDI12() : _SDI12Own)
 {
     _SDI12address = SDI12address;
+    _onBus = false;
+    _valuesExpected = numReturnedVars;
+    _concurrent = true;
+    _useCRC = false;
+    _sensorWait_ms = measurementTime_ms;
+    _measurementWait_ms = measurementTime_ms;
+    _serviceRequested = false;
+    _millisCommandSent = 0;
+    _dataPage = 0;
+    _valuesReceived = 0;
 }
 SDI12Sensors::SDI12Sensors(char *SDI12address, int8_t powerPin, int8_t dataPin, uint8_t measurementsToAverage,
                            const char *sensorName, const uint8_t numReturnedVars,
@@ -31,9 +120,21 @@ SDI12Sensors::SDI12Sensors(char *SDI12address, int8_t powerPin, int8_t dataPin,
     : Sensor(sensorName, numReturnedVars,
              warmUpTime_ms, stabilizationTime_ms, measurementTime_ms,
              powerPin, dataPin, measurementsToAverage),
-    _SDI12Internal(dataPin)
+    _SDI12Own(dataPin),
+    _bus(SDI12Bus::getBus(dataPin, &_SDI12Own)),
+    _SDI12Internal(_bus ? *_bus->getSDI12() : _SDI12Own)
 {
     _SDI12address = *SDI12address;
+    _onBus = false;
+    _valuesExpected = numReturnedVars;
+    _concurrent = true;
+    _useCRC = false;
+    _sensorWait_ms = measurementTime_ms;
+    _measurementWait_ms = measurementTime_ms;
+    _serviceRequested = false;
+    _millisCommandSent = 0;
+    _dataPage = 0;
+    _valuesReceived = 0;
 }
 SDI12Sensors::SDI12Sensors(int SDI12address, int8_t powerPin, int8_t dataPin, uint8_t measurementsToAverage,
                            const char *sensorName, const uint8_t numReturnedVars,
@@ -41,9 +142,21 @@ SDI12Sensors::SDI12Sensors(int SDI12address, int8_t powerPin, int8_t dataPin, ui
     : Sensor(sensorName, numReturnedVars,
              warmUpTime_ms, stabilizationTime_ms, measurementTime_ms,
              powerPin, dataPin, measurementsToAverage),
-    _SDI12Internal(dataPin)
+    _SDI12Own(dataPin),
+    _bus(SDI12Bus::getBus(dataPin, &_SDI12Own)),
+    _SDI12Internal(_bus ? *_bus->getSDI12() : _SDI12Own)
 {
     _SDI12address = SDI12address + '0';
+    _onBus = false;
+    _valuesExpected = numReturnedVars;
+    _concurrent = true;
+    _useCRC = false;
+    _sensorWait_ms = measurementTime_ms;
+    _measurementWait_ms = measurementTime_ms;
+    _serviceRequested = false;
+    _millisCommandSent = 0;
+    _dataPage = 0;
+    _valuesReceived = 0;
 }
 // Destructor
 SDI12Sensors::~SDI12Sensors(){}
@@ -59,7 +172,7 @@ bool SDI12Sensors::setup(void)
     waitForWarmUp();
 
     // Begin the SDI-12 interface
-    _SDI12Internal.begin();
+    activateBus();
 
     // Library default timeout should be 150ms, which is 10 times that specified
     // by the SDI-12 protocol for a sensor response.
@@ -79,9 +192,8 @@ bool SDI12Sensors::setup(void)
     // Empty the SDI-12 buffer
     _SDI12Internal.clearBuffer();
 
-    // De-activate the SDI-12 Object
-    // Use end() instead of just forceHold to un-set the timers
-    _SDI12Internal.end();
+    // De-activate the SDI-12 Object, if no other sensors are using it
+    deactivateBus();
 
     // Turn the power back off it it had been turned on
     if (!wasOn) {powerDown();}
@@ -98,6 +210,57 @@ bool SDI12Sensors::setup(void)
 }
 
 
+// This releases the bus if the sensor was powered down in the middle of using it
+void SDI12Sensors::powerDown(void)
+{
+    Sensor::powerDown();
+    if (!_stepPending)
+    {
+        releaseBus();
+        deactivateBus();
+    }
+}
+
+
+// This adds the sensor to those using the bus
+void SDI12Sensors::activateBus(void)
+{
+    if (_onBus) return;
+    _onBus = true;
+    if (_bus != NULL) _bus->addUser();
+    // If there's no room for another bus, this sensor just uses its own object
+    // Use begin() instead of just setActive() to ensure timer is set correctly.
+    else _SDI12Internal.begin();
+}
+
+
+// This removes the sensor from those using the bus
+void SDI12Sensors::deactivateBus(void)
+{
+    if (!_onBus) return;
+    _onBus = false;
+    if (_bus != NULL) _bus->removeUser();
+    // Use end() instead of just forceHold to un-set the timers
+    else _SDI12Internal.end();
+}
+
+
+// This claims the bus for a single command and response
+bool SDI12Sensors::claimBus(void)
+{
+    if (_bus != NULL) return _bus->claim(this);
+    if (!_SDI12Internal.isActive()) _SDI12Internal.begin();
+    return true;
+}
+
+
+// This releases the claim on the bus
+void SDI12Sensors::releaseBus(void)
+{
+    if (_bus != NULL) _bus->release(this);
+}
+
+
 bool SDI12Sensors::requestSensorAcknowledgement(void)
 {
     // Empty the buffer
@@ -150,16 +313,9 @@ bool SDI12Sensors::requestSensorAcknowledgement(void)
 
 
 // A helper function to run the "sensor info" SDI12 command
+// NOTE:  The bus must already be activated
 bool SDI12Sensors::getSensorInfo(void)
 {
-    // MS_DBG(F("   Activating SDI-12 instance for"), getSensorNameAndLocation());
-    // Check if this the currently active SDI-12 Object
-    bool wasActive = _SDI12Internal.isActive();
-    // If it wasn't active, activate it now.
-    // Use begin() instead of just setActive() to ensure timer is set correctly.
-    // if (wasActive) {MS_DBG(F("   SDI-12 instance for"), getSensorNameAndLocation(),
-    //                       F("was already active!"));}
-    if (!wasActive) _SDI12Internal.begin();
     // Empty the buffer
     _SDI12Internal.clearBuffer();
 
@@ -183,10 +339,6 @@ bool SDI12Sensors::getSensorInfo(void)
     // Empty the buffer again
     _SDI12Internal.clearBuffer();
 
-    // De-activate the SDI-12 Object
-    // Use end() instead of just forceHold to un-set the timers
-    if (!wasActive) _SDI12Internal.end();
-
     if (sdiResponse.length() > 1)
     {
         String sdi12Address = sdiResponse.substring(0,1);
@@ -241,150 +393,467 @@ String SDI12Sensors::getSensorLocation(void)
 }
 
 
-// Sending the command to get a concurrent measurement
-bool SDI12Sensors::startSingleMeasurement(void)
+// Sending the command to get a concurrent or standard measurement
+// This starts a measurement without any delays, so other sensors can be
+// handled while waiting for this sensor to respond.  The start measurement
+// command doubles as the check that the sensor is responding, so there's no
+// separate acknowledgement command.
+// Phase 0 - check that the sensor is awake, wait for the bus, and send the command
+// Phase 1 - read the response to the start measurement command
+sensorStepState SDI12Sensors::startMeasurementStep(void)
+{
+    // If another SDI-12 object was activated while we were waiting, anything
+    // the sensor sent back is lost.  Reactivate this one and start over.
+    if (_stepPhase > 0 && !_SDI12Internal.isActive())
+    {
+        MS_DBG(F("   SDI-12 instance for"), getSensorNameAndLocation(),
+               F("was de-activated!  Restarting measurement request."));
+        _stepPhase = 0;
+    }
+
+    if (_stepPhase == 0)
+    {
+        // check if the sensor was successfully set up, run set up if not
+        // NOTE:  We continue regardless of the success of this attempt
+        if (!bitRead(_sensorStatus, 0))
+        {
+            MS_DBG(getSensorNameAndLocation(), F("was never properly set up, attempting setup now!"));
+            setup();
+        }
+        // If the sensor isn't awake, let Sensor::startSingleMeasurement()
+        // set the status bits for the failed attempt.
+        if (!bitRead(_sensorStatus, 4))
+        {
+            return finishStep(Sensor::startSingleMeasurement());
+        }
+
+        // Activate the bus and wait for our turn on it
+        activateBus();
+        if (!claimBus()) return retryStepAt(millis() + SDI12_BUS_RETRY_MS);
+
+        // Empty the buffer
+        _SDI12Internal.clearBuffer();
+
+        // Start concurrent measurement - format  [address]['C'][!]
+        // or standard measurement - format  [address]['M'][!]
+        // If asking for CRC's, the format is [address]['C' or 'M']['C'][!]
+        char startCommand[5];
+        uint8_t cmdLen = 0;
+        startCommand[cmdLen++] = _SDI12address;
+        startCommand[cmdLen++] = _concurrent ? 'C' : 'M';
+        if (_useCRC) startCommand[cmdLen++] = 'C';
+        startCommand[cmdLen++] = '!';
+        startCommand[cmdLen] = '\0';
+        MS_DBG(F("  Beginning"), _concurrent ? F("concurrent") : F("standard"),
+               F("measurement on"), getSensorNameAndLocation());
+        clearResponse();
+        _SDI12Internal.sendCommand(startCommand);
+        MS_DBG(F("    >>>"), startCommand);
+        _millisCommandSent = millis();
+        _stepAttempts++;
+
+        // It just needs this little delay
+        _stepPhase = 1;
+        return retryStepAt(millis() + 30);
+    }
+
+    // wait for acknowlegement with format
+    // [address][ttt (3 char, seconds)][number of values to be returned, 0-9]<CR><LF>
+    // (The number of values has 2 characters for concurrent measurements)
+    if (!receiveResponse() && millis() - _millisCommandSent < SDI12_START_TIMEOUT_MS)
+    {
+        return retryStepAt(millis() + SDI12_BUS_RETRY_MS);
+    }
+    MS_DBG(F("    <<<"), _response);
+
+    // A garbled reply (ie, from noise on the bus) is treated like a missing
+    // one, so it can't set a wild wait time or number of results
+    uint8_t replyLength = _concurrent ? 6 : 5;
+    bool validReply = _responseLength == replyLength && _response[0] == _SDI12address;
+    for (uint8_t i = 1; validReply && i < replyLength; i++)
+    {
+        if (!isdigit(_response[i])) validReply = false;
+    }
+    if (!validReply)
+    {
+        MS_DBG(getSensorNameAndLocation(), F("did not respond to measurement request!"));
+        // Try again, up to 3 times
+        if (_stepAttempts < 3)
+        {
+            _stepPhase = 0;
+            return retryStepAt(millis());
+        }
+        return finishMeasurementStart(false);
+    }
+
+    // Use the time and the number of results the sensor says it will need
+    _sensorWait_ms = 0;
+    for (uint8_t i = 1; i < 4; i++) _sensorWait_ms = _sensorWait_ms*10 + (_response[i] - '0');
+    _sensorWait_ms *= 1000;
+    _valuesExpected = 0;
+    for (uint8_t i = 4; i < _responseLength; i++) _valuesExpected = _valuesExpected*10 + (_response[i] - '0');
+    MS_DBG(F("    Measurement started."), _valuesExpected,
+           F("results expected within"), _sensorWait_ms, F("ms"));
+    if (_valuesExpected != _numReturnedVars)
+    {
+        MS_DBG(_valuesExpected, F("results expected"),
+               F("This differs from the sensor's standard design of"),
+               _numReturnedVars, F("measurements!!"));
+    }
+    // The time the sensor gives is only in whole seconds, so it's often
+    // longer than the measurement really takes.  For a standard measurement,
+    // the service request will tell us when it's actually done.  For a
+    // concurrent measurement, we first ask for the results after the
+    // measurement time from the constructor, if that's sooner, and ask again
+    // at the time the sensor gave if the results weren't ready.
+    _serviceRequested = false;
+    if (_concurrent) _measurementWait_ms = min(_measurementTime_ms, _sensorWait_ms);
+    else _measurementWait_ms = _sensorWait_ms;
+    return finishMeasurementStart(true);
+}
+
+
+// This cleans up after a measurement request and sets the status bits
+sensorStepState SDI12Sensors::finishMeasurementStart(bool success)
 {
-    // Sensor::startSingleMeasurement() checks that if it's awake/active and sets
-    // the timestamp and status bits.  If it returns false, there's no reason to go on.
-    if (!Sensor::startSingleMeasurement()) return false;
-
-    String startCommand;
-    String sdiResponse;
-    bool wasActive;
-
-    // MS_DBG(F("   Activating SDI-12 instance for"), getSensorNameAndLocation());
-    // Check if this the currently active SDI-12 Object
-    wasActive = _SDI12Internal.isActive();
-    // if (wasActive) {MS_DBG(F("   SDI-12 instance for"), getSensorNameAndLocation(),
-    //                       F("was already active!"));}
-    // If it wasn't active, activate it now.
-    // Use begin() instead of just setActive() to ensure timer is set correctly.
-    if (!wasActive) _SDI12Internal.begin();
     // Empty the buffer
     _SDI12Internal.clearBuffer();
-
-    // Check that the sensor is there and responding
-    if (!requestSensorAcknowledgement())
+    // During a standard measurement no other sensor can use the bus until
+    // the measurement is finished, so hang on to it.  Otherwise let the next
+    // sensor have the bus.
+    if (success && !_concurrent && _bus != NULL)
+    {
+        _bus->claim(this, _sensorWait_ms + SDI12_BUS_CLAIM_TIMEOUT_MS);
+    }
+    else releaseBus();
+    // If we won't be getting results, we don't need the bus any more
+    if (!success) deactivateBus();
+
+    // Sensor::startSingleMeasurement() sets the timestamp and status bits.
+    // We already know the sensor is awake, so it will mark the start as good.
+    Sensor::startSingleMeasurement();
+    // Unset the time and success bit (bit 6) if the sensor didn't respond
+    if (!success)
     {
         _millisMeasurementRequested = 0;
         _sensorStatus &= 0b10111111;
-        return false;
     }
+    return finishStep(success);
+}
 
-    MS_DBG(F("  Beginning concurrent measurement on"), getSensorNameAndLocation());
-    startCommand = "";
-    startCommand += _SDI12address;
-    startCommand += "C!";  // Start concurrent measurement - format  [address]['C'][!]
-    _SDI12Internal.sendCommand(startCommand);
-    delay(30);  // It just needs this little delay
-    MS_DBG(F("    >>>"), startCommand);
 
-    // wait for acknowlegement with format
-    // [address][ttt (3 char, seconds)][number of values to be returned, 0-9]<CR><LF>
-    sdiResponse = _SDI12Internal.readStringUntil('\n');
-    sdiResponse.trim();
-    _SDI12Internal.clearBuffer();
-    MS_DBG(F("    <<<"), sdiResponse);
+bool SDI12Sensors::startSingleMeasurement(void)
+{
+    return runStepToCompletion(&Sensor::startMeasurementStep);
+}
 
-    // Empty the buffer again
-    _SDI12Internal.clearBuffer();
 
-    // De-activate the SDI-12 Object
-    // Use end() instead of just forceHold to un-set the timers
-    if (!wasActive) _SDI12Internal.end();
-
-    // Verify the number of results the sensor will send
-    // uint8_t numVariables = sdiResponse.substring(4).toInt();
-    // if (numVariables != _numReturnedVars)
-    // {
-    //     MS_DBG(numVariables, F("results expected"),
-    //            F("This differs from the sensor's standard design of"),
-    //            numReturnedVars, F("measurements!!"));
-    // }
-
-    // Set the times we've activated the sensor and asked for a measurement
-    if (sdiResponse.length() > 0)
-    {
-        MS_DBG(F("    Concurrent measurement started."));
-        // Update the time that a measurement was requested
-        _millisMeasurementRequested = millis();
-        // Set the status bit for measurement start success (bit 6)
-        _sensorStatus |= 0b01000000;
+// This checks if the measurement should be finished, based on the time the
+// sensor said it would need or a service request
+bool SDI12Sensors::isMeasurementComplete(bool debug)
+{
+    // If a measurement failed to start, let the base class handle it
+    if (!bitRead(_sensorStatus, 6)) return Sensor::isMeasurementComplete(debug);
+
+    // For a standard measurement, check if the sensor has sent its service
+    // request, with the format [address]<CR><LF>
+    if (!_concurrent && !_serviceRequested && _SDI12Internal.isActive())
+    {
+        while (_SDI12Internal.available())
+        {
+            if (_SDI12Internal.read() == _SDI12address) _serviceRequested = true;
+        }
+    }
+    if (_serviceRequested)
+    {
+        if (debug) {MS_DBG(getSensorNameAndLocation(),
+                          F("sent a service request, measurement is complete!"));}
         return true;
     }
-    else
+
+    uint32_t elapsed_since_meas_start = millis() - _millisMeasurementRequested;
+    if (elapsed_since_meas_start > _measurementWait_ms)
     {
-        MS_DBG(getSensorNameAndLocation(), F("did not respond to measurement request!"));
-        _millisMeasurementRequested = 0;
-        _sensorStatus &= 0b10111111;
-        return false;
+        if (debug) {MS_DBG(F("It's been"), (elapsed_since_meas_start),
+                          F("ms, and measurement by"), getSensorNameAndLocation(),
+                          F("should be complete!"));}
+        return true;
     }
+    else return false;
 }
 
 
-bool SDI12Sensors::addSingleMeasurementResult(void)
+// This uses the time the sensor said it would need as the deadline for the
+// measurement, so the sensors on a bus are read in the order they finish
+uint32_t SDI12Sensors::getNextStepTime(void)
+{
+    if (!_stepPending && bitRead(_sensorStatus, 5) && bitRead(_sensorStatus, 6))
+    {
+        uint32_t deadline = _millisMeasurementRequested + _measurementWait_ms + 1;
+        // For a standard measurement, check back regularly for the service request
+        if (!_concurrent && !_serviceRequested)
+        {
+            uint32_t nextPoll = millis() + SDI12_SERVICE_REQUEST_POLL_MS;
+            if ((int32_t)(nextPoll - deadline) < 0) return nextPoll;
+        }
+        return deadline;
+    }
+    return Sensor::getNextStepTime();
+}
+
+
+// This gets the results of the measurement
+// The values may be spread over several data commands (aD0! through aD9!);
+// the commands are sent until the sensor has sent as many values as it said
+// it would, or it sends a response with no values.
+// Phase 0 - wait for the bus, and send the command for the next page of data
+// Phase 1 - wait for the data and read it
+sensorStepState SDI12Sensors::getResultsStep(uint8_t maxResults)
 {
-    bool success = false;
+    if (maxResults > MAX_NUMBER_VARS) maxResults = MAX_NUMBER_VARS;
+
+    // If this is a new request, start from the first page with no values
+    if (!_stepPending)
+    {
+        _dataPage = 0;
+        _valuesReceived = 0;
+        for (uint8_t i = 0; i < MAX_NUMBER_VARS; i++) _results[i] = -9999;
+    }
 
     // Check a measurement was *successfully* started (status bit 6 set)
     // Only go on to get a result if it was
-    if (bitRead(_sensorStatus, 6))
-    {
-        // MS_DBG(F("   Activating SDI-12 instance for"), getSensorNameAndLocation());
-        // Check if this the currently active SDI-12 Object
-        bool wasActive = _SDI12Internal.isActive();
-        // if (wasActive) {MS_DBG(F("   SDI-12 instance for"), getSensorNameAndLocation(),
-        //                       F("was already active!"));}
-        // If it wasn't active, activate it now.
-        // Use begin() instead of just setActive() to ensure timer is set correctly.
-        if (!wasActive) _SDI12Internal.begin();
+    if (!bitRead(_sensorStatus, 6))
+    {
+        MS_DBG(getSensorNameAndLocation(), F("is not currently measuring!"));
+        deactivateBus();
+        return finishStep(false);
+    }
+
+    // If another SDI-12 object was activated while we were waiting, anything
+    // the sensor sent back is lost.  Reactivate this one and ask again.
+    if (_stepPhase > 0 && !_SDI12Internal.isActive())
+    {
+        MS_DBG(F("   SDI-12 instance for"), getSensorNameAndLocation(),
+               F("was de-activated!  Asking for data again."));
+        _stepPhase = 0;
+    }
+
+    if (_stepPhase == 0)
+    {
+        // Activate the bus and wait for our turn on it
+        activateBus();
+        if (!claimBus()) return retryStepAt(millis() + SDI12_BUS_RETRY_MS);
+
         // Empty the buffer
         _SDI12Internal.clearBuffer();
 
-        MS_DBG(getSensorNameAndLocation(), F("is reporting:"));
-        String getDataCommand = "";
-        getDataCommand += _SDI12address;
-        getDataCommand += "D0!";  // SDI-12 command to get data [address][D][dataOption][!]
+        if (_dataPage == 0) {MS_DBG(getSensorNameAndLocation(), F("is reporting:"));}
+        // SDI-12 command to get data [address][D][dataOption][!]
+        char getDataCommand[5] = {_SDI12address, 'D', (char)('0' + _dataPage), '!', '\0'};
+        clearResponse();
         _SDI12Internal.sendCommand(getDataCommand);
-        delay(30);  // It just needs this little delay
         MS_DBG(F("    >>>"), getDataCommand);
+        _millisCommandSent = millis();
+        _stepAttempts++;
 
-        uint32_t start = millis();
-        while (_SDI12Internal.available() < 3 && (millis() - start) < 1500) {}
-        MS_DBG(F("  Receiving results from"), getSensorNameAndLocation());
-        _SDI12Internal.read();  // ignore the repeated SDI12 address
-        for (uint8_t i = 0; i < _numReturnedVars; i++)
+        // It just needs this little delay
+        _stepPhase = 1;
+        return retryStepAt(millis() + 30);
+    }
+
+    // Wait for the whole response, but don't wait forever
+    bool responseComplete = receiveResponse();
+    if (!responseComplete && millis() - _millisCommandSent < SDI12_RESPONSE_TIMEOUT_MS)
+    {
+        return retryStepAt(millis() + SDI12_BUS_RETRY_MS);
+    }
+    MS_DBG(F("    <<<"), _response);
+    // A response cut off before its <CR><LF> may have lost part of its last
+    // value, so it's asked for again like one with a bad CRC
+    if (!responseComplete) {MS_DBG(F("  Response timed out!"));}
+
+    // Check the CRC, if we asked for one.  If it's bad, ask for the same page again.
+    bool responseOK = (responseComplete && _responseLength > 0 &&
+                       _response[0] == _SDI12address);
+    if (responseOK && _useCRC)
+    {
+        responseOK = checkAndRemoveCRC();
+        if (!responseOK) {MS_DBG(F("  CRC check failed!"));}
+    }
+    if (!responseOK && _stepAttempts < 3)
+    {
+        _stepPhase = 0;
+        return retryStepAt(millis());
+    }
+
+    // Parse the values, skipping the address
+    uint8_t nValues = 0;
+    if (responseOK)
+    {
+        nValues = parseValues(_response + 1, _results, _valuesReceived, maxResults);
+    }
+    MS_DBG(F("  Received"), nValues, F("values on page"), _dataPage);
+
+    // If the sensor sent back only its address on the first page, the results
+    // aren't ready yet.  If we asked before the time the sensor gave, wait
+    // until then and ask again.
+    uint32_t sensorReadyTime = _millisMeasurementRequested + _sensorWait_ms + 1;
+    if (responseOK && nValues == 0 && _dataPage == 0 &&
+        (int32_t)(millis() - sensorReadyTime) < 0)
+    {
+        MS_DBG(F("  Results not ready yet, will ask again."));
+        _SDI12Internal.clearBuffer();
+        releaseBus();
+        _stepPhase = 0;
+        _stepAttempts = 0;
+        return retryStepAt(sensorReadyTime);
+    }
+    _valuesReceived += nValues;
+
+    // If there are more values coming, ask for the next page
+    if (nValues > 0 && _valuesReceived < _valuesExpected && _dataPage < 9)
+    {
+        _dataPage++;
+        _stepPhase = 0;
+        _stepAttempts = 0;
+        return retryStepAt(millis());
+    }
+
+    // Empty the buffer again
+    _SDI12Internal.clearBuffer();
+
+    // Let the next sensor have the bus, and de-activate the SDI-12 Object if
+    // no other sensors are waiting on it
+    releaseBus();
+    deactivateBus();
+
+    return finishStep(_valuesReceived > 0);
+}
+
+
+// The response to the command in progress
+char SDI12Sensors::_response[SDI12_MAX_RESPONSE_LENGTH + 1];
+uint8_t SDI12Sensors::_responseLength = 0;
+
+
+// This empties the response buffer
+void SDI12Sensors::clearResponse(void)
+{
+    _responseLength = 0;
+    _response[0] = '\0';
+}
+
+
+// This moves any characters waiting on the bus into the response buffer
+// and returns true once the whole response (ending in <CR><LF>) is in.
+// The <CR><LF> are not kept.
+bool SDI12Sensors::receiveResponse(void)
+{
+    while (_SDI12Internal.available())
+    {
+        char c = _SDI12Internal.read();
+        if (c == '\n') return true;
+        if (c == '\r' || c < 0) continue;
+        if (_responseLength < SDI12_MAX_RESPONSE_LENGTH)
         {
-            float result = _SDI12Internal.parseFloat();
-            // The SDI-12 library should return -9999 on timeout
-            if (result == -9999 or isnan(result)) result = -9999;
-            MS_DBG(F("    <<< Result #"), i, ':', result);
-            verifyAndAddMeasurementResult(i, result);
+            _response[_responseLength++] = c;
+            _response[_responseLength] = '\0';
+        }
+    }
+    return false;
+}
+
+
+// This checks the 3 character CRC at the end of the response and removes it
+// The CRC is the CRC-16/ARC of everything before it, sent as three ASCII
+// characters each holding 6 bits, with 0x40 added.
+bool SDI12Sensors::checkAndRemoveCRC(void)
+{
+    if (_responseLength < 4) return false;
+    uint8_t dataLength = _responseLength - 3;
 
+    uint16_t crc = 0;
+    for (uint8_t i = 0; i < dataLength; i++)
+    {
+        crc ^= (uint8_t)_response[i];
+        for (uint8_t j = 0; j < 8; j++)
+        {
+            if (crc & 0x0001) crc = (crc >> 1) ^ 0xA001;
+            else crc >>= 1;
         }
-        // String sdiResponse = _SDI12Internal.readStringUntil('\n');
-        // sdiResponse.trim();
-        // _SDI12Internal.clearBuffer();
-        // MS_DBG(F("    <<<"), sdiResponse);
+    }
 
-        // Empty the buffer again
-        _SDI12Internal.clearBuffer();
+    bool match = (_response[dataLength] == (char)(0x40 | (crc >> 12))) &&
+                 (_response[dataLength + 1] == (char)(0x40 | ((crc >> 6) & 0x3F))) &&
+                 (_response[dataLength + 2] == (char)(0x40 | (crc & 0x3F)));
+
+    _responseLength = dataLength;
+    _response[_responseLength] = '\0';
+    return match;
+}
 
-        // De-activate the SDI-12 Object
-        // Use end() instead of just forceHold to un-set the timers
-        if (!wasActive) _SDI12Internal.end();
 
-        success  = true;
+// This parses a string of SDI-12 values into the results array, starting at
+// result number firstResult.  Each value begins with its sign, so the values
+// are in the format [+/-][digits][.][digits], with no spaces between them.
+// Values beyond maxResults are counted but not kept.
+// Returns the number of values found.
+uint8_t SDI12Sensors::parseValues(const char *values, float results[],
+                                  uint8_t firstResult, uint8_t maxResults)
+{
+    uint8_t nValues = 0;
+    const char *c = values;
+    while (*c != '\0')
+    {
+        // Every value must start with a sign
+        if (*c != '+' && *c != '-') {c++; continue;}
+        bool negative = (*c == '-');
+        c++;
+
+        // Read the digits as an integer and count the places after the decimal
+        // SDI-12 values have at most 7 digits, so this can't overflow
+        int32_t mantissa = 0;
+        uint8_t decimals = 0;
+        bool pastDecimal = false;
+        bool anyDigits = false;
+        while ((*c >= '0' && *c <= '9') || *c == '.')
+        {
+            if (*c == '.') pastDecimal = true;
+            else
+            {
+                mantissa = mantissa*10 + (*c - '0');
+                if (pastDecimal) decimals++;
+                anyDigits = true;
+            }
+            c++;
+        }
+        if (!anyDigits) continue;
+
+        float value = mantissa;
+        while (decimals > 0) {value /= 10; decimals--;}
+        if (negative) value = -value;
+
+        uint8_t resultNumber = firstResult + nValues;
+        if (resultNumber < maxResults)
+        {
+            MS_DBG(F("    <<< Result #"), resultNumber, ':', value);
+            results[resultNumber] = value;
+        }
+        nValues++;
     }
-    else
+    return nValues;
+}
+
+
+sensorStepState SDI12Sensors::addResultStep(void)
+{
+    sensorStepState state = getResultsStep(_numReturnedVars);
+    if (state == STEP_PENDING) return state;
+
+    // If there's no measurement, this sends over all of the "failed" result values
+    for (uint8_t i = 0; i < _numReturnedVars; i++)
     {
-        // If there's no measurement, need to make sure we send over all
-        // of the "failed" result values
-        MS_DBG(getSensorNameAndLocation(), F("is not currently measuring!"));
-       for (uint8_t i = 0; i < _numReturnedVars; i++)
-       {
-           verifyAndAddMeasurementResult(i, (float)-9999);
-       }
+        verifyAndAddMeasurementResult(i, _results[i]);
     }
 
     // Unset the time stamp for the beginning of this measurement
@@ -392,5 +861,11 @@ bool SDI12Sensors::addSingleMeasurementResult(void)
     // Unset the status bits for a measurement request (bits 5 & 6)
     _sensorStatus &= 0b10011111;
 
-     return success;
+    return state;
+}
+
+
+bool SDI12Sensors::addSingleMeasurementResult(void)
+{
+    return runStepToCompletion(&Sensor::addResultStep);
 }
@@ -35,6 +35,82 @@
 // NOTE:  Can use the "regular" sdi-12 library with build flag -D SDI12_EXTERNAL_PCINT
 // Unfortunately, that is not compatible with the Arduino IDE
 
+// The largest number of separate SDI-12 data pins
+#ifndef MAX_NUMBER_SDI12_BUSES
+#define MAX_NUMBER_SDI12_BUSES 4
+#endif
+
+// The longest a single sensor can hold the bus for one command and response
+// before another sensor is allowed to take it over
+#ifndef SDI12_BUS_CLAIM_TIMEOUT_MS
+#define SDI12_BUS_CLAIM_TIMEOUT_MS 2000
+#endif
+
+// How often to check back if the bus is being used by another sensor
+#define SDI12_BUS_RETRY_MS 10
+
+// How often to check for a service request from a sensor taking a standard
+// (non-concurrent) measurement
+#define SDI12_SERVICE_REQUEST_POLL_MS 20
+
+// The longest possible response:  the address, 75 characters of values, and
+// a 3 character CRC.  (The ending <CR><LF> isn't kept.)
+#define SDI12_MAX_RESPONSE_LENGTH 79
+
+// The longest to wait for a full response after sending a command
+// At 1200 baud, each character takes about 8.3ms to send, so the short
+// response to a start measurement command should be in well before a page
+// of data.
+#ifndef SDI12_RESPONSE_TIMEOUT_MS
+#define SDI12_RESPONSE_TIMEOUT_MS 1000
+#endif
+#ifndef SDI12_START_TIMEOUT_MS
+#define SDI12_START_TIMEOUT_MS 150
+#endif
+
+
+// This keeps track of a single SDI-12 data pin that may be shared by several
+// sensors.  All sensors on the pin use the same SDI-12 object, the object is
+// only activated once for as long as any sensor on the pin is waiting on a
+// measurement, and only one sensor at a time can send a command and wait for
+// the response.  Other sensors on the pin wait their turn, so their commands
+// and responses never collide.
+class SDI12Bus
+{
+public:
+    // This finds the bus for a data pin, adding it if it's new.  The SDI-12
+    // object of the first sensor on the pin is used for the whole bus.
+    // Returns NULL if there are already MAX_NUMBER_SDI12_BUSES pins in use.
+    static SDI12Bus* getBus(int8_t dataPin, SDI12 *sdi12Object);
+
+    SDI12* getSDI12(void){return _sdi12;}
+    int8_t getDataPin(void){return _dataPin;}
+    uint8_t getUserCount(void){return _activeUsers;}
+
+    // These add and remove a sensor from those using the bus.  The SDI-12
+    // object is activated for the first user and de-activated after the last.
+    void addUser(void);
+    void removeUser(void);
+
+    // These claim and release the bus for a single command and response.
+    // If another sensor has claimed the bus, claim() returns false.
+    // The claim can be taken over by another sensor after holdTime_ms.
+    bool claim(const void *claimant, uint32_t holdTime_ms = SDI12_BUS_CLAIM_TIMEOUT_MS);
+    void release(const void *claimant);
+
+private:
+    static SDI12Bus _buses[MAX_NUMBER_SDI12_BUSES];
+    static uint8_t _busCount;
+
+    int8_t _dataPin;
+    SDI12 *_sdi12;
+    uint8_t _activeUsers;
+    const void *_claimant;
+    uint32_t _millisClaimed;
+    uint32_t _claimHoldTime_ms;
+};
+
+
 // The main class for SDI-12 Sensors
 class SDI12Sensors : public Sensor
 {
@@ -58,16 +134,94 @@ public:
     String getSensorLocation(void) override;
 
     virtual bool setup(void) override;
+    // This releases the bus if the sensor was still using it
+    virtual void powerDown(void) override;
+
+    // This sets whether to start concurrent measurements (aC!) or standard
+    // measurements (aM!).  Other sensors on the same data pin can be started
+    // and read during a concurrent measurement.  During a standard measurement
+    // the sensor has the bus to itself, but sends a "service request" as soon
+    // as it is finished so the results can be read without waiting for the
+    // whole time it gave when the measurement was started.
+    // Concurrent measurements are used by default.
+    void setConcurrentMeasurements(bool useConcurrent){_concurrent = useConcurrent;}
+
+    // This sets whether to ask the sensor to add a CRC to its data so the
+    // values can be checked (aMC! or aCC!).  A page of data with a bad CRC
+    // is requested again, up to 3 times.
+    // This is off by default.
+    void setCRCRequests(bool useCRC){_useCRC = useCRC;}
 
     virtual bool startSingleMeasurement(void);
     virtual bool addSingleMeasurementResult(void);
 
+    // These are the non-blocking versions of startSingleMeasurement() and
+    // addSingleMeasurementResult().  They wait their turn for the bus.
+    virtual sensorStepState startMeasurementStep(void) override;
+    virtual sensorStepState addResultStep(void) override;
+
+    // These use the time the sensor reported it would need to finish the
+    // measurement in its response to the start measurement command, and for
+    // standard measurements, check for the service request
+    virtual bool isMeasurementComplete(bool debug=false) override;
+    virtual uint32_t getNextStepTime(void) override;
+
 protected:
     bool requestSensorAcknowledgement(void);
     bool getSensorInfo(void);
-    SDI12 _SDI12Internal;
+    sensorStepState finishMeasurementStart(bool success);
+    // This gets the results of a measurement from the sensor, putting up to
+    // maxResults values into the _results array.  Any values not returned
+    // are left at -9999.  The bits and time stamps for the measurement
+    // request are NOT unset, but the step is finished when this returns
+    // STEP_DONE or STEP_FAILED.
+    sensorStepState getResultsStep(uint8_t maxResults);
+
+    // These add and remove this sensor from those using the bus
+    void activateBus(void);
+    void deactivateBus(void);
+    // These claim and release the bus for a single command and response
+    bool claimBus(void);
+    void releaseBus(void);
+
+    // These receive, check, and parse responses without using any Strings
+    // Only one SDI-12 object can be active at a time, so only one response
+    // can be coming in at a time and all sensors share one buffer.
+    static char _response[SDI12_MAX_RESPONSE_LENGTH + 1];
+    static uint8_t _responseLength;
+    void clearResponse(void);
+    bool receiveResponse(void);
+    bool checkAndRemoveCRC(void);
+    static uint8_t parseValues(const char *values, float results[],
+                               uint8_t firstResult, uint8_t maxResults);
+
+    // This sensor's own SDI-12 object; only used if it's the first on the pin
+    // NOTE:  The order of these matters!  They're initialized in this order.
+    SDI12 _SDI12Own;
+    SDI12Bus *_bus;
+    // The SDI-12 object shared by all sensors on the data pin
+    SDI12 &_SDI12Internal;
+    bool _onBus;
     char _SDI12address;
 
+    // Whether to use concurrent (aC!) or standard (aM!) measurements, and
+    // whether to ask for CRC's
+    bool _concurrent;
+    bool _useCRC;
+    // The number of values and the time (in ms) the sensor said it would
+    // need for the current measurement, when to first ask for the results,
+    // and whether the sensor sent a service request saying it's done
+    uint8_t _valuesExpected;
+    uint32_t _sensorWait_ms;
+    uint32_t _measurementWait_ms;
+    bool _serviceRequested;
+    uint32_t _millisCommandSent;
+    // The page of data being requested and the number of values received so far
+    uint8_t _dataPage;
+    uint8_t _valuesReceived;
+    // The values received so far, kept between the steps for each page
+    float _results[MAX_NUMBER_VARS];
+
 private:
     String _sensorVendor;
     String _sensorModel;
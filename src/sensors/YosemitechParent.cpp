@@ -29,6 +29,8 @@ YosemitechParent::YosemitechParent(byte modbusAddress, Stream* stream,
     _stream = stream;
     _RS485EnablePin = enablePin;
     _powerPin2 = powerPin2;
+    _bus = ModbusBus::getBus(_stream, _powerPin2, &_ownBus);
+    _adapterPowered = false;
 }
 YosemitechParent::YosemitechParent(byte modbusAddress, Stream& stream,
                                    int8_t powerPin, int8_t powerPin2, int8_t enablePin, uint8_t measurementsToAverage,
@@ -43,6 +45,8 @@ YosemitechParent::YosemitechParent(byte modbusAddress, Stream& stream,
     _stream = &stream;
     _RS485EnablePin = enablePin;
     _powerPin2 = powerPin2;
+    _bus = ModbusBus::getBus(_stream, _powerPin2, &_ownBus);
+    _adapterPowered = false;
 }
 // Destructor
 YosemitechParent::~YosemitechParent(){}
@@ -78,27 +82,36 @@ bool YosemitechParent::setup(void)
 
 // The function to wake up a sensor
 // Different from the standard in that it waits for warm up and starts measurements
-bool YosemitechParent::wake(void)
+// This makes a single attempt to start measurements on each call, so other
+// sensors can be handled between retries.
+sensorStepState YosemitechParent::wakeStep(void)
 {
-    // Sensor::wake() checks if the power pin is on and sets the wake timestamp
-    // and status bits.  If it returns false, there's no reason to go on.
-    if (!Sensor::wake()) return false;
+    // If the sensor doesn't have power, let Sensor::wake() set the status
+    // bits for the failed attempt.  There's no reason to go on.
+    if (!bitRead(_sensorStatus, 2)) return finishStep(Sensor::wake());
+
+    // Wait for our turn on the bus
+    if (!_bus->claim(this)) return retryStepAt(_bus->getReadyTime());
 
     // Send the command to begin taking readings, trying up to 5 times
-    bool success = false;
-    uint8_t ntries = 0;
-    MS_DBG(F("Start Measurement on"), getSensorNameAndLocation());
-    while (!success && ntries < 5)
+    if (_stepAttempts == 0)
     {
-        MS_DBG('(', ntries+1, F("):"));
-        success = sensor.startMeasurement();
-        ntries++;
+        MS_DBG(F("Start Measurement on"), getSensorNameAndLocation());
+    }
+    MS_DBG('(', _stepAttempts+1, F("):"));
+    bool success = sensor.startMeasurement();
+    _stepAttempts++;
+    // Let other sensors use the bus between attempts
+    if (!success && _stepAttempts < 5)
+    {
+        _bus->release(this);
+        return retryStepAt(_bus->getReadyTime());
     }
 
+    // Sensor::wake() sets the wake timestamp and status bits
+    Sensor::wake();
     if (success)
     {
-        // Update the time that the sensor was activated
-        _millisSensorActivated = millis();
         MS_DBG(getSensorNameAndLocation(), F("activated and measuring."));
     }
     else
@@ -124,31 +137,44 @@ bool YosemitechParent::wake(void)
         }
     }
 
-    return success;
+    // Let the next sensor have the bus
+    _bus->release(this);
+
+    return finishStep(success);
+}
+bool YosemitechParent::wake(void)
+{
+    return runStepToCompletion(&Sensor::wakeStep);
 }
 
 
 // The function to put the sensor to sleep
 // Different from the standard in that it stops measurements
-bool YosemitechParent::sleep(void)
+// This makes a single attempt to stop measurements on each call.
+sensorStepState YosemitechParent::sleepStep(void)
 {
-    if (!checkPowerOn()) {return true;}
+    if (!checkPowerOn()) {return finishStep(true);}
     if (_millisSensorActivated == 0)
     {
         MS_DBG(getSensorNameAndLocation(), F("was not measuring!"));
-        return true;
+        return finishStep(true);
     }
 
-    // Send the command to begin taking readings, trying up to 5 times
-    bool success = false;
-    uint8_t ntries = 0;
-    MS_DBG(F("Stop Measurement on"), getSensorNameAndLocation());
-    while (!success && ntries < 5)
+    // Wait for our turn on the bus
+    if (!_bus->claim(this)) return retryStepAt(_bus->getReadyTime());
+
+    // Send the command to stop taking readings, trying up to 5 times
+    if (_stepAttempts == 0)
     {
-        MS_DBG('(', ntries+1, F("):"));
-        success = sensor.stopMeasurement();
-        ntries++;
+        MS_DBG(F("Stop Measurement on"), getSensorNameAndLocation());
     }
+    MS_DBG('(', _stepAttempts+1, F("):"));
+    bool success = sensor.stopMeasurement();
+    _stepAttempts++;
+    // Let other sensors use the bus between attempts
+    _bus->release(this);
+    if (!success && _stepAttempts < 5) return retryStepAt(_bus->getReadyTime());
+
     if (success)
     {
         // Unset the activation time
@@ -165,7 +191,11 @@ bool YosemitechParent::sleep(void)
         MS_DBG(F("Measurements NOT stopped!"));
     }
 
-    return success;
+    return finishStep(success);
+}
+bool YosemitechParent::sleep(void)
+{
+    return runStepToCompletion(&Sensor::sleepStep);
 }
 
 
@@ -180,13 +210,15 @@ void YosemitechParent::powerUp(void)
         // Mark the time that the sensor was powered
         _millisPowerOn = millis();
     }
-    if (_powerPin2 >= 0)
+    // The secondary power pin is for the RS-485 adapter, which is shared by
+    // all of the sensors on the stream.  It stays on until the last one is
+    // powered down.
+    if (!_adapterPowered)
     {
-        MS_DBG(F("Applying secondary power to"), getSensorNameAndLocation(),
-               F("with pin"), _powerPin2);
-        digitalWrite(_powerPin2, HIGH);
+        _bus->addPoweredUser();
+        _adapterPowered = true;
     }
-    if (_powerPin < 0 && _powerPin2 < 0)
+    if (_powerPin < 0 && _bus->getAdapterPowerPin() < 0)
     {
         MS_DBG(F("Power to"), getSensorNameAndLocation(),
                F("is not controlled by this library."));
@@ -213,14 +245,16 @@ void YosemitechParent::powerDown(void)
         // Unset the status bits for sensor power (bits 1 & 2),
         // activation (bits 3 & 4), and measurement request (bits 5 & 6)
         _sensorStatus &= 0b10000001;
+        // Abandon any step that was in progress
+        finishStep(false);
     }
-    if (_powerPin2 >= 0)
+    // Only turn off the RS-485 adapter if no other sensors on the stream need it
+    if (_adapterPowered)
     {
-        MS_DBG(F("Turning off secondary power to"), getSensorNameAndLocation(),
-               F("with pin"), _powerPin2);
-        digitalWrite(_powerPin2, LOW);
+        _bus->removePoweredUser();
+        _adapterPowered = false;
     }
-    if (_powerPin < 0 && _powerPin2 < 0)
+    if (_powerPin < 0 && _bus->getAdapterPowerPin() < 0)
     {
         MS_DBG(F("Power to"), getSensorNameAndLocation(),
                F("is not controlled by this library."));
@@ -229,10 +263,17 @@ void YosemitechParent::powerDown(void)
 }
 
 
-bool YosemitechParent::addSingleMeasurementResult(void)
+// This waits for its turn on the bus and then gets the results
+sensorStepState YosemitechParent::addResultStep(void)
 {
     bool success = false;
 
+    // Wait for our turn on the bus, if we need it
+    if (bitRead(_sensorStatus, 6) && !_bus->claim(this))
+    {
+        return retryStepAt(_bus->getReadyTime());
+    }
+
     // Check a measurement was *successfully* started (status bit 6 set)
     // Only go on to get a result if it was
     if (bitRead(_sensorStatus, 6))
@@ -330,6 +371,13 @@ bool YosemitechParent::addSingleMeasurementResult(void)
     // Unset the status bits for a measurement request (bits 5 & 6)
     _sensorStatus &= 0b10011111;
 
+    // Let the next sensor have the bus
+    _bus->release(this);
+
     // Return true when finished
-    return success;
+    return finishStep(success);
+}
+bool YosemitechParent::addSingleMeasurementResult(void)
+{
+    return runStepToCompletion(&Sensor::addResultStep);
 }
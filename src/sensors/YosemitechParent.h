@@ -35,6 +35,7 @@
 #undef MS_DEBUGGING_DEEP
 #include "VariableBase.h"
 #include "SensorBase.h"
+#include "ModbusBus.h"
 #include <YosemitechModbus.h>
 
 // The main class for the Yosemitech Sensors
@@ -56,12 +57,17 @@ public:
     virtual bool setup(void) override;
     virtual bool wake(void) override;
     virtual bool sleep(void) override;
+    // These make a single attempt at the modbus command on each call
+    virtual sensorStepState wakeStep(void) override;
+    virtual sensorStepState sleepStep(void) override;
 
     // Override these to use two power pins
     virtual void powerUp(void) override;
     virtual void powerDown(void) override;
 
     virtual bool addSingleMeasurementResult(void);
+    // This waits its turn for the bus before getting the results
+    virtual sensorStepState addResultStep(void) override;
 
 private:
     yosemitech sensor;
@@ -70,6 +76,11 @@ private:
     Stream* _stream;
     int8_t _RS485EnablePin;
     int8_t _powerPin2;
+    // The RS-485 bus this sensor is on.  The sensor's own bus object is only
+    // used if it's the first sensor on the stream.
+    ModbusBus _ownBus;
+    ModbusBus *_bus;
+    bool _adapterPowered;
 };
 
 #endif  // Header Guard
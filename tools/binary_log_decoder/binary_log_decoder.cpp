@@ -0,0 +1,250 @@
+/*
+ *binary_log_decoder.cpp
+ *This file is part of the EnviroDIY modular sensors library for Arduino
+ *
+ *This is a program for a computer (NOT for the Arduino!) to convert a log
+ *file saved in the binary format (Logger::setLogFileFormat(LOG_FORMAT_BINARY))
+ *back into the same CSV a logger saves by default, header and all.
+ *
+ *To build it on Linux or a Mac:
+ *    g++ -O2 -o binary_log_decoder binary_log_decoder.cpp
+ *To use it:
+ *    ./binary_log_decoder LOGGER_2019-01-01.dat > LOGGER_2019-01-01.csv
+ *
+ *If the end of the file is cut off part way through a record (ie, the power
+ *failed during a write), the partial record is skipped with a warning.
+ *A preallocated file (Logger::setPreallocatedFileSize()) that wasn't finished
+ *ends in blank space (all 0x00 or all 0xFF bytes); the records stop at the
+ *first record that is all blank.
+*/
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// These must match LoggerBase.h
+#define MS_BINARY_LOG_MAGIC "MSLB"
+#define MS_BINARY_LOG_VERSION 1
+
+// The longest string the logger could have written into the schema
+#define MAX_STRING_LENGTH 256
+
+
+struct variableSchema
+{
+    uint8_t resolution;
+    char sensorName[MAX_STRING_LENGTH];
+    char varName[MAX_STRING_LENGTH];
+    char unit[MAX_STRING_LENGTH];
+    char uuid[MAX_STRING_LENGTH];
+    char code[MAX_STRING_LENGTH];
+};
+
+
+// These read little-endian numbers and null terminated strings
+static bool readU8(FILE *in, uint8_t *value)
+{
+    int c = fgetc(in);
+    if (c == EOF) return false;
+    *value = (uint8_t)c;
+    return true;
+}
+static bool readU16(FILE *in, uint16_t *value)
+{
+    uint8_t b[2];
+    if (fread(b, 1, 2, in) != 2) return false;
+    *value = (uint16_t)(b[0] | (b[1] << 8));
+    return true;
+}
+// This checks if a record is only the blank space at the end of a
+// preallocated file, which is either all zeros or all ones
+static bool isBlankRecord(const uint8_t *record, uint16_t recordSize)
+{
+    if (record[0] != 0x00 && record[0] != 0xFF) return false;
+    for (uint16_t i = 1; i < recordSize; i++)
+    {
+        if (record[i] != record[0]) return false;
+    }
+    return true;
+}
+static uint32_t getU32(const uint8_t *b)
+{
+    return (uint32_t)b[0] | ((uint32_t)b[1] << 8) |
+           ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+}
+static bool readString(FILE *in, char *buffer)
+{
+    for (int i = 0; i < MAX_STRING_LENGTH; i++)
+    {
+        int c = fgetc(in);
+        if (c == EOF) return false;
+        buffer[i] = (char)c;
+        if (c == '\0') return true;
+    }
+    // Too long to be something the logger wrote
+    return false;
+}
+
+
+// This prints one header row of the CSV, like the logger's STREAM_CSV_ROW
+static void printCSVRow(const char *firstCol, const variableSchema *vars,
+                        uint8_t nVars, size_t fieldOffset)
+{
+    printf("\"%s\",", firstCol);
+    for (uint8_t i = 0; i < nVars; i++)
+    {
+        const char *field = (const char *)&vars[i] + fieldOffset;
+        printf("\"%s\"", field);
+        if (i + 1 != nVars) printf(",");
+    }
+    printf("\r\n");
+}
+
+
+// This prints a scaled value with the variable's number of decimal places
+static void printScaledValue(int32_t scaled, uint8_t resolution)
+{
+    if (resolution == 0)
+    {
+        printf("%ld", (long)scaled);
+        return;
+    }
+    uint32_t divisor = 1;
+    for (uint8_t r = 0; r < resolution; r++) divisor *= 10;
+    uint32_t magnitude = scaled < 0 ? (uint32_t)(-(int64_t)scaled) : (uint32_t)scaled;
+    printf("%s%lu.%0*lu", scaled < 0 ? "-" : "",
+           (unsigned long)(magnitude / divisor), (int)resolution,
+           (unsigned long)(magnitude % divisor));
+}
+
+
+int main(int argc, char *argv[])
+{
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s binary_log_file > csv_file\n", argv[0]);
+        return 1;
+    }
+    FILE *in = fopen(argv[1], "rb");
+    if (in == NULL)
+    {
+        fprintf(stderr, "Unable to open %s\n", argv[1]);
+        return 1;
+    }
+
+    // Check the magic and the version
+    char magic[4];
+    uint8_t version;
+    if (fread(magic, 1, 4, in) != 4 || memcmp(magic, MS_BINARY_LOG_MAGIC, 4) != 0 ||
+        !readU8(in, &version))
+    {
+        fprintf(stderr, "%s is not a binary log file\n", argv[1]);
+        return 1;
+    }
+    if (version != MS_BINARY_LOG_VERSION)
+    {
+        fprintf(stderr, "Unsupported binary log version %d\n", version);
+        return 1;
+    }
+
+    // Read the rest of the schema
+    uint8_t tzByte, nVars;
+    uint16_t recordSize;
+    static char loggerID[MAX_STRING_LENGTH];
+    static char fileName[MAX_STRING_LENGTH];
+    static char samplingFeature[MAX_STRING_LENGTH];
+    if (!readU8(in, &tzByte) || !readU8(in, &nVars) || !readU16(in, &recordSize) ||
+        !readString(in, loggerID) || !readString(in, fileName) ||
+        !readString(in, samplingFeature))
+    {
+        fprintf(stderr, "The schema in %s is incomplete\n", argv[1]);
+        return 1;
+    }
+    int8_t timeZone = (int8_t)tzByte;
+    uint16_t nStatusBytes = (nVars + 7)/8;
+    if (recordSize != 4 + nStatusBytes + 4*nVars)
+    {
+        fprintf(stderr, "The record size in %s doesn't match its variables\n", argv[1]);
+        return 1;
+    }
+
+    variableSchema *vars = (variableSchema *)calloc(nVars > 0 ? nVars : 1, sizeof(variableSchema));
+    for (uint8_t i = 0; i < nVars; i++)
+    {
+        if (!readU8(in, &vars[i].resolution) ||
+            !readString(in, vars[i].sensorName) || !readString(in, vars[i].varName) ||
+            !readString(in, vars[i].unit) || !readString(in, vars[i].uuid) ||
+            !readString(in, vars[i].code))
+        {
+            fprintf(stderr, "The schema in %s is incomplete\n", argv[1]);
+            return 1;
+        }
+    }
+
+    // Print the same header as Logger::printFileHeader()
+    printf("Data Logger: %s\r\n", loggerID);
+    printf("Data Logger File: %s\r\n", fileName);
+    if (strlen(samplingFeature) > 1)
+    {
+        printf("Sampling Feature UUID: %s,\r\n", samplingFeature);
+    }
+    printCSVRow("Sensor Name:", vars, nVars, offsetof(variableSchema, sensorName));
+    printCSVRow("Variable Name:", vars, nVars, offsetof(variableSchema, varName));
+    printCSVRow("Result Unit:", vars, nVars, offsetof(variableSchema, unit));
+    if (nVars > 0 && strlen(vars[0].uuid) > 1)
+    {
+        printCSVRow("Result UUID:", vars, nVars, offsetof(variableSchema, uuid));
+    }
+    char dtRowHeader[32];
+    if (timeZone > 0) sprintf(dtRowHeader, "Date and Time in UTC+%d", timeZone);
+    else if (timeZone < 0) sprintf(dtRowHeader, "Date and Time in UTC%d", timeZone);
+    else strcpy(dtRowHeader, "Date and Time in UTC");
+    printCSVRow(dtRowHeader, vars, nVars, offsetof(variableSchema, code));
+
+    // Convert each record
+    uint8_t *record = (uint8_t *)malloc(recordSize);
+    unsigned long nRecords = 0;
+    size_t nRead;
+    while ((nRead = fread(record, 1, recordSize, in)) == recordSize)
+    {
+        // The rest of an unfinished preallocated file is blank
+        if (isBlankRecord(record, recordSize))
+        {
+            fprintf(stderr, "Stopped at the blank space at the end of the file\n");
+            nRead = 0;
+            break;
+        }
+
+        // The marked time is already in the logger's time zone
+        time_t epochTime = (time_t)getU32(record);
+        struct tm *dt = gmtime(&epochTime);
+        char timeString[24];
+        strftime(timeString, sizeof(timeString), "%Y-%m-%d %H:%M:%S", dt);
+        printf("%s,", timeString);
+
+        const uint8_t *statusBits = record + 4;
+        const uint8_t *values = statusBits + nStatusBytes;
+        for (uint8_t i = 0; i < nVars; i++)
+        {
+            if (statusBits[i/8] & (1 << (i % 8))) printf("-9999");
+            else printScaledValue((int32_t)getU32(values + 4*i), vars[i].resolution);
+            if (i + 1 != nVars) printf(",");
+        }
+        printf("\r\n");
+        nRecords++;
+    }
+    if (nRead != 0)
+    {
+        fprintf(stderr, "Skipped a partial record of %lu bytes at the end of the file\n",
+                (unsigned long)nRead);
+    }
+    fprintf(stderr, "Converted %lu records\n", nRecords);
+
+    free(record);
+    free(vars);
+    fclose(in);
+    return 0;
+}